@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace Babylon::Benchmarks
+{
+    // Runs a function the given number of times per sample and returns the fastest sample in nanoseconds
+    // per call. The fastest sample is the one least disturbed by the rest of the system.
+    template<typename FunctionT>
+    double Measure(FunctionT&& function, size_t callsPerSample, size_t sampleCount = 7)
+    {
+        std::vector<double> samples{};
+        samples.reserve(sampleCount);
+
+        // Warm the caches and let the clock speed settle before measuring.
+        function();
+
+        for (size_t sample = 0; sample < sampleCount; ++sample)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t call = 0; call < callsPerSample; ++call)
+            {
+                function();
+            }
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / callsPerSample);
+        }
+
+        return *std::min_element(samples.begin(), samples.end());
+    }
+
+    inline void PrintHeader(const char* title)
+    {
+        std::printf("\n%s\n", title);
+    }
+}
@@ -0,0 +1,188 @@
+#include "Benchmark.h"
+
+#include <WorkQueue.h>
+
+#include <arcana/threading/dispatcher.h>
+#include <arcana/threading/task.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace Babylon;
+
+namespace
+{
+    // The number of callables dispatched per throughput sample, split evenly between the producers.
+    constexpr size_t DISPATCH_COUNT{1 << 17};
+    constexpr size_t PRODUCER_COUNTS[]{1, 2, 4, 8};
+
+    // The work queue that the lock-free one replaced, kept here as the baseline. Every append takes a mutex
+    // and chains a continuation onto an arcana task.
+    namespace Baseline
+    {
+        class WorkQueue
+        {
+        public:
+            WorkQueue(std::function<void()> threadProcedure, std::function<void(std::exception_ptr)> unhandledExceptionHandler)
+                : m_thread{std::move(threadProcedure)}
+                , m_unhandledExceptionHandler{std::move(unhandledExceptionHandler)}
+            {
+            }
+
+            ~WorkQueue()
+            {
+                m_cancelSource.cancel();
+                m_dispatcher.cancelled();
+
+                m_thread.join();
+            }
+
+            template<typename CallableT>
+            void Append(CallableT callable)
+            {
+                std::scoped_lock lock{m_appendMutex};
+                m_task = m_task.then(m_dispatcher, m_cancelSource, [this, callable = std::move(callable)]() mutable noexcept {
+                    try
+                    {
+                        callable(m_env.value());
+                    }
+                    catch (...)
+                    {
+                        m_unhandledExceptionHandler(std::current_exception());
+                    }
+                });
+            }
+
+            void Run(Napi::Env env)
+            {
+                m_env = std::make_optional(env);
+                m_dispatcher.set_affinity(std::this_thread::get_id());
+
+                while (!m_cancelSource.cancelled())
+                {
+                    m_dispatcher.blocking_tick(m_cancelSource);
+                }
+
+                m_dispatcher.clear();
+                m_task = arcana::task_from_result<std::error_code>();
+            }
+
+        private:
+            std::optional<Napi::Env> m_env{};
+
+            std::mutex m_appendMutex{};
+
+            arcana::cancellation_source m_cancelSource{};
+            arcana::task<void, std::error_code> m_task = arcana::task_from_result<std::error_code>();
+            arcana::manual_dispatcher<128> m_dispatcher{};
+
+            std::thread m_thread;
+
+            std::function<void(std::exception_ptr)> m_unhandledExceptionHandler;
+        };
+    }
+
+    // Runs a work queue on a thread of its own, like the JavaScript thread of an AppRuntime. The callables
+    // never touch the environment, so there is no JavaScript engine behind it.
+    template<typename QueueT>
+    class QueueHost
+    {
+    public:
+        QueueHost()
+        {
+            std::shared_future<QueueT*> queue{m_queueReady.get_future()};
+            m_queue = std::make_unique<QueueT>([queue] { queue.get()->Run(Napi::Env{nullptr}); }, [](std::exception_ptr) { std::abort(); });
+            m_queueReady.set_value(m_queue.get());
+        }
+
+        QueueT* operator->() const
+        {
+            return m_queue.get();
+        }
+
+    private:
+        std::promise<QueueT*> m_queueReady{};
+        std::unique_ptr<QueueT> m_queue{};
+    };
+
+    // Returns the time per callable for producers that dispatch concurrently until the queue has run all of
+    // their callables.
+    template<typename QueueT>
+    double MeasureThroughput(size_t producerCount)
+    {
+        QueueHost<QueueT> host{};
+        const double nanoseconds = Benchmarks::Measure([&] {
+            // Only touched by the queue thread.
+            size_t remaining{DISPATCH_COUNT};
+            std::promise<void> done{};
+
+            std::vector<std::thread> producers{};
+            for (size_t producer = 0; producer < producerCount; ++producer)
+            {
+                producers.emplace_back([&] {
+                    for (size_t index = 0; index < DISPATCH_COUNT / producerCount; ++index)
+                    {
+                        host->Append([&remaining, &done](Napi::Env) {
+                            if (--remaining == 0)
+                            {
+                                done.set_value();
+                            }
+                        });
+                    }
+                });
+            }
+
+            done.get_future().wait();
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+        }, 1);
+
+        return nanoseconds / DISPATCH_COUNT;
+    }
+
+    // Returns the time from dispatching a callable to an idle queue until it has run.
+    template<typename QueueT>
+    double MeasureLatency()
+    {
+        QueueHost<QueueT> host{};
+        return Benchmarks::Measure([&] {
+            std::atomic<bool> done{false};
+            host->Append([&done](Napi::Env) { done.store(true, std::memory_order_release); });
+            while (!done.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }, 1000);
+    }
+
+    void PrintComparison(const char* name, double baselineNanoseconds, double nanoseconds)
+    {
+        std::printf("  %-24s %9.1f ns | baseline %9.1f ns | %5.2fx\n", name, nanoseconds, baselineNanoseconds, baselineNanoseconds / nanoseconds);
+    }
+}
+
+int main()
+{
+    Benchmarks::PrintHeader("Dispatch to the JavaScript thread, fastest of 7 samples");
+
+    for (const size_t producerCount : PRODUCER_COUNTS)
+    {
+        char name[32]{};
+        std::snprintf(name, sizeof(name), "Throughput, %zu producer%s", producerCount, producerCount == 1 ? "" : "s");
+        PrintComparison(name, MeasureThroughput<Baseline::WorkQueue>(producerCount), MeasureThroughput<WorkQueue>(producerCount));
+    }
+
+    PrintComparison("Latency, idle queue", MeasureLatency<Baseline::WorkQueue>(), MeasureLatency<WorkQueue>());
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "Benchmark.h"
+
+#include <ImageKernels.h>
+
+#include <bx/math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Babylon;
+
+namespace
+{
+    // The image sizes measured: a typical texture and a full HD screenshot.
+    constexpr uint32_t TEXTURE_SIZE{1024};
+    constexpr uint32_t SCREENSHOT_WIDTH{1920};
+    constexpr uint32_t SCREENSHOT_HEIGHT{1080};
+
+    // The loops that the kernels replaced, kept here as the baseline.
+    namespace Baseline
+    {
+        void FlipRows(uint8_t* data, size_t rowPitch, size_t rowCount)
+        {
+            std::vector<uint8_t> buffer(rowPitch);
+            for (size_t row = 0; row < rowCount / 2; row++)
+            {
+                auto frontPtr = data + (row * rowPitch);
+                auto backPtr = data + ((rowCount - row - 1) * rowPitch);
+
+                std::memcpy(buffer.data(), frontPtr, rowPitch);
+                std::memcpy(frontPtr, backPtr, rowPitch);
+                std::memcpy(backPtr, buffer.data(), rowPitch);
+            }
+        }
+
+        void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+        {
+            for (size_t px = 0; px < pixelCount; px++)
+            {
+                *dst++ = src[px * 4 + 2];
+                *dst++ = src[px * 4 + 1];
+                *dst++ = src[px * 4 + 0];
+                *dst++ = src[px * 4 + 3];
+            }
+        }
+
+        // Mip generation used to convert every level to RGBA32F and box filter it in floating point.
+        template<typename LoadT, typename StoreT>
+        void Downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch, size_t pixelSize, LoadT&& load, StoreT&& store)
+        {
+            const uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+            const uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+            for (uint32_t y = 0; y < dstHeight; ++y)
+            {
+                const uint8_t* row0 = src + std::min(y * 2, srcHeight - 1) * srcPitch;
+                const uint8_t* row1 = src + std::min(y * 2 + 1, srcHeight - 1) * srcPitch;
+                for (uint32_t x = 0; x < dstWidth; ++x)
+                {
+                    const size_t x0 = std::min(x * 2, srcWidth - 1) * pixelSize;
+                    const size_t x1 = std::min(x * 2 + 1, srcWidth - 1) * pixelSize;
+                    for (size_t channel = 0; channel < 4; ++channel)
+                    {
+                        const float sum = load(row0 + x0, channel) + load(row0 + x1, channel) + load(row1 + x0, channel) + load(row1 + x1, channel);
+                        store(dst + y * dstPitch + x * pixelSize, channel, sum * 0.25f);
+                    }
+                }
+            }
+        }
+
+        void DownsampleRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            Downsample(src, srcWidth, srcHeight, srcPitch, dst, dstPitch, 4,
+                [](const uint8_t* pixel, size_t channel) { return pixel[channel] / 255.0f; },
+                [](uint8_t* pixel, size_t channel, float value) { pixel[channel] = static_cast<uint8_t>(value * 255.0f + 0.5f); });
+        }
+
+        void DownsampleRgba16F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            Downsample(src, srcWidth, srcHeight, srcPitch, dst, dstPitch, 8,
+                [](const uint8_t* pixel, size_t channel) { return bx::halfToFloat(reinterpret_cast<const uint16_t*>(pixel)[channel]); },
+                [](uint8_t* pixel, size_t channel, float value) { reinterpret_cast<uint16_t*>(pixel)[channel] = bx::halfFromFloat(value); });
+        }
+
+        void DownsampleRgba32F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            Downsample(src, srcWidth, srcHeight, srcPitch, dst, dstPitch, 16,
+                [](const uint8_t* pixel, size_t channel) { return reinterpret_cast<const float*>(pixel)[channel]; },
+                [](uint8_t* pixel, size_t channel, float value) { reinterpret_cast<float*>(pixel)[channel] = value; });
+        }
+    }
+
+    void PrintComparison(const char* name, double baselineNanoseconds, double nanoseconds, double bytesPerCall)
+    {
+        // Bytes per nanosecond are gigabytes per second.
+        std::printf("  %-20s %9.1f us %7.2f GB/s | baseline %9.1f us %7.2f GB/s | %5.2fx\n",
+            name, nanoseconds / 1000, bytesPerCall / nanoseconds, baselineNanoseconds / 1000, bytesPerCall / baselineNanoseconds, baselineNanoseconds / nanoseconds);
+    }
+
+    std::vector<uint8_t> CreateRgba8Image(std::mt19937& random, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> image(size_t{width} * height * 4);
+        for (auto& byte : image)
+        {
+            byte = static_cast<uint8_t>(random());
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> CreateRgba16FImage(std::mt19937& random, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> image(size_t{width} * height * 8);
+        auto* halfs = reinterpret_cast<uint16_t*>(image.data());
+        for (size_t index = 0; index < image.size() / 2; ++index)
+        {
+            halfs[index] = bx::halfFromFloat(static_cast<float>(random() % 4096) / 256.0f);
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> CreateRgba32FImage(std::mt19937& random, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> image(size_t{width} * height * 16);
+        auto* floats = reinterpret_cast<float*>(image.data());
+        for (size_t index = 0; index < image.size() / 4; ++index)
+        {
+            floats[index] = static_cast<float>(random() % 4096) / 256.0f;
+        }
+        return image;
+    }
+
+    void BenchmarkFlipRows(std::mt19937& random)
+    {
+        auto image = CreateRgba8Image(random, TEXTURE_SIZE, TEXTURE_SIZE);
+        const size_t rowPitch = TEXTURE_SIZE * 4;
+
+        const double baseline = Benchmarks::Measure([&] { Baseline::FlipRows(image.data(), rowPitch, TEXTURE_SIZE); }, 20);
+        const double kernel = Benchmarks::Measure([&] { ImageKernels::FlipRows(image.data(), rowPitch, TEXTURE_SIZE); }, 20);
+        PrintComparison("FlipRows RGBA8", baseline, kernel, static_cast<double>(image.size()));
+    }
+
+    void BenchmarkSwapRedBlue(std::mt19937& random)
+    {
+        const auto image = CreateRgba8Image(random, SCREENSHOT_WIDTH, SCREENSHOT_HEIGHT);
+        std::vector<uint8_t> baselineOutput(image.size());
+        std::vector<uint8_t> kernelOutput(image.size());
+        const size_t pixelCount = size_t{SCREENSHOT_WIDTH} * SCREENSHOT_HEIGHT;
+
+        const double baseline = Benchmarks::Measure([&] { Baseline::SwapRedBlue(image.data(), baselineOutput.data(), pixelCount); }, 20);
+        const double kernel = Benchmarks::Measure([&] { ImageKernels::SwapRedBlue(image.data(), kernelOutput.data(), pixelCount); }, 20);
+        PrintComparison("SwapRedBlue BGRA8", baseline, kernel, static_cast<double>(image.size()));
+
+        if (baselineOutput != kernelOutput)
+        {
+            std::printf("  SwapRedBlue output differs from the baseline.\n");
+        }
+    }
+
+    void BenchmarkDownsample(const char* name, const std::vector<uint8_t>& image, size_t pixelSize, ImageKernels::DownsampleFunction baselineFunction, ImageKernels::DownsampleFunction kernelFunction)
+    {
+        const size_t srcPitch = TEXTURE_SIZE * pixelSize;
+        const size_t dstPitch = TEXTURE_SIZE / 2 * pixelSize;
+        std::vector<uint8_t> output(image.size() / 4);
+
+        const double baseline = Benchmarks::Measure([&] { baselineFunction(image.data(), TEXTURE_SIZE, TEXTURE_SIZE, srcPitch, output.data(), dstPitch); }, 10);
+        const double kernel = Benchmarks::Measure([&] { kernelFunction(image.data(), TEXTURE_SIZE, TEXTURE_SIZE, srcPitch, output.data(), dstPitch); }, 10);
+        PrintComparison(name, baseline, kernel, static_cast<double>(image.size()));
+    }
+}
+
+int main()
+{
+    std::mt19937 random{1};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    Benchmarks::PrintHeader("Image kernels (SSE2), fastest of 7 samples");
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    Benchmarks::PrintHeader("Image kernels (NEON), fastest of 7 samples");
+#else
+    Benchmarks::PrintHeader("Image kernels (scalar), fastest of 7 samples");
+#endif
+
+    BenchmarkFlipRows(random);
+    BenchmarkSwapRedBlue(random);
+    BenchmarkDownsample("DownsampleRgba8", CreateRgba8Image(random, TEXTURE_SIZE, TEXTURE_SIZE), 4, Baseline::DownsampleRgba8, ImageKernels::DownsampleRgba8);
+    BenchmarkDownsample("DownsampleRgba16F", CreateRgba16FImage(random, TEXTURE_SIZE, TEXTURE_SIZE), 8, Baseline::DownsampleRgba16F, ImageKernels::DownsampleRgba16F);
+    BenchmarkDownsample("DownsampleRgba32F", CreateRgba32FImage(random, TEXTURE_SIZE, TEXTURE_SIZE), 16, Baseline::DownsampleRgba32F, ImageKernels::DownsampleRgba32F);
+
+    return 0;
+}
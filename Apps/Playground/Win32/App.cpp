@@ -16,6 +16,7 @@
 #include <Babylon/Plugins/NativeXr.h>
 #include <Babylon/Polyfills/Console.h>
 #include <Babylon/Polyfills/Window.h>
+#include <Babylon/Polyfills/Worker.h>
 #include <Babylon/Polyfills/XMLHttpRequest.h>
 
 #define MAX_LOADSTRING 100
@@ -112,6 +113,15 @@ namespace
             Babylon::Polyfills::Window::Initialize(env);
             Babylon::Polyfills::XMLHttpRequest::Initialize(env);
 
+            // Workers get the polyfills but no graphics.
+            Babylon::Polyfills::Worker::Initialize(env, [](Napi::Env workerEnv) {
+                Babylon::Polyfills::Console::Initialize(workerEnv, [](const char* message, auto) {
+                    OutputDebugStringA(message);
+                });
+                Babylon::Polyfills::Window::Initialize(workerEnv);
+                Babylon::Polyfills::XMLHttpRequest::Initialize(workerEnv);
+            });
+
             // Initialize NativeEngine plugin.
             graphics->AddToJavaScript(env);
             Babylon::Plugins::NativeEngine::Initialize(env, RENDER_ON_JS_THREAD);
@@ -302,7 +312,10 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             {
                 if (graphics != nullptr)
                 {
+                    // Lets the JavaScript thread run idle callbacks between frames rather than during them.
+                    runtime->StartFrame();
                     graphics->RenderCurrentFrame();
+                    runtime->FinishFrame();
                 }
             }
 
@@ -0,0 +1,42 @@
+var engine = new BABYLON.NativeEngine();
+var scene = new BABYLON.Scene(engine);
+
+// Each frame of the render loop requests the next one right away. The request and timer below must still
+// complete while it runs, since the work queue lets lower lanes run after every frame callback.
+var maxWaitTime = 5000;
+var start = Date.now();
+var requestDone = false;
+var timerDone = false;
+
+var camera = new BABYLON.FreeCamera("camera", new BABYLON.Vector3(0, 2, -5), scene);
+camera.setTarget(BABYLON.Vector3.Zero());
+scene.createDefaultLight(true);
+BABYLON.Mesh.CreateBox("box", 1);
+
+function finish(message) {
+    engine.stopRenderLoop();
+    console.log(message);
+}
+
+engine.runRenderLoop(function () {
+    scene.render();
+
+    if (requestDone && timerDone) {
+        finish("PASS: the request and the timer completed in " + (Date.now() - start) + " ms while frames were rendered.");
+    } else if (Date.now() - start > maxWaitTime) {
+        finish("FAIL: " + (requestDone ? "the timer" : "the request") + " did not complete while frames were rendered.");
+    }
+});
+
+var xhr = new XMLHttpRequest();
+xhr.open("GET", "https://raw.githubusercontent.com/KhronosGroup/glTF-Sample-Models/master/2.0/Box/glTF/Box.gltf", true);
+xhr.addEventListener("readystatechange", function () {
+    if (xhr.readyState === 4) {
+        requestDone = true;
+    }
+});
+xhr.send();
+
+setTimeout(function () {
+    timerDone = true;
+}, 100);
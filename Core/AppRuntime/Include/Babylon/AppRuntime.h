@@ -2,6 +2,7 @@
 
 #include <Babylon/JsRuntime.h>
 
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <exception>
@@ -21,6 +22,16 @@ namespace Babylon
         void Resume();
 
         void Dispatch(std::function<void(Napi::Env)> callback);
+        void Dispatch(JsRuntime::DispatchPriority priority, std::function<void(Napi::Env)> callback);
+
+        // Time per frame that I/O and idle work may take on the JavaScript thread before the rest of it
+        // is deferred until after the next frame callback. Zero, the default, disables the budget.
+        void SetFrameBudget(std::chrono::microseconds budget);
+
+        // Signal the start and end of rendering a frame, from any thread. Idle callbacks only run between
+        // frames, with the time left until the next frame is expected to start.
+        void StartFrame();
+        void FinishFrame();
 
     private:
         // These three methods are the mechanism by which platform- and JavaScript-specific
@@ -12,7 +12,12 @@ namespace Babylon
         : m_workQueue{std::make_unique<WorkQueue>([this] { RunPlatformTier(); }, unhandledExceptionHandler)}
     {
         Dispatch([this](Napi::Env env) {
-            JsRuntime::CreateForJavaScript(env, [this](auto func) { m_workQueue->Append(std::move(func)); });
+            JsRuntime::CreateForJavaScript(
+                env,
+                [this](auto func) { m_workQueue->Append(std::move(func)); },
+                [this](auto deadline, auto func) { m_workQueue->AppendAt(deadline, std::move(func)); },
+                [this](auto priority, auto func) { m_workQueue->Append(priority, std::move(func)); },
+                [this] { return m_workQueue->GetIdleDeadline(); });
         });
     }
 
@@ -39,4 +44,24 @@ namespace Babylon
     {
         m_workQueue->Append(std::move(func));
     }
+
+    void AppRuntime::Dispatch(JsRuntime::DispatchPriority priority, std::function<void(Napi::Env)> func)
+    {
+        m_workQueue->Append(priority, std::move(func));
+    }
+
+    void AppRuntime::SetFrameBudget(std::chrono::microseconds budget)
+    {
+        m_workQueue->SetFrameBudget(budget);
+    }
+
+    void AppRuntime::StartFrame()
+    {
+        m_workQueue->StartFrame();
+    }
+
+    void AppRuntime::FinishFrame()
+    {
+        m_workQueue->FinishFrame();
+    }
 }
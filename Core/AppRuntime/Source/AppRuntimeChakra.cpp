@@ -1,4 +1,5 @@
 #include "AppRuntime.h"
+#include "WorkQueue.h"
 
 #include <jsrt.h>
 
@@ -23,7 +24,7 @@ namespace Babylon
         using DispatchFunction = std::function<void(std::function<void()>)>;
         DispatchFunction dispatchFunction{
             [this](std::function<void()> action) {
-                Dispatch([action = std::move(action)](Napi::Env) {
+                m_workQueue->AppendMicrotask([action = std::move(action)](Napi::Env) {
                     action();
                 });
             }};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace Babylon
+{
+    /// Unbounded lock-free queue that any number of threads push to and a single thread pops from. A push
+    /// is one atomic exchange and a pop needs no read-modify-write at all. Nodes are recycled through a pool
+    /// shared by every queue of the same type, so a steady flow of values allocates no nodes.
+    template<typename T>
+    class MultiProducerQueue final
+    {
+    public:
+        MultiProducerQueue()
+            : m_tail{NodePool::Acquire()}
+        {
+            m_head = m_tail;
+        }
+
+        // Values still queued are destroyed on the calling thread.
+        ~MultiProducerQueue()
+        {
+            while (Pop().has_value())
+            {
+            }
+            NodePool::Release(m_tail);
+        }
+
+        MultiProducerQueue(const MultiProducerQueue&) = delete;
+        MultiProducerQueue& operator=(const MultiProducerQueue&) = delete;
+
+        // Can be called from any thread.
+        void Push(T value)
+        {
+            Node* node = NodePool::Acquire();
+            node->Value.emplace(std::move(value));
+
+            // The node is only reachable by the consumer once linked to its predecessor, so between these
+            // two steps the queue is not empty and yet Pop returns nothing.
+            Node* previous = m_head.exchange(node);
+            previous->Next.store(node, std::memory_order_release);
+        }
+
+        // Must only be called from the consuming thread.
+        std::optional<T> Pop()
+        {
+            // The tail is a node whose value has already been popped. Its successor holds the next value and
+            // becomes the new tail.
+            Node* next = m_tail->Next.load(std::memory_order_acquire);
+            if (next == nullptr)
+            {
+                return std::nullopt;
+            }
+
+            std::optional<T> value{std::move(next->Value)};
+            next->Value.reset();
+
+            NodePool::Release(m_tail);
+            m_tail = next;
+            return value;
+        }
+
+        // True once every value pushed so far has been popped. Must only be called from the consuming thread.
+        // Sequentially consistent with Push, so a consumer that announces it is going to sleep and then finds
+        // the queue empty is guaranteed to be seen by any producer that pushes after that.
+        bool IsEmpty() const
+        {
+            return m_head.load() == m_tail;
+        }
+
+    private:
+        struct Node
+        {
+            std::atomic<Node*> Next{nullptr};
+            std::optional<T> Value{};
+        };
+
+        // Released nodes are pushed onto a shared lock-free stack. Taking single nodes off such a stack is
+        // prone to the ABA problem, so a thread that runs out of nodes takes the whole stack at once into a
+        // cache of its own instead.
+        class NodePool final
+        {
+        public:
+            // Returns a node without a successor. A pooled node is still linked to the rest of the pool.
+            static Node* Acquire()
+            {
+                Cache& cache = s_cache;
+                if (cache.Nodes == nullptr)
+                {
+                    cache.Nodes = s_released.Nodes.exchange(nullptr, std::memory_order_acquire);
+                    s_released.Count.store(0, std::memory_order_relaxed);
+                }
+
+                Node* node = cache.Nodes;
+                if (node == nullptr)
+                {
+                    return new Node{};
+                }
+
+                cache.Nodes = node->Next.load(std::memory_order_relaxed);
+                node->Next.store(nullptr, std::memory_order_relaxed);
+                return node;
+            }
+
+            static void Release(Node* node)
+            {
+                // The count is approximate, it only keeps a burst of values from being pooled forever.
+                if (s_released.Count.fetch_add(1, std::memory_order_relaxed) >= MAX_POOLED_NODES)
+                {
+                    delete node;
+                    return;
+                }
+
+                Node* top = s_released.Nodes.load(std::memory_order_relaxed);
+                do
+                {
+                    node->Next.store(top, std::memory_order_relaxed);
+                } while (!s_released.Nodes.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+        private:
+            static constexpr size_t MAX_POOLED_NODES{1024};
+
+            struct Stack
+            {
+                std::atomic<Node*> Nodes{nullptr};
+                std::atomic<size_t> Count{0};
+
+                ~Stack()
+                {
+                    Delete(Nodes.load());
+                }
+            };
+
+            struct Cache
+            {
+                Node* Nodes{nullptr};
+
+                ~Cache()
+                {
+                    Delete(Nodes);
+                }
+            };
+
+            static void Delete(Node* nodes)
+            {
+                while (nodes != nullptr)
+                {
+                    delete std::exchange(nodes, nodes->Next.load(std::memory_order_relaxed));
+                }
+            }
+
+            static inline Stack s_released{};
+            static inline thread_local Cache s_cache{};
+        };
+
+        std::atomic<Node*> m_head{};
+        Node* m_tail{};
+    };
+}
@@ -1,7 +1,22 @@
 #include "WorkQueue.h"
 
+#include <algorithm>
+
 namespace Babylon
 {
+    namespace
+    {
+        // Makes the timer heap a min-heap, with the earliest deadline at the front.
+        struct LaterTimer
+        {
+            template<typename TimerT>
+            bool operator()(const TimerT& a, const TimerT& b) const
+            {
+                return a.Deadline != b.Deadline ? a.Deadline > b.Deadline : a.Sequence > b.Sequence;
+            }
+        };
+    }
+
     WorkQueue::WorkQueue(std::function<void()> threadProcedure, std::function<void(std::exception_ptr)> unhandledExceptionHandler)
         : m_thread{std::move(threadProcedure)}
         , m_unhandledExceptionHandler{std::move(unhandledExceptionHandler)}
@@ -16,16 +31,80 @@ namespace Babylon
         }
 
         m_cancelSource.cancel();
-        m_dispatcher.cancelled();
+        {
+            std::scoped_lock lock{m_waitMutex};
+        }
+        m_waitCondition.notify_all();
 
         m_thread.join();
     }
 
+    void WorkQueue::SetFrameBudget(std::chrono::microseconds budget)
+    {
+        m_frameBudgetMicroseconds = budget.count();
+        NotifyAppended();
+    }
+
+    void WorkQueue::AppendMicrotask(std::function<void(Napi::Env)> callable)
+    {
+        m_microtasks.push_back(std::move(callable));
+    }
+
+    void WorkQueue::StartFrame()
+    {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        const auto previous = m_frameStart.exchange(now);
+
+        // The expected frame interval follows the measured one, ignoring pauses in rendering.
+        const std::chrono::steady_clock::duration interval{now - previous};
+        if (previous != 0 && interval < MAX_FRAME_WINDOW)
+        {
+            m_frameInterval = (3 * m_frameInterval.load() + interval.count()) / 4;
+        }
+
+        m_inFrame = true;
+    }
+
+    void WorkQueue::FinishFrame()
+    {
+        m_inFrame = false;
+        NotifyAppended();
+    }
+
+    std::chrono::steady_clock::time_point WorkQueue::GetIdleDeadline() const
+    {
+        // Inside a frame there is no idle time, the deadline passed when the frame started.
+        const auto frameStart = m_frameStart.load();
+        if (m_inFrame)
+        {
+            return std::chrono::steady_clock::time_point{std::chrono::steady_clock::duration{frameStart}};
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        auto deadline = now + MAX_IDLE_PERIOD;
+
+        // The host is only assumed to have stopped rendering once no frame has started for a whole frame
+        // window. Until then, a late frame leaves no idle time at all.
+        const std::chrono::steady_clock::time_point lastFrame{std::chrono::steady_clock::duration{frameStart}};
+        if (frameStart != 0 && now - lastFrame < MAX_FRAME_WINDOW)
+        {
+            deadline = std::min(deadline, lastFrame + std::chrono::steady_clock::duration{m_frameInterval.load()});
+        }
+
+        if (!m_timers.empty())
+        {
+            deadline = std::min(deadline, m_timers.front().Deadline);
+        }
+
+        return deadline;
+    }
+
     void WorkQueue::Suspend()
     {
-        auto suspensionMutex = std::make_unique<std::mutex>();
+        auto suspensionMutex = std::make_shared<std::mutex>();
         m_suspensionLock.emplace(*suspensionMutex);
-        Append([suspensionMutex{std::move(suspensionMutex)}](Napi::Env) mutable {
+        // Input work is never deferred, so the JavaScript thread suspends as soon as possible.
+        Append(JsRuntime::DispatchPriority::Input, [suspensionMutex{std::move(suspensionMutex)}](Napi::Env) {
             std::scoped_lock lock{*suspensionMutex};
         });
     }
@@ -38,14 +117,250 @@ namespace Babylon
     void WorkQueue::Run(Napi::Env env)
     {
         m_env = std::make_optional(env);
-        m_dispatcher.set_affinity(std::this_thread::get_id());
 
         while (!m_cancelSource.cancelled())
         {
-            m_dispatcher.blocking_tick(m_cancelSource);
+            RunDueTimers();
+
+            for (size_t count = 0; count < MAX_BATCH_SIZE && !m_cancelSource.cancelled(); ++count)
+            {
+                auto work = PopNext();
+                if (!work.has_value())
+                {
+                    break;
+                }
+
+                RunWork(*work);
+            }
+
+            Wait();
+        }
+
+        // Work that never ran is destroyed on this thread, as it may hold references to JavaScript objects.
+        for (auto& lane : m_lanes)
+        {
+            while (lane.Pop().has_value())
+            {
+            }
+        }
+        m_microtasks.clear();
+        m_timers.clear();
+    }
+
+    void WorkQueue::AddTimer(std::chrono::steady_clock::time_point deadline, std::function<void(Napi::Env)> callable)
+    {
+        m_timers.push_back({deadline, m_nextTimerSequence++, std::move(callable)});
+        std::push_heap(m_timers.begin(), m_timers.end(), LaterTimer{});
+    }
+
+    void WorkQueue::RunDueTimers()
+    {
+        // Timers added while these run go through the queue first, so this always terminates.
+        const auto now = std::chrono::steady_clock::now();
+        while (!m_timers.empty() && m_timers.front().Deadline <= now && !m_cancelSource.cancelled())
+        {
+            std::pop_heap(m_timers.begin(), m_timers.end(), LaterTimer{});
+            auto callable = std::move(m_timers.back().Callable);
+            m_timers.pop_back();
+
+            Invoke(callable);
+        }
+    }
+
+    std::optional<WorkQueue::Work> WorkQueue::PopNext()
+    {
+        // After a frame callback, the lower lanes run until they are empty or the frame budget is used up.
+        const bool frameLaneYields = m_frameLaneYieldEnd != std::chrono::steady_clock::time_point{} && std::chrono::steady_clock::now() < m_frameLaneYieldEnd;
+
+        // Lanes are drained highest priority first, so any frame callback or input appended meanwhile
+        // runs before the next piece of lower priority work.
+        for (size_t lane = 0; lane < m_lanes.size(); ++lane)
+        {
+            const auto priority = static_cast<JsRuntime::DispatchPriority>(lane);
+            if ((frameLaneYields && priority == JsRuntime::DispatchPriority::Frame) || IsDeferred(priority))
+            {
+                continue;
+            }
+
+            auto callable = m_lanes[lane].Pop();
+            if (callable.has_value())
+            {
+                return Work{priority, std::move(*callable)};
+            }
+        }
+
+        if (frameLaneYields)
+        {
+            m_frameLaneYieldEnd = {};
+            return PopNext();
+        }
+
+        return std::nullopt;
+    }
+
+    void WorkQueue::RunWork(Work& work)
+    {
+        if (work.Priority == JsRuntime::DispatchPriority::Frame)
+        {
+            // A frame callback opens the window for the work deferred until after the frame.
+            m_frameWindowStart = std::chrono::steady_clock::now();
+            m_frameWindowTime = {};
+            Invoke(work.Callable);
+
+            // Without a budget, the lower lanes may run unbounded, as between frames.
+            const std::chrono::microseconds budget{m_frameBudgetMicroseconds.load()};
+            m_frameLaneYieldEnd = budget.count() == 0 ? std::chrono::steady_clock::time_point::max() : std::chrono::steady_clock::now() + budget;
+        }
+        else if (work.Priority >= JsRuntime::DispatchPriority::IO && m_frameBudgetMicroseconds != 0)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            if (start - m_frameWindowStart >= MAX_FRAME_WINDOW)
+            {
+                m_frameWindowStart = start;
+                m_frameWindowTime = {};
+            }
+
+            Invoke(work.Callable);
+            m_frameWindowTime += std::chrono::steady_clock::now() - start;
+        }
+        else
+        {
+            Invoke(work.Callable);
+        }
+    }
+
+    bool WorkQueue::IsDeferred(JsRuntime::DispatchPriority priority) const
+    {
+        if (priority < JsRuntime::DispatchPriority::IO)
+        {
+            return false;
+        }
+
+        if (GetDeferralEnd().has_value())
+        {
+            return true;
+        }
+
+        if (priority != JsRuntime::DispatchPriority::Idle)
+        {
+            return false;
         }
 
-        m_dispatcher.clear();
-        m_task = arcana::task_from_result<std::error_code>();
+        const auto now = std::chrono::steady_clock::now();
+        return GetIdleDeadline() <= now;
+    }
+
+    bool WorkQueue::HasRunnableWork() const
+    {
+        for (size_t lane = 0; lane < m_lanes.size(); ++lane)
+        {
+            if (!m_lanes[lane].IsEmpty() && !IsDeferred(static_cast<JsRuntime::DispatchPriority>(lane)))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> WorkQueue::GetDeferralEnd() const
+    {
+        const std::chrono::microseconds budget{m_frameBudgetMicroseconds.load()};
+        if (budget.count() == 0 || m_frameWindowTime < budget)
+        {
+            return std::nullopt;
+        }
+
+        const auto end = m_frameWindowStart + MAX_FRAME_WINDOW;
+        if (std::chrono::steady_clock::now() >= end)
+        {
+            return std::nullopt;
+        }
+
+        return end;
+    }
+
+    void WorkQueue::Invoke(std::function<void(Napi::Env)>& callable)
+    {
+        try
+        {
+            callable(m_env.value());
+        }
+        catch (...)
+        {
+            m_unhandledExceptionHandler(std::current_exception());
+        }
+
+        InvokeMicrotasks();
+    }
+
+    void WorkQueue::InvokeMicrotasks()
+    {
+        // Microtasks may append more microtasks, which run in the same drain.
+        while (!m_microtasks.empty())
+        {
+            auto microtask = std::move(m_microtasks.front());
+            m_microtasks.pop_front();
+
+            try
+            {
+                microtask(m_env.value());
+            }
+            catch (...)
+            {
+                m_unhandledExceptionHandler(std::current_exception());
+            }
+        }
+    }
+
+    void WorkQueue::NotifyAppended()
+    {
+        if (m_waiting)
+        {
+            // Taking the mutex orders the append before the JavaScript thread checks for work under it. The
+            // notification comes after releasing it, so that the woken thread does not block on it again.
+            {
+                std::scoped_lock lock{m_waitMutex};
+            }
+            m_waitCondition.notify_one();
+        }
+    }
+
+    void WorkQueue::Wait()
+    {
+        if (HasRunnableWork())
+        {
+            // Either more work is ready or a producer is halfway through appending it.
+            std::this_thread::yield();
+            return;
+        }
+
+        // Sleeps until more work is appended, the earliest timer is due or deferred work may run again.
+        std::unique_lock lock{m_waitMutex};
+        m_waiting = true;
+        const auto ready = [this] { return HasRunnableWork() || m_cancelSource.cancelled(); };
+        std::optional<std::chrono::steady_clock::time_point> deadline{GetDeferralEnd()};
+        if (!m_timers.empty())
+        {
+            deadline = deadline.has_value() ? std::min(*deadline, m_timers.front().Deadline) : m_timers.front().Deadline;
+        }
+
+        // Idle work held back by a late frame runs once no frame has started for a whole frame window.
+        const auto frameStart = m_frameStart.load();
+        if (!m_inFrame && frameStart != 0 && !m_lanes[static_cast<size_t>(JsRuntime::DispatchPriority::Idle)].IsEmpty())
+        {
+            const auto renderingStopped = std::chrono::steady_clock::time_point{std::chrono::steady_clock::duration{frameStart}} + MAX_FRAME_WINDOW;
+            deadline = deadline.has_value() ? std::min(*deadline, renderingStopped) : renderingStopped;
+        }
+
+        if (deadline.has_value())
+        {
+            m_waitCondition.wait_until(lock, *deadline, ready);
+        }
+        else
+        {
+            m_waitCondition.wait(lock, ready);
+        }
+        m_waiting = false;
     }
 }
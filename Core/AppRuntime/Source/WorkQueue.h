@@ -1,12 +1,23 @@
 #pragma once
 
-#include <arcana/threading/dispatcher.h>
-#include <arcana/threading/task.h>
+#include "MultiProducerQueue.h"
+
+#include <Babylon/JsRuntime.h>
+
+#include <arcana/threading/cancellation.h>
 #include <napi/env.h>
 
-#include <future>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 namespace Babylon
 {
@@ -19,33 +30,124 @@ namespace Babylon
         template<typename CallableT>
         void Append(CallableT callable)
         {
-            std::scoped_lock lock{m_appendMutex};
-            m_task = m_task.then(m_dispatcher, m_cancelSource, [this, callable = std::move(callable)]() mutable noexcept {
-                try
-                {
-                    callable(m_env.value());
-                }
-                catch (...)
-                {
-                    m_unhandledExceptionHandler(std::current_exception());
-                }
+            Append(JsRuntime::DispatchPriority::IO, std::move(callable));
+        }
+
+        template<typename CallableT>
+        void Append(JsRuntime::DispatchPriority priority, CallableT callable)
+        {
+            m_lanes[static_cast<size_t>(priority)].Push(std::move(callable));
+            NotifyAppended();
+        }
+
+        // Runs the callable once the deadline has passed. Timers are kept in a heap that only the JavaScript
+        // thread touches, so the callable is handed over to it through the queue like any other work.
+        template<typename CallableT>
+        void AppendAt(std::chrono::steady_clock::time_point deadline, CallableT callable)
+        {
+            Append(JsRuntime::DispatchPriority::Input, [this, deadline, callable = std::move(callable)](Napi::Env) mutable {
+                AddTimer(deadline, std::move(callable));
             });
         }
 
+        // Limits the time that I/O and idle work may take on the JavaScript thread between two frame
+        // callbacks. Once it is used up, that work waits for the next frame callback to have run, so that
+        // a burst of it cannot delay the frame. It also bounds how long the next frame callback waits for
+        // the other lanes after a frame callback. Zero, the default, lets it run unbounded.
+        void SetFrameBudget(std::chrono::microseconds budget);
+
+        // Runs the callable right after the work currently running, ahead of any other work, as promise
+        // continuations run in browsers. Must only be called from the JavaScript thread.
+        void AppendMicrotask(std::function<void(Napi::Env)> callable);
+
+        // Called by the host around rendering each frame. Idle work only runs outside of frames and is
+        // given the time left until the next frame is expected to start.
+        void StartFrame();
+        void FinishFrame();
+
+        // The time until which idle work may run without delaying the next frame or timer, which has already
+        // passed while the next frame is late. Must only be called from the JavaScript thread.
+        std::chrono::steady_clock::time_point GetIdleDeadline() const;
+
         void Suspend();
         void Resume();
         void Run(Napi::Env);
 
     private:
-        std::optional<Napi::Env> m_env{};
+        // Work runs in batches of at most this many callables between checks for cancellation.
+        static constexpr size_t MAX_BATCH_SIZE{64};
+
+        // Deferred work runs again after this long even if no frame callback came, for instance while
+        // nothing is being rendered.
+        static constexpr std::chrono::milliseconds MAX_FRAME_WINDOW{100};
 
-        std::mutex m_appendMutex{};
+        // Idle work is given at most this long at once, which bounds how late it can make input that
+        // arrives meanwhile, as in browsers.
+        static constexpr std::chrono::milliseconds MAX_IDLE_PERIOD{50};
+
+        static constexpr size_t LANE_COUNT{static_cast<size_t>(JsRuntime::DispatchPriority::Idle) + 1};
+
+        struct Timer
+        {
+            std::chrono::steady_clock::time_point Deadline{};
+            // Orders timers with the same deadline by the time they were added.
+            uint64_t Sequence{};
+            std::function<void(Napi::Env)> Callable{};
+        };
+
+        struct Work
+        {
+            JsRuntime::DispatchPriority Priority{};
+            std::function<void(Napi::Env)> Callable{};
+        };
+
+        void NotifyAppended();
+        void Wait();
+
+        std::optional<Work> PopNext();
+        void RunWork(Work& work);
+        bool IsDeferred(JsRuntime::DispatchPriority priority) const;
+        bool HasRunnableWork() const;
+        std::optional<std::chrono::steady_clock::time_point> GetDeferralEnd() const;
+
+        void AddTimer(std::chrono::steady_clock::time_point deadline, std::function<void(Napi::Env)> callable);
+        void RunDueTimers();
+        void Invoke(std::function<void(Napi::Env)>& callable);
+        void InvokeMicrotasks();
+
+        std::optional<Napi::Env> m_env{};
 
         std::optional<std::scoped_lock<std::mutex>> m_suspensionLock{};
 
         arcana::cancellation_source m_cancelSource{};
-        arcana::task<void, std::error_code> m_task = arcana::task_from_result<std::error_code>();
-        arcana::manual_dispatcher<128> m_dispatcher{};
+        // One queue per priority, indexed by JsRuntime::DispatchPriority.
+        std::array<MultiProducerQueue<std::function<void(Napi::Env)>>, LANE_COUNT> m_lanes{};
+
+        // The frame budget is set from any thread, the rest is only accessed from the JavaScript thread.
+        std::atomic<int64_t> m_frameBudgetMicroseconds{0};
+        std::chrono::steady_clock::time_point m_frameWindowStart{};
+        std::chrono::steady_clock::duration m_frameWindowTime{};
+        // Until then, frame work waits for the lanes below it, so that a frame callback that requests the
+        // next frame right away cannot starve them.
+        std::chrono::steady_clock::time_point m_frameLaneYieldEnd{};
+
+        // Only accessed from the JavaScript thread.
+        std::deque<std::function<void(Napi::Env)>> m_microtasks{};
+
+        // Set by the host around frames, as counts of steady clock ticks. A zero start means no frame has
+        // started yet.
+        std::atomic<bool> m_inFrame{false};
+        std::atomic<std::chrono::steady_clock::rep> m_frameStart{0};
+        std::atomic<std::chrono::steady_clock::rep> m_frameInterval{std::chrono::steady_clock::duration{std::chrono::microseconds{16667}}.count()};
+
+        // A min-heap on the deadline, only accessed from the JavaScript thread.
+        std::vector<Timer> m_timers{};
+        uint64_t m_nextTimerSequence{0};
+
+        // Appending only takes the mutex to wake the JavaScript thread while it waits for work.
+        std::atomic<bool> m_waiting{false};
+        std::mutex m_waitMutex{};
+        std::condition_variable m_waitCondition{};
 
         std::thread m_thread;
 
@@ -2,7 +2,10 @@
 
 #include <Babylon/JsRuntime.h>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace Babylon
 {
@@ -11,6 +14,55 @@ namespace Babylon
     public:
         class Impl;
 
+        // Renderers that need no window, for rendering on machines without a display or a GPU.
+        enum class HeadlessRenderer
+        {
+            // Runs the whole pipeline without rendering anything, e.g. to validate or profile scripts.
+            Noop,
+            // Renders with whichever OpenGL implementation the process loads, which can be a software one
+            // such as Mesa's llvmpipe.
+            OpenGL,
+        };
+
+        // Receives the RGBA8 pixels of each rendered frame, tightly packed and top row first. Called on the
+        // render thread; the pixels are only valid for the duration of the call.
+        using FrameCallback = std::function<void(const uint8_t* pixels, size_t width, size_t height)>;
+
+        // Passed to CreateGraphics instead of a native window to render into an offscreen frame buffer.
+        struct HeadlessConfiguration
+        {
+            size_t Width{};
+            size_t Height{};
+            HeadlessRenderer Renderer{HeadlessRenderer::OpenGL};
+            // Optional. Frames are only read back when set, and never with the Noop renderer.
+            FrameCallback OnFrame{};
+        };
+
+        // Timings and resource usage of a rendered frame. The GPU timings and the counters come from bgfx and
+        // describe the most recent frame the renderer is done with, which can lag a frame or two behind.
+        struct FrameStatistics
+        {
+            struct ViewStatistics
+            {
+                uint16_t ViewId{};
+                double GpuMilliseconds{};
+            };
+
+            uint64_t FrameNumber{};
+            // Time the JavaScript thread spent in the frame's animation frame callbacks.
+            double ScriptMilliseconds{};
+            // Time spent in FinishRenderingCurrentFrame, waiting for the frame's work and submitting it.
+            double FinishMilliseconds{};
+            double GpuMilliseconds{};
+            std::vector<ViewStatistics> Views{};
+            uint32_t DrawCalls{};
+            uint32_t Primitives{};
+            int64_t TextureMemory{};
+            int64_t RenderTargetMemory{};
+            uint32_t TransientBufferMemory{};
+            uint32_t BufferCount{};
+        };
+
         ~Graphics();
 
         template<typename... Ts>
@@ -22,6 +74,10 @@ namespace Babylon
 
         void AddToJavaScript(Napi::Env);
 
+        // Lets the next frame be recorded while bgfx submits the current one from a render thread of its own.
+        // Must be called before rendering is enabled, in a build with BABYLON_NATIVE_FRAME_PIPELINING.
+        void EnableFramePipelining();
+
         void EnableRendering();
         void DisableRendering();
 
@@ -36,6 +92,13 @@ namespace Babylon
 
         void SetDiagnosticOutput(std::function<void(const char* output)> outputFunction);
 
+        // Keeps the statistics of the last frameCount frames. Zero, the default, stops collecting them, which
+        // also turns off the bgfx profiler that times views on the GPU.
+        void SetFrameStatisticsCapacity(size_t frameCount);
+
+        // The collected frame statistics, oldest first.
+        std::vector<FrameStatistics> GetFrameStatistics();
+
     private:
         Graphics();
 
@@ -1,4 +1,5 @@
 #include "BgfxCallback.h"
+#include "ImageKernels.h"
 #include <bx/bx.h>
 #include <bx/string.h>
 #include <bx/platform.h>
@@ -7,12 +8,14 @@
 #include <bgfx/bgfx.h>
 #include <Babylon/JsRuntime.h>
 #include <assert.h>
+#include <cstring>
 
 namespace Babylon
 {
     void BgfxCallback::addScreenShotCallback(Napi::Function callback)
     {
         std::scoped_lock lock{ m_ssCallbackAccess };
+        m_screenshotRuntime = &JsRuntime::GetFromJavaScript(callback.Env());
         m_screenshotCallbacks.push(Napi::Persistent(callback));
     }
 
@@ -96,27 +99,30 @@ namespace Babylon
 
     void BgfxCallback::screenShot(const char* /*filePath*/, uint32_t width, uint32_t height, uint32_t pitch, const void* data, uint32_t /*size*/, bool yflip)
     {
-        assert(m_screenshotCallbacks.size()); // addScreenShotCallback not called before doing the screenshot call on bgfx
-        auto env = m_screenshotCallbacks.front().Env();
-        auto array = Napi::Uint8Array::New(env, height * pitch);
-        auto bitmap = static_cast<uint8_t*>(array.Data());
+        // This runs on the bgfx render thread when frames are pipelined, so the pixels are copied here and only
+        // handed to JavaScript on its own thread.
+        std::vector<uint8_t> pixels(height * pitch);
+        auto bitmap = pixels.data();
 
         for (uint32_t py = 0; py < height; py++)
         {
             const uint8_t* ptr = static_cast<const uint8_t*>(data) + (yflip ? (height - py - 1) : py) * pitch;
-            for (uint32_t px = 0; px < width; px++)
-            {
-                // bgfx screenshot is BGRA
-                *bitmap++ = ptr[px * 4 + 2];
-                *bitmap++ = ptr[px * 4 + 1];
-                *bitmap++ = ptr[px * 4 + 0];
-                *bitmap++ = ptr[px * 4 + 3];
-            }
+            // bgfx screenshot is BGRA
+            ImageKernels::SwapRedBlue(ptr, bitmap, width);
+            bitmap += width * 4;
         }
 
-        JsRuntime& runtime{ JsRuntime::GetFromJavaScript(env) };
+        JsRuntime* runtime{};
+        {
+            std::scoped_lock lock{ m_ssCallbackAccess };
+            assert(m_screenshotCallbacks.size()); // addScreenShotCallback not called before doing the screenshot call on bgfx
+            runtime = m_screenshotRuntime;
+        }
+
+        runtime->Dispatch([this, pixels = std::move(pixels)](Napi::Env env) {
+            auto array = Napi::Uint8Array::New(env, pixels.size());
+            std::memcpy(array.Data(), pixels.data(), pixels.size());
 
-        runtime.Dispatch([this, array = std::move(array)](Napi::Env) {
             std::scoped_lock lock{ m_ssCallbackAccess };
             m_screenshotCallbacks.front().Call({ array });
             m_screenshotCallbacks.pop();
@@ -9,6 +9,8 @@
 
 namespace Babylon
 {
+    class JsRuntime;
+
     struct BgfxCallback : public bgfx::CallbackI
     {
         virtual ~BgfxCallback() = default;
@@ -33,6 +35,7 @@ namespace Babylon
 
         std::mutex m_ssCallbackAccess;
         std::queue<Napi::FunctionReference> m_screenshotCallbacks;
+        JsRuntime* m_screenshotRuntime{};
         std::function<void(const char* output)> m_outputFunction;
     };
 }
\ No newline at end of file
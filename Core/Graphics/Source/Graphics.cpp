@@ -1,7 +1,11 @@
 #include "GraphicsImpl.h"
+#include "ImageKernels.h"
 
 #include <JsRuntimeInternalState.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 
 #if (ANDROID)
@@ -21,11 +25,22 @@ namespace Babylon
     namespace
     {
         constexpr auto JS_GRAPHICS_READY_NAME = "whenGraphicsReady";
+        constexpr auto JS_SET_FRAME_STATISTICS_CAPACITY_NAME = "setFrameStatisticsCapacity";
+        constexpr auto JS_GET_FRAME_STATISTICS_NAME = "getFrameStatistics";
+
+        double ToMilliseconds(int64_t ticks, int64_t frequency)
+        {
+            return frequency > 0 ? 1000.0 * static_cast<double>(ticks) / static_cast<double>(frequency) : 0.0;
+        }
+
+        // bgfx keeps its state in globals, so only one Graphics instance at a time can have rendering enabled.
+        std::atomic<bool> s_isBgfxInitialized{false};
     }
 
     // Forward declares of important specializations.
     // clang-format off
     template<> std::unique_ptr<Graphics> Graphics::CreateGraphics<void*, size_t, size_t>(void*, size_t, size_t);
+    template<> std::unique_ptr<Graphics> Graphics::CreateGraphics<Graphics::HeadlessConfiguration>(Graphics::HeadlessConfiguration);
     template<> void Graphics::UpdateWindow<void*>(void*);
     // clang-format on
 
@@ -78,6 +93,32 @@ namespace Babylon
         res.height = static_cast<uint32_t>(height);
     }
 
+    void Graphics::Impl::SetHeadless(HeadlessConfiguration configuration)
+    {
+        std::scoped_lock lock{m_bgfxState.Mutex};
+        if (m_bgfxState.Initialized)
+        {
+            throw std::runtime_error{"Headless mode must be set before rendering is enabled."};
+        }
+
+        auto& init = m_bgfxState.InitState;
+        init.type = configuration.Renderer == HeadlessRenderer::Noop ? bgfx::RendererType::Noop : bgfx::RendererType::OpenGL;
+        // Without a window bgfx has no back buffer to present, so there is nothing to sync or multisample.
+        init.resolution.reset = BGFX_RESET_NONE;
+        init.resolution.width = static_cast<uint32_t>(configuration.Width);
+        init.resolution.height = static_cast<uint32_t>(configuration.Height);
+        init.platformData = {};
+
+        m_headlessState.Enabled = true;
+        m_headlessState.OnFrame = std::move(configuration.OnFrame);
+    }
+
+    bgfx::FrameBufferHandle Graphics::Impl::GetBackBuffer()
+    {
+        std::scoped_lock lock{m_bgfxState.Mutex};
+        return m_headlessState.FrameBuffer;
+    }
+
     void Graphics::Impl::AddRenderWorkTask(arcana::task<void, std::exception_ptr> renderWorkTask)
     {
         std::scoped_lock RenderWorkTasksLock{m_renderWorkTasksMutex};
@@ -94,22 +135,56 @@ namespace Babylon
         return m_afterRenderTaskCompletionSource.as_task();
     }
 
+    void Graphics::Impl::EnableFramePipelining()
+    {
+#ifdef BABYLON_NATIVE_FRAME_PIPELINING
+        std::scoped_lock lock{m_bgfxState.Mutex};
+        if (m_bgfxState.Initialized)
+        {
+            throw std::runtime_error{"Frame pipelining must be enabled before rendering is enabled."};
+        }
+
+        m_bgfxState.FramePipelining = true;
+#else
+        throw std::runtime_error{"Frame pipelining requires building with BABYLON_NATIVE_FRAME_PIPELINING."};
+#endif
+    }
+
     void Graphics::Impl::EnableRendering()
     {
         std::scoped_lock lock{m_bgfxState.Mutex};
 
         if (!m_bgfxState.Initialized)
         {
+            if (s_isBgfxInitialized.exchange(true))
+            {
+                throw std::runtime_error{"Rendering cannot be enabled while another Graphics instance is rendering."};
+            }
+
             // Set the thread affinity (all other rendering operations must happen on this thread).
             m_renderThreadAffinity = std::this_thread::get_id();
 
             // Initialize bgfx.
             auto& init{m_bgfxState.InitState};
             bgfx::setPlatformData(init.platformData);
+#ifdef BABYLON_NATIVE_FRAME_PIPELINING
+            if (!m_bgfxState.FramePipelining)
+            {
+                // bgfx does not start its render thread when the thread that initializes it has already
+                // rendered, and then renders each frame synchronously as in a single threaded build.
+                bgfx::renderFrame();
+            }
+#endif
             bgfx::init(init);
+            m_debugFlags = BGFX_DEBUG_NONE;
+            if (m_headlessState.Enabled)
+            {
+                CreateHeadlessTargets();
+            }
             bgfx::setViewClear(0, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0x443355FF, 1.0f, 0);
             bgfx::setViewRect(0, 0, 0, static_cast<uint16_t>(init.resolution.width), static_cast<uint16_t>(init.resolution.height));
             bgfx::touch(0);
+            NotifyEncoderReset();
 
             m_bgfxState.Initialized = true;
             m_bgfxState.Dirty = false;
@@ -127,7 +202,9 @@ namespace Babylon
 
         if (m_bgfxState.Initialized)
         {
+            DestroyHeadlessTargets();
             bgfx::shutdown();
+            s_isBgfxInitialized = false;
             m_bgfxState.Initialized = false;
             m_enableRenderTaskCompletionSource = {};
             m_renderThreadAffinity = {};
@@ -153,7 +230,12 @@ namespace Babylon
             {
                 bgfx::setPlatformData(m_bgfxState.InitState.platformData);
                 auto& res = m_bgfxState.InitState.resolution;
-                bgfx::reset(res.width, res.height, BGFX_RESET_FLAGS);
+                bgfx::reset(res.width, res.height, res.reset);
+                if (m_headlessState.Enabled)
+                {
+                    DestroyHeadlessTargets();
+                    CreateHeadlessTargets();
+                }
                 bgfx::setViewRect(0, 0, 0, static_cast<uint16_t>(res.width), static_cast<uint16_t>(res.height));
 
 #if __APPLE__
@@ -161,6 +243,7 @@ namespace Babylon
 #else
                 bgfx::touch(0);
 #endif
+                NotifyEncoderReset();
 
                 m_bgfxState.Dirty = false;
             }
@@ -180,6 +263,8 @@ namespace Babylon
             throw std::runtime_error{"Current frame cannot be finished prior to having been started."};
         }
 
+        const auto finishStart = std::chrono::steady_clock::now();
+
         bool finished{false};
         bool workDone{false};
         std::exception_ptr error{};
@@ -201,10 +286,28 @@ namespace Babylon
                 if (m_bgfxState.Dirty)
                 {
                     bgfx::discard();
+                    NotifyEncoderReset();
                 }
             }
 
-            bgfx::frame();
+            UpdateProfiler();
+
+            // With frame pipelining this only waits for the bgfx render thread to finish the previous frame
+            // and hands this one over, so that the next frame can be recorded while this one is submitted.
+            const uint32_t readbackFrame = RequestHeadlessReadback();
+            uint32_t frame = bgfx::frame();
+            if (readbackFrame != 0)
+            {
+                // The pixels are only copied once bgfx has rendered the frame that read them back.
+                while (frame < readbackFrame)
+                {
+                    frame = bgfx::frame();
+                }
+                DeliverHeadlessFrame();
+            }
+            NotifyEncoderReset();
+
+            RecordFrameStatistics(std::chrono::steady_clock::now() - finishStart);
         }
 
         auto oldRenderTaskCompletionSource = m_afterRenderTaskCompletionSource;
@@ -214,6 +317,183 @@ namespace Babylon
         m_rendering = false;
     }
 
+    void Graphics::Impl::SetFrameStatisticsCapacity(size_t frameCount)
+    {
+        std::scoped_lock lock{m_frameStatisticsState.Mutex};
+        m_frameStatisticsState.Capacity = frameCount;
+        m_frameStatisticsState.Frames.clear();
+        m_frameStatisticsState.Frames.reserve(frameCount);
+        m_frameStatisticsState.Next = 0;
+    }
+
+    std::vector<Graphics::FrameStatistics> Graphics::Impl::GetFrameStatistics()
+    {
+        std::scoped_lock lock{m_frameStatisticsState.Mutex};
+        const auto& frames = m_frameStatisticsState.Frames;
+        const auto next = frames.begin() + static_cast<std::ptrdiff_t>(m_frameStatisticsState.Next);
+
+        std::vector<FrameStatistics> result{next, frames.end()};
+        result.insert(result.end(), frames.begin(), next);
+        return result;
+    }
+
+    void Graphics::Impl::AddScriptTime(std::chrono::steady_clock::duration duration)
+    {
+        m_frameStatisticsState.ScriptNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    Graphics::Impl::EncoderResetCallbackTicket Graphics::Impl::AddEncoderResetCallback(std::function<void()> callback)
+    {
+        auto ticket = std::make_shared<std::function<void()>>(std::move(callback));
+
+        std::scoped_lock lock{m_encoderResetState.Mutex};
+        m_encoderResetState.Callbacks.push_back(ticket);
+        return ticket;
+    }
+
+    void Graphics::Impl::NotifyEncoderReset()
+    {
+        std::scoped_lock lock{m_encoderResetState.Mutex};
+        auto& callbacks = m_encoderResetState.Callbacks;
+        callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [](const auto& callback) { return callback.expired(); }), callbacks.end());
+        for (const auto& weakCallback : callbacks)
+        {
+            // Locked so that a callback whose ticket is released meanwhile stays alive while it runs.
+            if (const auto callback = weakCallback.lock())
+            {
+                (*callback)();
+            }
+        }
+    }
+
+    void Graphics::Impl::UpdateProfiler()
+    {
+        std::scoped_lock lock{m_frameStatisticsState.Mutex};
+        const bool enable = m_frameStatisticsState.Capacity > 0;
+        const uint32_t debugFlags = enable ? m_debugFlags | BGFX_DEBUG_PROFILER : m_debugFlags & ~BGFX_DEBUG_PROFILER;
+        if (debugFlags != m_debugFlags)
+        {
+            // Per view timings are only measured with the profiler on, which has a cost of its own.
+            bgfx::setDebug(debugFlags);
+            m_debugFlags = debugFlags;
+        }
+    }
+
+    void Graphics::Impl::RecordFrameStatistics(std::chrono::steady_clock::duration finishDuration)
+    {
+        const auto scriptNanoseconds = m_frameStatisticsState.ScriptNanoseconds.exchange(0);
+
+        std::scoped_lock lock{m_frameStatisticsState.Mutex};
+        const uint64_t frameNumber = ++m_frameStatisticsState.FrameNumber;
+        if (m_frameStatisticsState.Capacity == 0)
+        {
+            return;
+        }
+
+        const bgfx::Stats* stats = bgfx::getStats();
+
+        FrameStatistics frame{};
+        frame.FrameNumber = frameNumber;
+        frame.ScriptMilliseconds = static_cast<double>(scriptNanoseconds) / 1e6;
+        frame.FinishMilliseconds = std::chrono::duration<double, std::milli>(finishDuration).count();
+        frame.GpuMilliseconds = ToMilliseconds(stats->gpuTimeEnd - stats->gpuTimeBegin, stats->gpuTimerFreq);
+
+        frame.Views.reserve(stats->numViews);
+        for (uint16_t index = 0; index < stats->numViews; ++index)
+        {
+            const auto& view = stats->viewStats[index];
+            frame.Views.push_back({view.view, ToMilliseconds(view.gpuTimeEnd - view.gpuTimeBegin, stats->gpuTimerFreq)});
+        }
+
+        frame.DrawCalls = stats->numDraw;
+        for (const auto primitives : stats->numPrims)
+        {
+            frame.Primitives += primitives;
+        }
+
+        frame.TextureMemory = stats->textureMemoryUsed;
+        frame.RenderTargetMemory = stats->rtMemoryUsed;
+        frame.TransientBufferMemory = static_cast<uint32_t>(stats->transientVbUsed + stats->transientIbUsed);
+        frame.BufferCount = stats->numVertexBuffers + stats->numDynamicVertexBuffers + stats->numIndexBuffers + stats->numDynamicIndexBuffers;
+
+        auto& frames = m_frameStatisticsState.Frames;
+        if (frames.size() < m_frameStatisticsState.Capacity)
+        {
+            frames.push_back(std::move(frame));
+        }
+        else
+        {
+            frames[m_frameStatisticsState.Next] = std::move(frame);
+            m_frameStatisticsState.Next = (m_frameStatisticsState.Next + 1) % frames.size();
+        }
+    }
+
+    void Graphics::Impl::CreateHeadlessTargets()
+    {
+        const auto& res = m_bgfxState.InitState.resolution;
+        m_headlessState.Width = static_cast<uint16_t>(res.width);
+        m_headlessState.Height = static_cast<uint16_t>(res.height);
+
+        std::array<bgfx::TextureHandle, 2> textures{
+            bgfx::createTexture2D(m_headlessState.Width, m_headlessState.Height, false, 1, bgfx::TextureFormat::RGBA8, BGFX_TEXTURE_RT),
+            bgfx::createTexture2D(m_headlessState.Width, m_headlessState.Height, false, 1, bgfx::TextureFormat::D24S8, BGFX_TEXTURE_RT_WRITE_ONLY)};
+        std::array<bgfx::Attachment, textures.size()> attachments{};
+        for (size_t idx = 0; idx < attachments.size(); ++idx)
+        {
+            attachments[idx].init(textures[idx]);
+        }
+        m_headlessState.FrameBuffer = bgfx::createFrameBuffer(static_cast<uint8_t>(attachments.size()), attachments.data(), true);
+        bgfx::setViewFrameBuffer(0, m_headlessState.FrameBuffer);
+
+        constexpr uint64_t readbackCaps{BGFX_CAPS_TEXTURE_BLIT | BGFX_CAPS_TEXTURE_READ_BACK};
+        if (m_headlessState.OnFrame && bgfx::getRendererType() != bgfx::RendererType::Noop && (bgfx::getCaps()->supported & readbackCaps) == readbackCaps)
+        {
+            m_headlessState.ReadbackTexture = bgfx::createTexture2D(m_headlessState.Width, m_headlessState.Height, false, 1, bgfx::TextureFormat::RGBA8, BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK);
+            m_headlessState.Pixels.resize(size_t{m_headlessState.Width} * m_headlessState.Height * 4);
+        }
+    }
+
+    void Graphics::Impl::DestroyHeadlessTargets()
+    {
+        if (bgfx::isValid(m_headlessState.FrameBuffer))
+        {
+            bgfx::destroy(m_headlessState.FrameBuffer);
+            m_headlessState.FrameBuffer = BGFX_INVALID_HANDLE;
+        }
+
+        if (bgfx::isValid(m_headlessState.ReadbackTexture))
+        {
+            bgfx::destroy(m_headlessState.ReadbackTexture);
+            m_headlessState.ReadbackTexture = BGFX_INVALID_HANDLE;
+        }
+    }
+
+    uint32_t Graphics::Impl::RequestHeadlessReadback()
+    {
+        std::scoped_lock lock{m_bgfxState.Mutex};
+        if (!bgfx::isValid(m_headlessState.ReadbackTexture) || m_bgfxState.Dirty)
+        {
+            return 0;
+        }
+
+        // The copy goes in the last view, which NativeEngine never uses, so that it comes after all of the
+        // views that rendered the frame.
+        const auto viewId = static_cast<bgfx::ViewId>(bgfx::getCaps()->limits.maxViews - 1);
+        bgfx::blit(viewId, m_headlessState.ReadbackTexture, 0, 0, bgfx::getTexture(m_headlessState.FrameBuffer));
+        return bgfx::readTexture(m_headlessState.ReadbackTexture, m_headlessState.Pixels.data());
+    }
+
+    void Graphics::Impl::DeliverHeadlessFrame()
+    {
+        const size_t pitch{size_t{m_headlessState.Width} * 4};
+        if (bgfx::getCaps()->originBottomLeft)
+        {
+            ImageKernels::FlipRows(m_headlessState.Pixels.data(), pitch, m_headlessState.Height);
+        }
+
+        m_headlessState.OnFrame(m_headlessState.Pixels.data(), m_headlessState.Width, m_headlessState.Height);
+    }
+
     arcana::task<void, std::exception_ptr> Graphics::Impl::RenderCurrentFrameAsync(bool& finished, bool& workDone, std::exception_ptr& error)
     {
         bool anyTasks{};
@@ -271,6 +551,14 @@ namespace Babylon
         return graphics;
     }
 
+    template<>
+    std::unique_ptr<Graphics> Graphics::CreateGraphics<Graphics::HeadlessConfiguration>(Graphics::HeadlessConfiguration configuration)
+    {
+        std::unique_ptr<Graphics> graphics{new Graphics()};
+        graphics->m_impl->SetHeadless(std::move(configuration));
+        return graphics;
+    }
+
     template<>
     void Graphics::UpdateWindow<void*>(void* windowPtr)
     {
@@ -306,6 +594,44 @@ namespace Babylon
 
             return std::move(promise);
         }, JS_GRAPHICS_READY_NAME));
+
+        JsRuntime::NativeObject::GetFromJavaScript(env).Set(JS_SET_FRAME_STATISTICS_CAPACITY_NAME, Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
+            SetFrameStatisticsCapacity(info[0].As<Napi::Number>().Uint32Value());
+        }, JS_SET_FRAME_STATISTICS_CAPACITY_NAME));
+
+        JsRuntime::NativeObject::GetFromJavaScript(env).Set(JS_GET_FRAME_STATISTICS_NAME, Napi::Function::New(env, [this, env](const Napi::CallbackInfo&) -> Napi::Value {
+            const auto frames = GetFrameStatistics();
+
+            auto result = Napi::Array::New(env, frames.size());
+            for (uint32_t frameIndex = 0; frameIndex < frames.size(); ++frameIndex)
+            {
+                const auto& frame = frames[frameIndex];
+
+                auto views = Napi::Array::New(env, frame.Views.size());
+                for (uint32_t viewIndex = 0; viewIndex < frame.Views.size(); ++viewIndex)
+                {
+                    auto view = Napi::Object::New(env);
+                    view.Set("viewId", Napi::Value::From(env, frame.Views[viewIndex].ViewId));
+                    view.Set("gpuMilliseconds", Napi::Value::From(env, frame.Views[viewIndex].GpuMilliseconds));
+                    views.Set(viewIndex, view);
+                }
+
+                auto object = Napi::Object::New(env);
+                object.Set("frameNumber", Napi::Value::From(env, static_cast<double>(frame.FrameNumber)));
+                object.Set("scriptMilliseconds", Napi::Value::From(env, frame.ScriptMilliseconds));
+                object.Set("finishMilliseconds", Napi::Value::From(env, frame.FinishMilliseconds));
+                object.Set("gpuMilliseconds", Napi::Value::From(env, frame.GpuMilliseconds));
+                object.Set("views", views);
+                object.Set("drawCalls", Napi::Value::From(env, frame.DrawCalls));
+                object.Set("primitives", Napi::Value::From(env, frame.Primitives));
+                object.Set("textureMemory", Napi::Value::From(env, static_cast<double>(frame.TextureMemory)));
+                object.Set("renderTargetMemory", Napi::Value::From(env, static_cast<double>(frame.RenderTargetMemory)));
+                object.Set("transientBufferMemory", Napi::Value::From(env, frame.TransientBufferMemory));
+                object.Set("bufferCount", Napi::Value::From(env, frame.BufferCount));
+                result.Set(frameIndex, object);
+            }
+            return std::move(result);
+        }, JS_GET_FRAME_STATISTICS_NAME));
     }
 
     Graphics::Impl& Graphics::Impl::GetFromJavaScript(Napi::Env env)
@@ -321,6 +647,11 @@ namespace Babylon
         m_impl->AddToJavaScript(env);
     }
 
+    void Graphics::EnableFramePipelining()
+    {
+        m_impl->EnableFramePipelining();
+    }
+
     void Graphics::EnableRendering()
     {
         m_impl->EnableRendering();
@@ -345,4 +676,14 @@ namespace Babylon
     {
         m_impl->SetDiagnosticOutput(std::move(outputFunction));
     }
+
+    void Graphics::SetFrameStatisticsCapacity(size_t frameCount)
+    {
+        m_impl->SetFrameStatisticsCapacity(frameCount);
+    }
+
+    std::vector<Graphics::FrameStatistics> Graphics::GetFrameStatistics()
+    {
+        return m_impl->GetFrameStatistics();
+    }
 }
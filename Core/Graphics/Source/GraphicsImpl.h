@@ -10,6 +10,13 @@
 #include <bgfx/bgfx.h>
 #include <bgfx/platform.h>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace Babylon
 {
     class Graphics::Impl
@@ -24,6 +31,12 @@ namespace Babylon
         void SetNativeWindow(void* nativeWindowPtr);
         void Resize(size_t width, size_t height);
 
+        // Renders without a window into an offscreen frame buffer. Must be called before rendering is enabled.
+        void SetHeadless(HeadlessConfiguration configuration);
+
+        // The frame buffer that stands in for the back buffer when headless, or an invalid handle otherwise.
+        bgfx::FrameBufferHandle GetBackBuffer();
+
         void AddToJavaScript(Napi::Env);
         static Impl& GetFromJavaScript(Napi::Env);
 
@@ -31,6 +44,8 @@ namespace Babylon
         arcana::task<void, std::exception_ptr> GetBeforeRenderTask();
         arcana::task<void, std::exception_ptr> GetAfterRenderTask();
 
+        void EnableFramePipelining();
+
         void EnableRendering();
         void DisableRendering();
 
@@ -45,6 +60,19 @@ namespace Babylon
 
         void SetDiagnosticOutput(std::function<void(const char* output)> outputFunction);
 
+        void SetFrameStatisticsCapacity(size_t frameCount);
+        std::vector<FrameStatistics> GetFrameStatistics();
+
+        // Adds to the time the JavaScript thread has spent on the current frame. Thread safe.
+        void AddScriptTime(std::chrono::steady_clock::duration duration);
+
+        // Keeps a callback added with AddEncoderResetCallback registered for as long as it is held.
+        using EncoderResetCallbackTicket = std::shared_ptr<std::function<void()>>;
+
+        // Adds a callback that is invoked on the render thread whenever Graphics resets the state of the bgfx
+        // API thread encoder with bgfx::frame, bgfx::touch or bgfx::discard. Thread safe.
+        EncoderResetCallbackTicket AddEncoderResetCallback(std::function<void()> callback);
+
         BgfxCallback Callback{};
 
     private:
@@ -59,8 +87,44 @@ namespace Babylon
             bgfx::Init InitState{};
             bool Initialized{};
             bool Dirty{};
+            bool FramePipelining{};
         } m_bgfxState{};
 
+        struct
+        {
+            bool Enabled{};
+            FrameCallback OnFrame{};
+
+            bgfx::FrameBufferHandle FrameBuffer{bgfx::kInvalidHandle};
+            bgfx::TextureHandle ReadbackTexture{bgfx::kInvalidHandle};
+            uint16_t Width{};
+            uint16_t Height{};
+            std::vector<uint8_t> Pixels{};
+        } m_headlessState{};
+
+        // The bgfx debug flags in effect, which other flags may share with the profiler. Only accessed on the
+        // render thread.
+        uint32_t m_debugFlags{BGFX_DEBUG_NONE};
+
+        struct
+        {
+            std::mutex Mutex{};
+
+            // A ring buffer of Capacity frames, of which Next is the oldest once it is full.
+            std::vector<FrameStatistics> Frames{};
+            size_t Capacity{};
+            size_t Next{};
+            uint64_t FrameNumber{};
+
+            std::atomic<int64_t> ScriptNanoseconds{};
+        } m_frameStatisticsState{};
+
+        struct
+        {
+            std::mutex Mutex{};
+            std::vector<std::weak_ptr<std::function<void()>>> Callbacks{};
+        } m_encoderResetState{};
+
         arcana::task_completion_source<void, std::exception_ptr> m_enableRenderTaskCompletionSource{};
         arcana::task_completion_source<void, std::exception_ptr> m_beforeRenderTaskCompletionSource{};
         arcana::task_completion_source<void, std::exception_ptr> m_afterRenderTaskCompletionSource{};
@@ -69,6 +133,18 @@ namespace Babylon
         std::vector<arcana::task<void, std::exception_ptr>> m_renderWorkTasks{};
         std::mutex m_renderWorkTasksMutex{};
 
+        // Must be called with m_bgfxState.Mutex held.
+        void CreateHeadlessTargets();
+        void DestroyHeadlessTargets();
+
+        uint32_t RequestHeadlessReadback();
+        void DeliverHeadlessFrame();
+
+        void NotifyEncoderReset();
+
+        void UpdateProfiler();
+        void RecordFrameStatistics(std::chrono::steady_clock::duration finishDuration);
+
         arcana::task<void, std::exception_ptr> RenderCurrentFrameAsync(bool& finished, bool& workDone, std::exception_ptr& error);
     };
 }
@@ -0,0 +1,241 @@
+#include "ImageKernels.h"
+
+#include <bx/math.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_KERNELS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define IMAGE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Babylon
+{
+    namespace
+    {
+        void SwapBytes(uint8_t* a, uint8_t* b, size_t size)
+        {
+            size_t offset = 0;
+#if defined(IMAGE_KERNELS_SSE2)
+            for (; offset + 16 <= size; offset += 16)
+            {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + offset), vb);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(b + offset), va);
+            }
+#elif defined(IMAGE_KERNELS_NEON)
+            for (; offset + 16 <= size; offset += 16)
+            {
+                const uint8x16_t va = vld1q_u8(a + offset);
+                const uint8x16_t vb = vld1q_u8(b + offset);
+                vst1q_u8(a + offset, vb);
+                vst1q_u8(b + offset, va);
+            }
+#endif
+            for (; offset < size; ++offset)
+            {
+                std::swap(a[offset], b[offset]);
+            }
+        }
+
+        // The rows to average for destination row y; the last row is repeated for images one pixel high.
+        void GetSourceRows(const uint8_t* src, uint32_t srcHeight, size_t srcPitch, uint32_t y, const uint8_t*& row0, const uint8_t*& row1)
+        {
+            row0 = src + size_t{2} * y * srcPitch;
+            row1 = src + std::min<size_t>(size_t{2} * y + 1, srcHeight - 1) * srcPitch;
+        }
+
+        uint32_t GetDownsampledSize(uint32_t size)
+        {
+            return std::max<uint32_t>(size / 2, 1);
+        }
+
+        void AverageRgba32F(const float* a, const float* b, const float* c, const float* d, float* dst)
+        {
+#if defined(IMAGE_KERNELS_SSE2)
+            const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), _mm_add_ps(_mm_loadu_ps(c), _mm_loadu_ps(d)));
+            _mm_storeu_ps(dst, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#elif defined(IMAGE_KERNELS_NEON)
+            const float32x4_t sum = vaddq_f32(vaddq_f32(vld1q_f32(a), vld1q_f32(b)), vaddq_f32(vld1q_f32(c), vld1q_f32(d)));
+            vst1q_f32(dst, vmulq_n_f32(sum, 0.25f));
+#else
+            for (size_t channel = 0; channel < 4; ++channel)
+            {
+                dst[channel] = ((a[channel] + b[channel]) + (c[channel] + d[channel])) * 0.25f;
+            }
+#endif
+        }
+    }
+
+    namespace ImageKernels
+    {
+        void FlipRows(uint8_t* data, size_t rowPitch, size_t rowCount)
+        {
+            for (size_t row = 0; row < rowCount / 2; ++row)
+            {
+                SwapBytes(data + row * rowPitch, data + (rowCount - row - 1) * rowPitch, rowPitch);
+            }
+        }
+
+        void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t pixelCount)
+        {
+            size_t pixel = 0;
+#if defined(IMAGE_KERNELS_SSE2)
+            // Within each 32-bit pixel, keep green and alpha and exchange the bytes at bits 0 and 16.
+            const __m128i greenAlphaMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            for (; pixel + 4 <= pixelCount; pixel += 4)
+            {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pixel * 4));
+                const __m128i greenAlpha = _mm_and_si128(value, greenAlphaMask);
+                const __m128i redBlue = _mm_andnot_si128(greenAlphaMask, value);
+                const __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pixel * 4), _mm_or_si128(greenAlpha, swapped));
+            }
+#elif defined(IMAGE_KERNELS_NEON)
+            for (; pixel + 16 <= pixelCount; pixel += 16)
+            {
+                uint8x16x4_t value = vld4q_u8(src + pixel * 4);
+                std::swap(value.val[0], value.val[2]);
+                vst4q_u8(dst + pixel * 4, value);
+            }
+#endif
+            for (; pixel < pixelCount; ++pixel)
+            {
+                const uint8_t* in = src + pixel * 4;
+                uint8_t* out = dst + pixel * 4;
+                const uint8_t first = in[0];
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = first;
+                out[3] = in[3];
+            }
+        }
+
+        void DownsampleRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            const uint32_t dstWidth = GetDownsampledSize(srcWidth);
+            const uint32_t dstHeight = GetDownsampledSize(srcHeight);
+
+            for (uint32_t y = 0; y < dstHeight; ++y)
+            {
+                const uint8_t* row0{};
+                const uint8_t* row1{};
+                GetSourceRows(src, srcHeight, srcPitch, y, row0, row1);
+                uint8_t* out = dst + y * dstPitch;
+
+                uint32_t x = 0;
+                // Source columns come in pairs unless the image is one pixel wide.
+                if (srcWidth > 1)
+                {
+#if defined(IMAGE_KERNELS_SSE2)
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i rounding = _mm_set1_epi16(2);
+                    for (; x + 2 <= dstWidth; x += 2)
+                    {
+                        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                        // Vertical sums of source pixels 0 and 1, then 2 and 3, as 16-bit channels.
+                        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                        const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+                        const __m128i average = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(average, average));
+                    }
+#elif defined(IMAGE_KERNELS_NEON)
+                    for (; x + 2 <= dstWidth; x += 2)
+                    {
+                        const uint8x16_t a = vld1q_u8(row0 + x * 8);
+                        const uint8x16_t b = vld1q_u8(row1 + x * 8);
+                        const uint16x8_t low = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+                        const uint16x8_t high = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+                        const uint16x8_t sum = vcombine_u16(vadd_u16(vget_low_u16(low), vget_high_u16(low)), vadd_u16(vget_low_u16(high), vget_high_u16(high)));
+                        vst1_u8(out + x * 4, vrshrn_n_u16(sum, 2));
+                    }
+#endif
+                }
+
+                for (; x < dstWidth; ++x)
+                {
+                    const uint32_t x0 = 2 * x;
+                    const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1);
+                    for (uint32_t channel = 0; channel < 4; ++channel)
+                    {
+                        const uint32_t sum = row0[x0 * 4 + channel] + row0[x1 * 4 + channel] + row1[x0 * 4 + channel] + row1[x1 * 4 + channel];
+                        out[x * 4 + channel] = static_cast<uint8_t>((sum + 2) >> 2);
+                    }
+                }
+            }
+        }
+
+        void DownsampleRgba16F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            const uint32_t dstWidth = GetDownsampledSize(srcWidth);
+            const uint32_t dstHeight = GetDownsampledSize(srcHeight);
+
+            float samples[4][4]{};
+            float average[4]{};
+            for (uint32_t y = 0; y < dstHeight; ++y)
+            {
+                const uint8_t* row0{};
+                const uint8_t* row1{};
+                GetSourceRows(src, srcHeight, srcPitch, y, row0, row1);
+                auto* out = reinterpret_cast<uint16_t*>(dst + y * dstPitch);
+
+                for (uint32_t x = 0; x < dstWidth; ++x)
+                {
+                    const uint32_t x0 = 2 * x;
+                    const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1);
+                    const uint16_t* pixels[4]{
+                        reinterpret_cast<const uint16_t*>(row0) + x0 * 4,
+                        reinterpret_cast<const uint16_t*>(row0) + x1 * 4,
+                        reinterpret_cast<const uint16_t*>(row1) + x0 * 4,
+                        reinterpret_cast<const uint16_t*>(row1) + x1 * 4,
+                    };
+
+                    for (size_t sample = 0; sample < 4; ++sample)
+                    {
+                        for (size_t channel = 0; channel < 4; ++channel)
+                        {
+                            samples[sample][channel] = bx::halfToFloat(pixels[sample][channel]);
+                        }
+                    }
+
+                    AverageRgba32F(samples[0], samples[1], samples[2], samples[3], average);
+
+                    for (size_t channel = 0; channel < 4; ++channel)
+                    {
+                        out[x * 4 + channel] = bx::halfFromFloat(average[channel]);
+                    }
+                }
+            }
+        }
+
+        void DownsampleRgba32F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch)
+        {
+            const uint32_t dstWidth = GetDownsampledSize(srcWidth);
+            const uint32_t dstHeight = GetDownsampledSize(srcHeight);
+
+            for (uint32_t y = 0; y < dstHeight; ++y)
+            {
+                const uint8_t* row0{};
+                const uint8_t* row1{};
+                GetSourceRows(src, srcHeight, srcPitch, y, row0, row1);
+                const auto* in0 = reinterpret_cast<const float*>(row0);
+                const auto* in1 = reinterpret_cast<const float*>(row1);
+                auto* out = reinterpret_cast<float*>(dst + y * dstPitch);
+
+                for (uint32_t x = 0; x < dstWidth; ++x)
+                {
+                    const uint32_t x0 = 2 * x;
+                    const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1);
+                    AverageRgba32F(in0 + x0 * 4, in0 + x1 * 4, in1 + x0 * 4, in1 + x1 * 4, out + x * 4);
+                }
+            }
+        }
+    }
+}
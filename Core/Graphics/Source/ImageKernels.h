@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Babylon
+{
+    /// Pixel processing loops used when preparing textures and screenshots. Each kernel has an SSE2 or NEON
+    /// implementation where the target supports one and a scalar one otherwise, and all implementations
+    /// produce bit-identical results.
+    namespace ImageKernels
+    {
+        // Reverses the order of the rows of an image in place.
+        void FlipRows(uint8_t* data, size_t rowPitch, size_t rowCount);
+
+        // Swaps the first and third channel of 4-byte pixels, converting BGRA8 to RGBA8 and vice versa.
+        // src and dst may be the same buffer.
+        void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t pixelCount);
+
+        // Box filters an image down to max(1, srcWidth / 2) by max(1, srcHeight / 2) pixels, the size of
+        // the next level of a mip chain. Pitches are in bytes.
+        using DownsampleFunction = void (*)(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch);
+
+        void DownsampleRgba8(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch);
+        void DownsampleRgba16F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch);
+        void DownsampleRgba32F(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, size_t srcPitch, uint8_t* dst, size_t dstPitch);
+    }
+}
@@ -2,8 +2,9 @@
 
 #include <napi/env.h>
 
+#include <chrono>
 #include <functional>
-#include <mutex>
+#include <memory>
 
 namespace Babylon
 {
@@ -25,27 +26,79 @@ namespace Babylon
         struct InternalState;
         friend struct InternalState;
 
+        // Lanes of work on the JavaScript thread, highest priority first. A lane only runs once every lane
+        // above it is empty, and the host may defer the I/O and idle lanes to keep frames on time. After a
+        // frame callback, the lanes below it run first until they are empty or the frame budget has passed.
+        enum class DispatchPriority
+        {
+            // Frame callbacks, such as requestAnimationFrame.
+            Frame,
+            Input,
+            // Completions of I/O and other background work. This is the priority of Dispatch.
+            IO,
+            Idle,
+        };
+
         using DispatchFunctionT = std::function<void(std::function<void(Napi::Env)>)>;
+        using DispatchAtFunctionT = std::function<void(std::chrono::steady_clock::time_point, std::function<void(Napi::Env)>)>;
+        using PriorityDispatchFunctionT = std::function<void(DispatchPriority, std::function<void(Napi::Env)>)>;
+        using IdleDeadlineFunctionT = std::function<std::chrono::steady_clock::time_point()>;
 
         // Note: It is the contract of JsRuntime that its dispatch function must be usable
         // at the moment of construction. JsRuntime cannot be built with dispatch function
         // that captures a refence to a not-yet-completed object that will be completed
         // later -- an instance of an inheriting type, for example. The dispatch function
         // must be safely callable as soon as it is passed to the JsRuntime constructor.
-        static JsRuntime& CreateForJavaScript(Napi::Env, DispatchFunctionT);
+        // Dispatch can be called from any number of threads at once, so the dispatch
+        // function must also be thread safe. The same goes for the optional dispatch at
+        // function, which must run its function once the given deadline has passed, and
+        // the optional priority dispatch function. Without the latter, every priority is
+        // dispatched through the dispatch function. The optional idle deadline function
+        // is only called from the JavaScript thread.
+        // Dispatches to a runtime that may be destroyed before the last function is dispatched, for instance
+        // from the callbacks of native resources that outlive it. Thread safe.
+        class WeakDispatcher final
+        {
+        public:
+            // Returns false, and drops the function, once the runtime has been destroyed.
+            bool Dispatch(std::function<void(Napi::Env)> function) const;
+
+        private:
+            friend class JsRuntime;
+            struct State;
+
+            explicit WeakDispatcher(std::shared_ptr<State> state);
+
+            std::shared_ptr<State> m_state;
+        };
+
+        static JsRuntime& CreateForJavaScript(Napi::Env, DispatchFunctionT, DispatchAtFunctionT = {}, PriorityDispatchFunctionT = {}, IdleDeadlineFunctionT = {});
         static JsRuntime& GetFromJavaScript(Napi::Env);
         void Dispatch(std::function<void(Napi::Env)>);
+        void Dispatch(DispatchPriority priority, std::function<void(Napi::Env)>);
+
+        // The time until which work dispatched with idle priority may run without delaying the next
+        // frame. Must only be called from the JavaScript thread.
+        std::chrono::steady_clock::time_point GetIdleDeadline() const;
+        void DispatchAt(std::chrono::steady_clock::time_point deadline, std::function<void(Napi::Env)>);
+
+        WeakDispatcher GetWeakDispatcher() const;
+
+        ~JsRuntime();
 
     protected:
         JsRuntime(const JsRuntime&) = delete;
         JsRuntime(JsRuntime&&) = delete;
 
     private:
-        JsRuntime(Napi::Env, DispatchFunctionT);
+        JsRuntime(Napi::Env, DispatchFunctionT, DispatchAtFunctionT, PriorityDispatchFunctionT, IdleDeadlineFunctionT);
 
         DispatchFunctionT m_dispatchFunction{};
-        std::mutex m_mutex{};
+        DispatchAtFunctionT m_dispatchAtFunction{};
+        PriorityDispatchFunctionT m_priorityDispatchFunction{};
+        IdleDeadlineFunctionT m_idleDeadlineFunction{};
 
         std::unique_ptr<InternalState> m_internalState{};
+        std::shared_ptr<WeakDispatcher::State> m_weakDispatcherState{};
     };
 }
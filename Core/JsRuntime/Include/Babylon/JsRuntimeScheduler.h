@@ -11,20 +11,22 @@ namespace Babylon
     class JsRuntimeScheduler
     {
     public:
-        explicit JsRuntimeScheduler(JsRuntime& runtime)
+        explicit JsRuntimeScheduler(JsRuntime& runtime, JsRuntime::DispatchPriority priority = JsRuntime::DispatchPriority::IO)
             : m_runtime{runtime}
+            , m_priority{priority}
         {
         }
 
         template<typename CallableT>
         void operator()(CallableT&& callable) const
         {
-            m_runtime.Dispatch([callable{std::forward<CallableT>(callable)}](Napi::Env){
+            m_runtime.Dispatch(m_priority, [callable{std::forward<CallableT>(callable)}](Napi::Env){
                 callable();
             });
         }
 
     private:
         JsRuntime& m_runtime;
+        JsRuntime::DispatchPriority m_priority;
     };
 }
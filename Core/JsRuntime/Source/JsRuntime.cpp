@@ -1,18 +1,54 @@
 #include "JsRuntime.h"
 #include "JsRuntimeInternalState.h"
 
+#include <mutex>
+
 namespace Babylon
 {
     namespace
     {
         static constexpr auto JS_RUNTIME_NAME = "runtime";
         static constexpr auto JS_WINDOW_NAME = "window";
+
+        // Without a host that knows when frames start, idle work gets the longest idle period browsers give.
+        static constexpr std::chrono::milliseconds DEFAULT_IDLE_PERIOD{50};
+    }
+
+    struct JsRuntime::WeakDispatcher::State
+    {
+        std::mutex Mutex{};
+        // Reset when the runtime is destroyed.
+        JsRuntime* Runtime{};
+    };
+
+    JsRuntime::WeakDispatcher::WeakDispatcher(std::shared_ptr<State> state)
+        : m_state{std::move(state)}
+    {
+    }
+
+    bool JsRuntime::WeakDispatcher::Dispatch(std::function<void(Napi::Env)> function) const
+    {
+        // The runtime is not destroyed while a function is being dispatched to it.
+        std::scoped_lock lock{m_state->Mutex};
+        if (m_state->Runtime == nullptr)
+        {
+            return false;
+        }
+
+        m_state->Runtime->Dispatch(std::move(function));
+        return true;
     }
 
-    JsRuntime::JsRuntime(Napi::Env env, DispatchFunctionT dispatchFunction)
+    JsRuntime::JsRuntime(Napi::Env env, DispatchFunctionT dispatchFunction, DispatchAtFunctionT dispatchAtFunction, PriorityDispatchFunctionT priorityDispatchFunction, IdleDeadlineFunctionT idleDeadlineFunction)
         : m_dispatchFunction{std::move(dispatchFunction)}
+        , m_dispatchAtFunction{std::move(dispatchAtFunction)}
+        , m_priorityDispatchFunction{std::move(priorityDispatchFunction)}
+        , m_idleDeadlineFunction{std::move(idleDeadlineFunction)}
         , m_internalState{std::make_unique<JsRuntime::InternalState>()}
+        , m_weakDispatcherState{std::make_shared<WeakDispatcher::State>()}
     {
+        m_weakDispatcherState->Runtime = this;
+
         auto global = env.Global();
 
         if (global.Get(JS_WINDOW_NAME).IsUndefined())
@@ -27,9 +63,15 @@ namespace Babylon
         jsNative.Set(JS_RUNTIME_NAME, jsRuntime);
     }
 
-    JsRuntime& JsRuntime::CreateForJavaScript(Napi::Env env, DispatchFunctionT dispatchFunction)
+    JsRuntime::~JsRuntime()
+    {
+        std::scoped_lock lock{m_weakDispatcherState->Mutex};
+        m_weakDispatcherState->Runtime = nullptr;
+    }
+
+    JsRuntime& JsRuntime::CreateForJavaScript(Napi::Env env, DispatchFunctionT dispatchFunction, DispatchAtFunctionT dispatchAtFunction, PriorityDispatchFunctionT priorityDispatchFunction, IdleDeadlineFunctionT idleDeadlineFunction)
     {
-        auto* runtime = new JsRuntime(env, std::move(dispatchFunction));
+        auto* runtime = new JsRuntime(env, std::move(dispatchFunction), std::move(dispatchAtFunction), std::move(priorityDispatchFunction), std::move(idleDeadlineFunction));
         return *runtime;
     }
 
@@ -44,7 +86,53 @@ namespace Babylon
 
     void JsRuntime::Dispatch(std::function<void(Napi::Env)> function)
     {
-        std::scoped_lock lock{m_mutex};
         m_dispatchFunction(std::move(function));
     }
+
+    void JsRuntime::Dispatch(DispatchPriority priority, std::function<void(Napi::Env)> function)
+    {
+        if (m_priorityDispatchFunction)
+        {
+            m_priorityDispatchFunction(priority, std::move(function));
+            return;
+        }
+
+        m_dispatchFunction(std::move(function));
+    }
+
+    std::chrono::steady_clock::time_point JsRuntime::GetIdleDeadline() const
+    {
+        if (m_idleDeadlineFunction)
+        {
+            return m_idleDeadlineFunction();
+        }
+
+        return std::chrono::steady_clock::now() + DEFAULT_IDLE_PERIOD;
+    }
+
+    JsRuntime::WeakDispatcher JsRuntime::GetWeakDispatcher() const
+    {
+        return WeakDispatcher{m_weakDispatcherState};
+    }
+
+    void JsRuntime::DispatchAt(std::chrono::steady_clock::time_point deadline, std::function<void(Napi::Env)> function)
+    {
+        if (m_dispatchAtFunction)
+        {
+            m_dispatchAtFunction(deadline, std::move(function));
+            return;
+        }
+
+        // Without a host timer, the function is dispatched again until the deadline has passed.
+        Dispatch([this, deadline, function = std::move(function)](Napi::Env env) mutable {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                function(env);
+            }
+            else
+            {
+                DispatchAt(deadline, std::move(function));
+            }
+        });
+    }
 }
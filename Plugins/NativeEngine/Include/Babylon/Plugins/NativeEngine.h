@@ -4,7 +4,20 @@
 
 #include <napi/env.h>
 
+#include <string>
+
 namespace Babylon::Plugins::NativeEngine
 {
     void Initialize(Napi::Env env, bool renderAutomatically = true);
+
+    struct ShaderCacheStatistics
+    {
+        uint32_t Hits{};
+        uint32_t Misses{};
+    };
+
+    // Compiled shaders are stored in and loaded from the given (existing) directory.
+    void EnableShaderCache(std::string directory);
+    void DisableShaderCache();
+    ShaderCacheStatistics GetShaderCacheStatistics();
 }
@@ -0,0 +1,117 @@
+#include "BackBufferCompositor.h"
+#include "RenderStateCache.h"
+
+#include <array>
+#include <stdexcept>
+
+namespace Babylon
+{
+    namespace
+    {
+        // The shader compiler maps these attribute names to the position and first texture coordinate.
+        constexpr auto VERTEX_SOURCE = R"(
+            precision highp float;
+            in vec2 position;
+            in vec2 uv;
+            out vec2 vUV;
+            void main()
+            {
+                vUV = uv;
+                gl_Position = vec4(position, 0.0, 1.0);
+            }
+        )";
+
+        constexpr auto FRAGMENT_SOURCE = R"(
+            precision highp float;
+            uniform sampler2D textureSampler;
+            in vec2 vUV;
+            out vec4 glFragColor;
+            void main()
+            {
+                glFragColor = texture(textureSampler, vUV);
+            }
+        )";
+
+        struct Vertex
+        {
+            float X;
+            float Y;
+            float U;
+            float V;
+        };
+    }
+
+    BackBufferCompositor::BackBufferCompositor(ShaderCompilerPool& compilerPool)
+        : m_compilerPool{compilerPool}
+    {
+    }
+
+    void BackBufferCompositor::Composite(bgfx::ViewId viewId, bgfx::TextureHandle texture)
+    {
+        if (!bgfx::isValid(m_program))
+        {
+            Initialize();
+        }
+
+        // The encoder may still hold the bindings of the last draw of the engine.
+        bgfx::discard();
+        bgfx::setVertexBuffer(0, m_vertexBuffer);
+        bgfx::setTexture(m_samplerStage, m_sampler, texture);
+        bgfx::setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+        bgfx::submit(viewId, m_program);
+        RenderStateCache::NotifyDiscarded();
+    }
+
+    void BackBufferCompositor::Destroy()
+    {
+        if (bgfx::isValid(m_program))
+        {
+            bgfx::destroy(m_program);
+            bgfx::destroy(m_vertexBuffer);
+            m_program = BGFX_INVALID_HANDLE;
+            m_sampler = BGFX_INVALID_HANDLE;
+            m_vertexBuffer = BGFX_INVALID_HANDLE;
+        }
+    }
+
+    void BackBufferCompositor::Initialize()
+    {
+        const auto shaderInfo = m_compilerPool.Compile(VERTEX_SOURCE, FRAGMENT_SOURCE);
+
+        const auto vertexShader = bgfx::createShader(bgfx::copy(shaderInfo.VertexBytes.data(), static_cast<uint32_t>(shaderInfo.VertexBytes.size())));
+        const auto fragmentShader = bgfx::createShader(bgfx::copy(shaderInfo.FragmentBytes.data(), static_cast<uint32_t>(shaderInfo.FragmentBytes.size())));
+
+        // The sampler is the only uniform, and it is owned by the fragment shader.
+        if (bgfx::getShaderUniforms(fragmentShader, &m_sampler, 1) == 0)
+        {
+            bgfx::destroy(vertexShader);
+            bgfx::destroy(fragmentShader);
+            throw std::runtime_error{"The back buffer compositor has no sampler."};
+        }
+
+        bgfx::UniformInfo info{};
+        bgfx::getUniformInfo(m_sampler, info);
+        const auto stage = shaderInfo.FragmentUniformStages.find(info.name);
+        m_samplerStage = stage == shaderInfo.FragmentUniformStages.end() ? uint8_t{} : stage->second;
+
+        m_program = bgfx::createProgram(vertexShader, fragmentShader, true);
+
+        // A triangle that covers the whole view. The offscreen back buffer is rendered without the flip that
+        // render targets get, so its first row is at the origin of the renderer.
+        const bool originBottomLeft = bgfx::getCaps()->originBottomLeft;
+        const float bottom = originBottomLeft ? 0.f : 1.f;
+        const float top = originBottomLeft ? 2.f : -1.f;
+        const std::array<Vertex, 3> vertices{{
+            {-1.f, -1.f, 0.f, bottom},
+            {3.f, -1.f, 2.f, bottom},
+            {-1.f, 3.f, 0.f, top},
+        }};
+
+        bgfx::VertexLayout layout{};
+        layout.begin()
+            .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+            .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+            .end();
+        m_vertexBuffer = bgfx::createVertexBuffer(bgfx::copy(vertices.data(), static_cast<uint32_t>(sizeof(vertices))), layout);
+    }
+}
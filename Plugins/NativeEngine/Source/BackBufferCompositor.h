@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ShaderCompilerPool.h"
+
+#include <bgfx/bgfx.h>
+
+namespace Babylon
+{
+    /// Draws a texture over a whole view with a single full screen triangle. The frame buffer manager uses
+    /// it to copy the back buffer it renders offscreen after a frame has been split to the actual back
+    /// buffer. Most applications never split a frame, so the program is only compiled once it is needed.
+    class BackBufferCompositor final
+    {
+    public:
+        // bgfx resources still alive when the compositor is destroyed are left to bgfx::shutdown.
+        explicit BackBufferCompositor(ShaderCompilerPool& compilerPool);
+        BackBufferCompositor(const BackBufferCompositor&) = delete;
+        BackBufferCompositor& operator=(const BackBufferCompositor&) = delete;
+
+        // Must be called on the bgfx API thread, whose encoder state it discards.
+        void Composite(bgfx::ViewId viewId, bgfx::TextureHandle texture);
+
+        // Destroys the bgfx resources, which must happen before bgfx::shutdown.
+        void Destroy();
+
+    private:
+        void Initialize();
+
+        ShaderCompilerPool& m_compilerPool;
+        bgfx::ProgramHandle m_program{bgfx::kInvalidHandle};
+        bgfx::UniformHandle m_sampler{bgfx::kInvalidHandle};
+        uint8_t m_samplerStage{};
+        bgfx::VertexBufferHandle m_vertexBuffer{bgfx::kInvalidHandle};
+    };
+}
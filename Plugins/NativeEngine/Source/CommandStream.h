@@ -0,0 +1,208 @@
+#pragma once
+
+#include <napi/napi.h>
+
+#include <gsl/gsl>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace Babylon
+{
+    /// Opcodes of the binary command stream accepted by NativeEngine::submitCommands. Each command is a
+    /// sequence of 32-bit words: the opcode followed by its arguments, in the same order as the arguments
+    /// of the equivalent NativeEngine method. Booleans are 0 or 1, floats are stored as their IEEE-754 bit
+    /// pattern, 64-bit values (blend modes) take two words with the low word first, variable-length arrays
+    /// are prefixed with their element count and native objects (programs, uniforms, textures, vertex
+    /// arrays, frame buffers) are indices into the object array passed alongside the stream.
+    /// Never renumber existing entries; the JavaScript encoder depends on these values.
+    enum class Command : uint32_t
+    {
+        BindVertexArray = 0,    // vertexArray
+        SetProgram = 1,         // program
+        SetState = 2,           // culling, zOffset (float), reverseSide
+        SetZOffset = 3,         // zOffset (float)
+        SetDepthTest = 4,       // depthTest
+        SetDepthWrite = 5,      // enable
+        SetColorWrite = 6,      // enable
+        SetBlendMode = 7,       // blendMode (64-bit)
+        SetMatrix = 8,          // uniform, 16 floats
+        SetMatrix3x3 = 9,       // uniform, 9 floats
+        SetMatrix2x2 = 10,      // uniform, 4 floats
+        SetMatrices = 11,       // uniform, count, count floats
+        SetInt = 12,            // uniform, value (int32)
+        SetIntArray = 13,       // uniform, count, count int32s
+        SetIntArray2 = 14,      // uniform, count, count int32s
+        SetIntArray3 = 15,      // uniform, count, count int32s
+        SetIntArray4 = 16,      // uniform, count, count int32s
+        SetFloatArray = 17,     // uniform, count, count floats
+        SetFloatArray2 = 18,    // uniform, count, count floats
+        SetFloatArray3 = 19,    // uniform, count, count floats
+        SetFloatArray4 = 20,    // uniform, count, count floats
+        SetFloat = 21,          // uniform, 1 float
+        SetFloat2 = 22,         // uniform, 2 floats
+        SetFloat3 = 23,         // uniform, 3 floats
+        SetFloat4 = 24,         // uniform, 4 floats
+        SetTexture = 25,        // uniform, texture
+        SetTextureSampling = 26, // texture, filter
+        SetTextureWrapMode = 27, // texture, addressModeU, addressModeV, addressModeW
+        SetTextureAnisotropicLevel = 28, // texture, level
+        BindFrameBuffer = 29,   // frameBuffer
+        UnbindFrameBuffer = 30, // frameBuffer
+        DrawIndexed = 31,       // fillMode, elementStart, elementCount
+        Draw = 32,              // fillMode, verticesStart, verticesCount
+        Clear = 33,             // flags
+        ClearColor = 34,        // r, g, b, a (floats)
+        ClearDepth = 35,        // depth (float)
+        ClearStencil = 36,      // stencil (int32)
+        SetViewPort = 37,       // x, y, width, height (floats)
+        DrawIndexedInstanced = 38, // fillMode, elementStart, elementCount, instanceCount
+        DrawInstanced = 39,     // fillMode, verticesStart, verticesCount, instanceCount
+    };
+
+    /// Sequential reader over a command stream. Reading past the end of the stream or referencing an object
+    /// outside of the object array throws, so a malformed stream can never read out of bounds.
+    class CommandStreamReader final
+    {
+    public:
+        // objectCache is owned by the caller so that its storage is reused across submissions.
+        CommandStreamReader(gsl::span<const uint32_t> words, Napi::Array objects, std::vector<void*>& objectCache)
+            : m_words{words}
+            , m_objects{objects}
+            , m_objectCache{objectCache}
+        {
+            m_objectCache.assign(m_objects.IsEmpty() ? 0 : m_objects.Length(), nullptr);
+        }
+
+        // Reads a stream whose objects have all been unwrapped by ResolveObjects. Such a reader never calls
+        // into JavaScript, so it can be used on any thread.
+        CommandStreamReader(gsl::span<const uint32_t> words, std::vector<void*>& resolvedObjects)
+            : m_words{words}
+            , m_objectCache{resolvedObjects}
+        {
+        }
+
+        // Unwraps every native object of the object array up front. Entries that are not native objects are
+        // left null, and referencing them from a stream throws.
+        static void ResolveObjects(Napi::Array objects, std::vector<void*>& objectCache)
+        {
+            objectCache.assign(objects.IsEmpty() ? 0 : objects.Length(), nullptr);
+            for (uint32_t index = 0; index < objectCache.size(); ++index)
+            {
+                const auto object = objects.Get(index);
+                if (object.IsExternal())
+                {
+                    objectCache[index] = object.As<Napi::External<void>>().Data();
+                }
+            }
+        }
+
+        bool AtEnd() const
+        {
+            return m_offset == static_cast<size_t>(m_words.size());
+        }
+
+        Command ReadCommand()
+        {
+            return static_cast<Command>(ReadUint32());
+        }
+
+        Command PeekCommand() const
+        {
+            Check(1);
+            return static_cast<Command>(m_words[m_offset]);
+        }
+
+        uint32_t ReadUint32()
+        {
+            Check(1);
+            return m_words[m_offset++];
+        }
+
+        int32_t ReadInt32()
+        {
+            return static_cast<int32_t>(ReadUint32());
+        }
+
+        uint64_t ReadUint64()
+        {
+            const uint64_t low{ReadUint32()};
+            const uint64_t high{ReadUint32()};
+            return low | (high << 32);
+        }
+
+        bool ReadBool()
+        {
+            return ReadUint32() != 0;
+        }
+
+        float ReadFloat()
+        {
+            const uint32_t bits{ReadUint32()};
+            float value{};
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // Returns a view of the next count 32-bit values in the stream.
+        template<typename T>
+        gsl::span<const T> ReadSpan(size_t count)
+        {
+            static_assert(sizeof(T) == sizeof(uint32_t));
+            Check(count);
+            const auto* data = reinterpret_cast<const T*>(m_words.data() + m_offset);
+            m_offset += count;
+            return gsl::make_span(data, count);
+        }
+
+        template<typename T>
+        gsl::span<const T> ReadArray()
+        {
+            return ReadSpan<T>(ReadUint32());
+        }
+
+        // Objects are unwrapped on first use only, as streams typically reference the same few objects many times.
+        template<typename T>
+        T& ReadObject()
+        {
+            const uint32_t index{ReadUint32()};
+            if (index >= m_objectCache.size())
+            {
+                throw std::runtime_error{"Invalid object reference in command stream."};
+            }
+
+            if (m_objectCache[index] == nullptr)
+            {
+                if (m_objects.IsEmpty())
+                {
+                    throw std::runtime_error{"Invalid object reference in command stream."};
+                }
+
+                const Napi::Value object{m_objects.Get(index)};
+                if (!object.IsExternal())
+                {
+                    throw std::runtime_error{"Invalid object reference in command stream."};
+                }
+
+                m_objectCache[index] = object.As<Napi::External<T>>().Data();
+            }
+
+            return *static_cast<T*>(m_objectCache[index]);
+        }
+
+    private:
+        void Check(size_t count) const
+        {
+            if (static_cast<size_t>(m_words.size()) - m_offset < count)
+            {
+                throw std::runtime_error{"Truncated command stream."};
+            }
+        }
+
+        gsl::span<const uint32_t> m_words;
+        Napi::Array m_objects{};
+        std::vector<void*>& m_objectCache;
+        size_t m_offset{};
+    };
+}
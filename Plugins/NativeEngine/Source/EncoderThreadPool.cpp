@@ -0,0 +1,130 @@
+#include "EncoderThreadPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Babylon
+{
+    EncoderThreadPool::~EncoderThreadPool()
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_shutdown = true;
+        }
+        m_jobsQueued.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t EncoderThreadPool::GetMaxConcurrency()
+    {
+        // Matches the default size of the shader compiler pool; submission rarely scales beyond that.
+        constexpr size_t MAX_WORKER_COUNT = 4;
+        const size_t maxEncoders = bgfx::getCaps()->limits.maxEncoders;
+        const size_t hardwareConcurrency = std::thread::hardware_concurrency();
+        return std::min({maxEncoders > 0 ? maxEncoders - 1 : 0, hardwareConcurrency > 1 ? hardwareConcurrency - 1 : 1, MAX_WORKER_COUNT});
+    }
+
+    void EncoderThreadPool::Run(size_t count, const Job& job)
+    {
+        const size_t workerCount = std::min(count, GetMaxConcurrency());
+        if (workerCount == 0)
+        {
+            throw std::runtime_error{"Parallel encoding requires bgfx to be built multithreaded."};
+        }
+
+        EnsureWorkers(workerCount);
+
+        {
+            std::scoped_lock lock{m_mutex};
+            ++m_generation;
+            m_seats = workerCount;
+            m_activeWorkers = workerCount;
+            m_job = &job;
+            m_jobCount = count;
+            m_nextIndex = 0;
+            m_error = nullptr;
+        }
+        m_jobsQueued.notify_all();
+
+        std::unique_lock lock{m_mutex};
+        m_jobsFinished.wait(lock, [this] { return m_activeWorkers == 0; });
+        m_job = nullptr;
+
+        if (m_error != nullptr)
+        {
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+    }
+
+    void EncoderThreadPool::EnsureWorkers(size_t workerCount)
+    {
+        m_workers.reserve(workerCount);
+        while (m_workers.size() < workerCount)
+        {
+            m_workers.emplace_back([this] { WorkerProcedure(); });
+        }
+    }
+
+    void EncoderThreadPool::WorkerProcedure()
+    {
+        uint64_t generation{0};
+
+        std::unique_lock lock{m_mutex};
+        while (true)
+        {
+            m_jobsQueued.wait(lock, [this, &generation] { return m_shutdown || (m_generation != generation && m_seats > 0); });
+            if (m_shutdown)
+            {
+                return;
+            }
+
+            generation = m_generation;
+            --m_seats;
+
+            lock.unlock();
+            RunJobs();
+            lock.lock();
+
+            if (--m_activeWorkers == 0)
+            {
+                m_jobsFinished.notify_all();
+            }
+        }
+    }
+
+    void EncoderThreadPool::RunJobs()
+    {
+        bgfx::Encoder* encoder = bgfx::begin(true);
+        if (encoder == nullptr)
+        {
+            std::scoped_lock lock{m_mutex};
+            if (m_error == nullptr)
+            {
+                m_error = std::make_exception_ptr(std::runtime_error{"No bgfx encoder is available for parallel encoding."});
+            }
+            return;
+        }
+
+        for (size_t index = m_nextIndex++; index < m_jobCount; index = m_nextIndex++)
+        {
+            try
+            {
+                (*m_job)(*encoder, index);
+            }
+            catch (...)
+            {
+                std::scoped_lock lock{m_mutex};
+                if (m_error == nullptr)
+                {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+
+        bgfx::end(encoder);
+    }
+}
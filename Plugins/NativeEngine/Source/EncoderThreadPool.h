@@ -0,0 +1,57 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Babylon
+{
+    /// Worker threads that record render passes in parallel, each into a bgfx encoder of its own. The
+    /// threads are only started the first time they are needed, as most engines never encode in parallel.
+    class EncoderThreadPool final
+    {
+    public:
+        using Job = std::function<void(bgfx::Encoder& encoder, size_t index)>;
+
+        EncoderThreadPool() = default;
+        ~EncoderThreadPool();
+
+        EncoderThreadPool(const EncoderThreadPool&) = delete;
+        EncoderThreadPool& operator=(const EncoderThreadPool&) = delete;
+
+        // The number of jobs that can run at once: one per worker, bounded by the encoders bgfx has left
+        // once the API thread has its own. Zero when bgfx is built single threaded.
+        static size_t GetMaxConcurrency();
+
+        // Calls job for every index below count, spread over the workers, and returns once all calls have
+        // returned. Rethrows the first exception thrown by a call. Must not be called concurrently.
+        void Run(size_t count, const Job& job);
+
+    private:
+        void EnsureWorkers(size_t workerCount);
+        void WorkerProcedure();
+        void RunJobs();
+
+        std::mutex m_mutex{};
+        std::condition_variable m_jobsQueued{};
+        std::condition_variable m_jobsFinished{};
+        bool m_shutdown{false};
+
+        uint64_t m_generation{0};
+        size_t m_seats{0};
+        size_t m_activeWorkers{0};
+        const Job* m_job{nullptr};
+        size_t m_jobCount{0};
+        std::atomic<size_t> m_nextIndex{0};
+        std::exception_ptr m_error{};
+
+        std::vector<std::thread> m_workers{};
+    };
+}
@@ -1,5 +1,7 @@
 #include "NativeEngine.h"
+#include "ImageKernels.h"
 #include "ShaderCompiler.h"
+#include "ShaderCache.h"
 #include <arcana/threading/task.h>
 #include <arcana/threading/task_schedulers.h>
 
@@ -13,6 +15,8 @@
 
 #include <bx/math.h>
 
+#include <chrono>
+#include <memory>
 #include <queue>
 #include <regex>
 #include <sstream>
@@ -69,27 +73,80 @@ namespace Babylon
 
         void FlipY(bimg::ImageContainer* image)
         {
-            uint8_t* bytes = static_cast<uint8_t*>(image->m_data);
-            uint32_t rowCount = image->m_height;
-            uint32_t rowPitch = image->m_size / image->m_height;
+            // Each mip level of the image is flipped separately.
+            for (uint8_t lod = 0; lod < image->m_numMips; lod++)
+            {
+                bimg::ImageMip mip{};
+                if (!bimg::imageGetRawData(*image, 0, lod, image->m_data, image->m_size, mip))
+                {
+                    continue;
+                }
 
-            std::vector<uint8_t> buffer(rowPitch);
+                uint8_t* bytes = const_cast<uint8_t*>(mip.m_data);
+                ImageKernels::FlipRows(bytes, mip.m_width * mip.m_bpp / 8, mip.m_height);
+            }
+        }
 
-            for (size_t row = 0; row < rowCount / 2; row++)
+        ImageKernels::DownsampleFunction GetDownsampleFunction(bimg::TextureFormat::Enum format)
+        {
+            switch (format)
             {
-                auto frontPtr = bytes + (row * rowPitch);
-                auto backPtr = bytes + ((rowCount - row - 1) * rowPitch);
+                case bimg::TextureFormat::RGBA8:
+                    return ImageKernels::DownsampleRgba8;
+                case bimg::TextureFormat::RGBA16F:
+                    return ImageKernels::DownsampleRgba16F;
+                case bimg::TextureFormat::RGBA32F:
+                    return ImageKernels::DownsampleRgba32F;
+                default:
+                    return nullptr;
+            }
+        }
 
-                std::memcpy(buffer.data(), frontPtr, rowPitch);
-                std::memcpy(frontPtr, backPtr, rowPitch);
-                std::memcpy(backPtr, buffer.data(), rowPitch);
+        bimg::ImageContainer* ParseImage(bx::AllocatorI* allocator, gsl::span<const uint8_t> data)
+        {
+            bimg::ImageContainer* image = bimg::imageParse(allocator, data.data(), static_cast<uint32_t>(data.size()));
+            if (image == nullptr)
+            {
+                throw std::runtime_error("Unable to decode image."); // exception will be forwarded to JS
             }
+            return image;
+        }
+
+        // Texture loads are decoded ahead of background loads unless the caller passes false for visible.
+        TextureDecodePool::Priority GetDecodePriority(const Napi::Value& visible)
+        {
+            return visible.IsBoolean() && !visible.As<Napi::Boolean>().Value() ? TextureDecodePool::Priority::Background : TextureDecodePool::Priority::Visible;
         }
 
         void GenerateMips(bx::AllocatorI* allocator, bimg::ImageContainer** image)
         {
             bimg::ImageContainer* input = *image;
 
+            // The most common formats are box filtered directly, each level from the previous one.
+            const auto downsample = GetDownsampleFunction(input->m_format);
+            if (downsample != nullptr)
+            {
+                bimg::ImageContainer* mips = bimg::imageAlloc(allocator, input->m_format, static_cast<uint16_t>(input->m_width), static_cast<uint16_t>(input->m_height), 1, 1, false, true);
+
+                bimg::ImageMip source{};
+                bimg::ImageMip destination{};
+                bimg::imageGetRawData(*input, 0, 0, input->m_data, input->m_size, source);
+                bimg::imageGetRawData(*mips, 0, 0, mips->m_data, mips->m_size, destination);
+                std::memcpy(const_cast<uint8_t*>(destination.m_data), source.m_data, source.m_size);
+                bimg::imageFree(input);
+
+                for (uint8_t lod = 1; lod < mips->m_numMips; lod++)
+                {
+                    source = destination;
+                    bimg::imageGetRawData(*mips, 0, lod, mips->m_data, mips->m_size, destination);
+                    downsample(source.m_data, source.m_width, source.m_height, source.m_width * source.m_bpp / 8,
+                        const_cast<uint8_t*>(destination.m_data), destination.m_width * destination.m_bpp / 8);
+                }
+
+                *image = mips;
+                return;
+            }
+
             bimg::ImageContainer* output = bimg::imageGenerateMips(allocator, *input);
             if (output == nullptr)
             {
@@ -118,10 +175,59 @@ namespace Babylon
             auto mem = bgfx::makeRef(image->m_data, image->m_size, releaseFn, image);
 
             texture->Handle = bgfx::createTexture2D(static_cast<uint16_t>(image->m_width), static_cast<uint16_t>(image->m_height), (image->m_numMips > 1), 1, Cast(image->m_format), BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+            texture->ByteSize = image->m_size;
             texture->Width = image->m_width;
             texture->Height = image->m_height;
         }
 
+        bool IsTextureFormatSupported(bimg::TextureFormat::Enum format)
+        {
+            // Emulated formats are decompressed by bgfx itself when the texture is created.
+            return (bgfx::getCaps()->formats[Cast(format)] & (BGFX_CAPS_FORMAT_TEXTURE_2D | BGFX_CAPS_FORMAT_TEXTURE_2D_EMULATED)) != 0;
+        }
+
+        // Prepares a parsed image for upload as a 2D texture. Block compressed images (from DDS, KTX or PVR
+        // containers) are uploaded as they are, with the mip chain they were authored with: they cannot be
+        // flipped or have mips generated without decompressing them, which would defeat their purpose. Only
+        // compressed formats the renderer cannot sample at all are decompressed to RGBA8.
+        void PrepareImage(bx::AllocatorI* allocator, bimg::ImageContainer** image, bool invertY, bool generateMips)
+        {
+            if (bimg::isCompressed((*image)->m_format))
+            {
+                if (IsTextureFormatSupported((*image)->m_format))
+                {
+                    return;
+                }
+
+                bimg::ImageContainer* rgba = bimg::imageConvert(allocator, bimg::TextureFormat::RGBA8, **image);
+                bimg::imageFree(*image);
+                *image = rgba;
+                if (rgba == nullptr)
+                {
+                    throw std::runtime_error("Unable to decompress image."); // exception will be forwarded to JS
+                }
+            }
+
+            if (invertY)
+            {
+                FlipY(*image);
+            }
+            if (generateMips && (*image)->m_numMips == 1)
+            {
+                GenerateMips(allocator, image);
+            }
+        }
+
+        uint64_t GetImagesByteCount(const std::vector<bimg::ImageContainer*>& images)
+        {
+            uint64_t byteCount{0};
+            for (const auto* image : images)
+            {
+                byteCount += image->m_size;
+            }
+            return byteCount;
+        }
+
         void CreateCubeTextureFromImages(TextureData* texture, const std::vector<bimg::ImageContainer*>& images, bool hasMips)
         {
             const bimg::ImageContainer* firstImage = images.front();
@@ -146,11 +252,169 @@ namespace Babylon
             }
 
             texture->Handle = bgfx::createTextureCube(static_cast<uint16_t>(width), hasMips, 1, format, BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+            texture->ByteSize = totalSize;
             texture->Width = width;
             texture->Height = height;
         }
+
+        uint32_t GetUniformCapacity(const bgfx::UniformInfo& info)
+        {
+            switch (info.type)
+            {
+                case bgfx::UniformType::Vec4:
+                    return 4u * info.num;
+                // 3x3 matrices are passed in with the same 4x4 layout as 4x4 matrices.
+                case bgfx::UniformType::Mat3:
+                case bgfx::UniformType::Mat4:
+                    return 16u * info.num;
+                default:
+                    return 0;
+            }
+        }
+
+        void InitUniformInfos(bgfx::ShaderHandle shader, const std::unordered_map<std::string, uint8_t>& uniformStages, std::unordered_map<std::string, UniformInfo>& uniformInfos, ProgramData& programData)
+        {
+            auto numUniforms = bgfx::getShaderUniforms(shader);
+            std::vector<bgfx::UniformHandle> uniforms{numUniforms};
+            bgfx::getShaderUniforms(shader, uniforms.data(), gsl::narrow_cast<uint16_t>(uniforms.size()));
+
+            for (uint8_t index = 0; index < numUniforms; index++)
+            {
+                bgfx::UniformInfo info{};
+                bgfx::getUniformInfo(uniforms[index], info);
+                auto itStage = uniformStages.find(info.name);
+                uniformInfos[info.name] = {itStage == uniformStages.end() ? uint8_t{} : itStage->second, uniforms[index]};
+                bool YFlip{false};
+                if (!bgfx::getCaps()->originBottomLeft)
+                {
+                    YFlip = (!strcmp(info.name, "projection")) || (!strcmp(info.name, "viewProjection"));
+                }
+                uniformInfos[info.name].YFlip = YFlip;
+
+                // Uniforms used by both the vertex and fragment shader share a single slot.
+                auto slot = std::find_if(programData.Uniforms.Slots.begin(), programData.Uniforms.Slots.end(), [&](const auto& uniformSlot) {
+                    return uniformSlot.Handle.idx == uniforms[index].idx;
+                });
+                if (slot == programData.Uniforms.Slots.end())
+                {
+                    const uint32_t capacity{GetUniformCapacity(info)};
+                    if (capacity == 0)
+                    {
+                        continue;
+                    }
+
+                    ProgramData::UniformSlot uniformSlot{};
+                    uniformSlot.Handle = uniforms[index];
+                    uniformSlot.Offset = static_cast<uint32_t>(programData.Uniforms.Block.size());
+                    uniformSlot.Capacity = capacity;
+                    uniformSlot.ElementStride = capacity / info.num;
+                    uniformSlot.YFlip = YFlip;
+                    programData.Uniforms.Block.resize(programData.Uniforms.Block.size() + capacity);
+                    slot = programData.Uniforms.Slots.insert(programData.Uniforms.Slots.end(), uniformSlot);
+                }
+
+                uniformInfos[info.name].Slot = gsl::narrow_cast<uint16_t>(slot - programData.Uniforms.Slots.begin());
+            }
+        }
+
+        std::unique_ptr<ProgramData> CreateProgramData(ShaderCompiler::BgfxShaderInfo shaderInfo)
+        {
+            std::unique_ptr<ProgramData> programData{std::make_unique<ProgramData>()};
+
+            auto vertexShader = bgfx::createShader(bgfx::copy(shaderInfo.VertexBytes.data(), static_cast<uint32_t>(shaderInfo.VertexBytes.size())));
+            InitUniformInfos(vertexShader, shaderInfo.VertexUniformStages, programData->VertexUniformInfos, *programData);
+            programData->VertexAttributeLocations = std::move(shaderInfo.VertexAttributeLocations);
+
+            auto fragmentShader = bgfx::createShader(bgfx::copy(shaderInfo.FragmentBytes.data(), static_cast<uint32_t>(shaderInfo.FragmentBytes.size())));
+            InitUniformInfos(fragmentShader, shaderInfo.FragmentUniformStages, programData->FragmentUniformInfos, *programData);
+
+            programData->Program = bgfx::createProgram(vertexShader, fragmentShader, true);
+            return programData;
+        }
+
+        constexpr uint32_t INSTANCE_DATA_ELEMENT_SIZE{16};
+        constexpr uint32_t MAX_INSTANCE_DATA_ELEMENTS{4};
+
+        gsl::span<const uint32_t> GetCommandWords(Napi::Value commands)
+        {
+            if (commands.IsTypedArray())
+            {
+                const auto typedArray = commands.As<Napi::TypedArray>();
+                if (typedArray.TypedArrayType() != napi_uint32_array)
+                {
+                    throw Napi::Error::New(commands.Env(), "Commands must be a Uint32Array or an ArrayBuffer.");
+                }
+
+                const auto words = commands.As<Napi::Uint32Array>();
+                return gsl::make_span(words.Data(), words.ElementLength());
+            }
+
+            const auto buffer = commands.As<Napi::ArrayBuffer>();
+            return gsl::make_span(static_cast<const uint32_t*>(buffer.Data()), buffer.ByteLength() / sizeof(uint32_t));
+        }
+
+        // Commands that change state shared by all passes, which passes may only use before any other command.
+        bool IsSerialCommand(Command command)
+        {
+            switch (command)
+            {
+                case Command::SetTextureSampling:
+                case Command::SetTextureWrapMode:
+                case Command::SetTextureAnisotropicLevel:
+                case Command::BindFrameBuffer:
+                case Command::UnbindFrameBuffer:
+                case Command::Clear:
+                case Command::ClearColor:
+                case Command::ClearDepth:
+                case Command::ClearStencil:
+                case Command::SetViewPort:
+                    return true;
+                default:
+                    return false;
+            }
+        }
     }
 
+    // Keeps a JavaScript typed array alive while bgfx references its contents in place of a copy. bgfx
+    // invokes the release callback once the memory has been consumed, possibly on the render thread, so
+    // the reference is released back on the JavaScript thread. Memory released after the runtime has been
+    // destroyed, e.g. by the final frames of bgfx at shutdown, drops the reference without releasing it.
+    class PinnedTypedArray final
+    {
+    public:
+        PinnedTypedArray(JsRuntime& runtime, const Napi::TypedArray& array)
+            : m_dispatcher{runtime.GetWeakDispatcher()}
+            , m_reference{Napi::Persistent(array)}
+            , m_data{array.As<Napi::Uint8Array>().Data()}
+            , m_byteLength{static_cast<uint32_t>(array.ByteLength())}
+        {
+        }
+
+        // Transfers ownership of the pinned array to the returned bgfx memory.
+        static const bgfx::Memory* MakeRef(std::unique_ptr<PinnedTypedArray> pinned)
+        {
+            uint8_t* data = pinned->m_data;
+            const uint32_t byteLength = pinned->m_byteLength;
+            return bgfx::makeRef(
+                data, byteLength, [](void*, void* userData) {
+                    auto* pinnedArray = static_cast<PinnedTypedArray*>(userData);
+                    if (!pinnedArray->m_dispatcher.Dispatch([pinnedArray](Napi::Env) { delete pinnedArray; }))
+                    {
+                        // The environment of the reference is gone along with the runtime.
+                        pinnedArray->m_reference.SuppressDestruct();
+                        delete pinnedArray;
+                    }
+                },
+                pinned.release());
+        }
+
+    private:
+        JsRuntime::WeakDispatcher m_dispatcher;
+        Napi::Reference<Napi::TypedArray> m_reference;
+        uint8_t* m_data;
+        uint32_t m_byteLength;
+    };
+
     template<typename Handle1T, typename Handle2T>
     class VariantHandleHolder
     {
@@ -174,9 +438,11 @@ namespace Babylon
     class IndexBufferData final : private VariantHandleHolder<bgfx::IndexBufferHandle, bgfx::DynamicIndexBufferHandle>
     {
     public:
-        IndexBufferData(const Napi::TypedArray& bytes, uint16_t flags, bool dynamic)
+        IndexBufferData(const Napi::TypedArray& bytes, uint16_t flags, bool dynamic, std::unique_ptr<PinnedTypedArray> pinnedBytes = {})
         {
-            const bgfx::Memory* memory = bgfx::copy(bytes.As<Napi::Uint8Array>().Data(), static_cast<uint32_t>(bytes.ByteLength()));
+            const bgfx::Memory* memory = pinnedBytes
+                ? PinnedTypedArray::MakeRef(std::move(pinnedBytes))
+                : bgfx::copy(bytes.As<Napi::Uint8Array>().Data(), static_cast<uint32_t>(bytes.ByteLength()));
             if (!dynamic)
             {
                 m_handle = bgfx::createIndexBuffer(memory, flags);
@@ -211,13 +477,13 @@ namespace Babylon
             DoForHandleTypes(nonDynamic, dynamic);
         }
 
-        void SetBgfxIndexBuffer(uint32_t firstIndex, uint32_t numIndices) const
+        void SetBgfxIndexBuffer(RenderStateCache& renderStateCache, uint32_t firstIndex, uint32_t numIndices) const
         {
-            const auto nonDynamic = [firstIndex, numIndices](auto handle) {
-                bgfx::setIndexBuffer(handle, firstIndex, numIndices);
+            const auto nonDynamic = [&renderStateCache, firstIndex, numIndices](auto handle) {
+                renderStateCache.SetIndexBuffer(handle, firstIndex, numIndices);
             };
-            const auto dynamic = [firstIndex, numIndices](auto handle) {
-                bgfx::setIndexBuffer(handle, firstIndex, numIndices);
+            const auto dynamic = [&renderStateCache, firstIndex, numIndices](auto handle) {
+                renderStateCache.SetIndexBuffer(handle, firstIndex, numIndices);
             };
             DoForHandleTypes(nonDynamic, dynamic);
         }
@@ -229,14 +495,14 @@ namespace Babylon
         VertexBufferData(const Napi::Uint8Array& bytes, bool dynamic)
             : m_bytes{bytes.Data(), bytes.Data() + bytes.ByteLength()}
         {
-            if (!dynamic)
-            {
-                m_handle = bgfx::VertexBufferHandle{bgfx::kInvalidHandle};
-            }
-            else
-            {
-                m_handle = bgfx::DynamicVertexBufferHandle{bgfx::kInvalidHandle};
-            }
+            Initialize(dynamic);
+        }
+
+        // The buffer references the pinned array directly rather than a copy of its contents.
+        VertexBufferData(std::unique_ptr<PinnedTypedArray> pinnedBytes, bool dynamic)
+            : m_pinnedBytes{std::move(pinnedBytes)}
+        {
+            Initialize(dynamic);
         }
 
         ~VertexBufferData()
@@ -264,14 +530,7 @@ namespace Babylon
                     return;
                 }
 
-                const bgfx::Memory* memory = bgfx::makeRef(
-                    m_bytes.data(), static_cast<uint32_t>(m_bytes.size()), [](void*, void* userData) {
-                        auto* bytes = reinterpret_cast<std::vector<uint8_t>*>(userData);
-                        bytes->clear();
-                    },
-                    &m_bytes);
-
-                m_handle = bgfx::createVertexBuffer(memory, layout);
+                m_handle = bgfx::createVertexBuffer(MakeMemory(), layout);
             };
             const auto dynamic = [&layout, this](auto handle) {
                 if (handle.idx != bgfx::kInvalidHandle)
@@ -279,14 +538,7 @@ namespace Babylon
                     return;
                 }
 
-                const bgfx::Memory* memory = bgfx::makeRef(
-                    m_bytes.data(), static_cast<uint32_t>(m_bytes.size()), [](void*, void* userData) {
-                        auto* bytes = reinterpret_cast<std::vector<uint8_t>*>(userData);
-                        bytes->clear();
-                    },
-                    &m_bytes);
-
-                m_handle = bgfx::createDynamicVertexBuffer(memory, layout);
+                m_handle = bgfx::createDynamicVertexBuffer(MakeMemory(), layout);
             };
             DoForHandleTypes(nonDynamic, dynamic);
         }
@@ -312,21 +564,112 @@ namespace Babylon
             DoForHandleTypes(nonDynamic, dynamic);
         }
 
-        void SetAsBgfxVertexBuffer(uint8_t index, uint32_t startVertex, bgfx::VertexLayoutHandle layout) const
+        void SetAsBgfxInstanceDataBuffer(bgfx::Encoder& encoder, uint32_t startInstance, uint32_t numInstances) const
+        {
+            const auto nonDynamic = [&encoder, startInstance, numInstances](auto handle) {
+                encoder.setInstanceDataBuffer(handle, startInstance, numInstances);
+            };
+            const auto dynamic = [&encoder, startInstance, numInstances](auto handle) {
+                encoder.setInstanceDataBuffer(handle, startInstance, numInstances);
+            };
+            DoForHandleTypes(nonDynamic, dynamic);
+        }
+
+        void SetAsBgfxVertexBuffer(RenderStateCache& renderStateCache, uint8_t index, uint32_t startVertex, bgfx::VertexLayoutHandle layout) const
         {
-            const auto nonDynamic = [index, startVertex, layout](auto handle) {
-                bgfx::setVertexBuffer(index, handle, startVertex, UINT32_MAX, layout);
+            const auto nonDynamic = [&renderStateCache, index, startVertex, layout](auto handle) {
+                renderStateCache.SetVertexBuffer(index, handle, startVertex, layout);
             };
-            const auto dynamic = [index, startVertex, layout](auto handle) {
-                bgfx::setVertexBuffer(index, handle, startVertex, UINT32_MAX, layout);
+            const auto dynamic = [&renderStateCache, index, startVertex, layout](auto handle) {
+                renderStateCache.SetVertexBuffer(index, handle, startVertex, layout);
             };
             DoForHandleTypes(nonDynamic, dynamic);
         }
 
     private:
+        void Initialize(bool dynamic)
+        {
+            if (!dynamic)
+            {
+                m_handle = bgfx::VertexBufferHandle{bgfx::kInvalidHandle};
+            }
+            else
+            {
+                m_handle = bgfx::DynamicVertexBufferHandle{bgfx::kInvalidHandle};
+            }
+        }
+
+        const bgfx::Memory* MakeMemory()
+        {
+            if (m_pinnedBytes)
+            {
+                return PinnedTypedArray::MakeRef(std::move(m_pinnedBytes));
+            }
+
+            // The bytes are moved out of the buffer, as bgfx may release the memory from its render thread after
+            // the buffer itself has been deleted.
+            auto* bytes = new std::vector<uint8_t>{std::move(m_bytes)};
+            m_bytes.clear();
+            return bgfx::makeRef(
+                bytes->data(), static_cast<uint32_t>(bytes->size()), [](void*, void* userData) {
+                    delete static_cast<std::vector<uint8_t>*>(userData);
+                },
+                bytes);
+        }
+
         std::vector<uint8_t> m_bytes{};
+        std::unique_ptr<PinnedTypedArray> m_pinnedBytes{};
     };
 
+    void VertexArray::UpdateVertexBuffers()
+    {
+        ReleaseVertexBuffers();
+
+        struct Stream
+        {
+            const VertexBufferData* data{};
+            uint32_t byteStride{};
+            uint32_t startVertex{};
+            std::vector<VertexLayoutCache::Attribute> attributes{};
+        };
+
+        std::vector<Stream> streams{};
+        for (const auto& [location, attribute] : vertexAttributes)
+        {
+            const uint32_t startVertex = attribute.byteOffset / attribute.byteStride;
+            auto it = std::find_if(streams.begin(), streams.end(), [&attribute, startVertex](const Stream& stream) {
+                return stream.data == attribute.data && stream.byteStride == attribute.byteStride && stream.startVertex == startVertex;
+            });
+
+            if (it == streams.end())
+            {
+                it = streams.insert(streams.end(), Stream{attribute.data, attribute.byteStride, startVertex});
+            }
+
+            const auto offset = static_cast<uint16_t>(attribute.byteOffset % attribute.byteStride);
+            it->attributes.push_back({static_cast<bgfx::Attrib::Enum>(location), attribute.numElements, attribute.type, attribute.normalized, offset});
+        }
+
+        vertexBuffers.reserve(streams.size());
+        for (const auto& stream : streams)
+        {
+            const auto layoutHandle = vertexLayoutCache->Acquire(stream.attributes, static_cast<uint16_t>(stream.byteStride));
+            vertexBuffers.push_back({stream.data, stream.startVertex, layoutHandle});
+        }
+
+        vertexBuffersDirty = false;
+    }
+
+    void VertexArray::ReleaseVertexBuffers()
+    {
+        for (const auto& vertexBuffer : vertexBuffers)
+        {
+            vertexLayoutCache->Release(vertexBuffer.vertexLayoutHandle);
+        }
+
+        vertexBuffers.clear();
+    }
+
     void NativeEngine::Initialize(Napi::Env env, bool autoRender)
     {
         // Initialize the JavaScript side.
@@ -350,6 +693,8 @@ namespace Babylon
                 InstanceMethod("recordVertexBuffer", &NativeEngine::RecordVertexBuffer),
                 InstanceMethod("updateDynamicVertexBuffer", &NativeEngine::UpdateDynamicVertexBuffer),
                 InstanceMethod("createProgram", &NativeEngine::CreateProgram),
+                InstanceMethod("createProgramAsync", &NativeEngine::CreateProgramAsync),
+                InstanceMethod("getShaderCompilerStatistics", &NativeEngine::GetShaderCompilerStatistics),
                 InstanceMethod("getUniforms", &NativeEngine::GetUniforms),
                 InstanceMethod("getAttributes", &NativeEngine::GetAttributes),
                 InstanceMethod("setProgram", &NativeEngine::SetProgram),
@@ -383,6 +728,12 @@ namespace Babylon
                 InstanceMethod("loadTexture", &NativeEngine::LoadTexture),
                 InstanceMethod("loadCubeTexture", &NativeEngine::LoadCubeTexture),
                 InstanceMethod("loadCubeTextureWithMips", &NativeEngine::LoadCubeTextureWithMips),
+                InstanceMethod("setTextureDecodeOptions", &NativeEngine::SetTextureDecodeOptions),
+                InstanceMethod("getTextureDecodeStatistics", &NativeEngine::GetTextureDecodeStatistics),
+                InstanceMethod("setTextureStreamingOptions", &NativeEngine::SetTextureStreamingOptions),
+                InstanceMethod("setTextureTargetSize", &NativeEngine::SetTextureTargetSize),
+                InstanceMethod("setTextureResidencyOptions", &NativeEngine::SetTextureResidencyOptions),
+                InstanceMethod("getTextureResidencyStatistics", &NativeEngine::GetTextureResidencyStatistics),
                 InstanceMethod("getTextureWidth", &NativeEngine::GetTextureWidth),
                 InstanceMethod("getTextureHeight", &NativeEngine::GetTextureHeight),
                 InstanceMethod("setTextureSampling", &NativeEngine::SetTextureSampling),
@@ -394,8 +745,11 @@ namespace Babylon
                 InstanceMethod("deleteFramebuffer", &NativeEngine::DeleteFrameBuffer),
                 InstanceMethod("bindFramebuffer", &NativeEngine::BindFrameBuffer),
                 InstanceMethod("unbindFramebuffer", &NativeEngine::UnbindFrameBuffer),
+                InstanceMethod("getRenderTargetPoolStatistics", &NativeEngine::GetRenderTargetPoolStatistics),
                 InstanceMethod("drawIndexed", &NativeEngine::DrawIndexed),
+                InstanceMethod("drawIndexedInstanced", &NativeEngine::DrawIndexedInstanced),
                 InstanceMethod("draw", &NativeEngine::Draw),
+                InstanceMethod("drawInstanced", &NativeEngine::DrawInstanced),
                 InstanceMethod("clear", &NativeEngine::Clear),
                 InstanceMethod("clearColor", &NativeEngine::ClearColor),
                 InstanceMethod("clearDepth", &NativeEngine::ClearDepth),
@@ -405,6 +759,9 @@ namespace Babylon
                 InstanceMethod("setViewPort", &NativeEngine::SetViewPort),
                 InstanceMethod("getFramebufferData", &NativeEngine::GetFramebufferData),
                 InstanceMethod("getRenderAPI", &NativeEngine::GetRenderAPI),
+                InstanceMethod("submitCommands", &NativeEngine::SubmitCommands),
+                InstanceMethod("submitCommandPasses", &NativeEngine::SubmitCommandPasses),
+                InstanceMethod("getRenderStateStatistics", &NativeEngine::GetRenderStateStatistics),
 
                 InstanceValue("TEXTURE_NEAREST_NEAREST", Napi::Number::From(env, TextureSampling::NEAREST_NEAREST)),
                 InstanceValue("TEXTURE_LINEAR_LINEAR", Napi::Number::From(env, TextureSampling::LINEAR_LINEAR)),
@@ -476,10 +833,14 @@ namespace Babylon
         : Napi::ObjectWrap<NativeEngine>{info}
         , AutomaticRenderingEnabled{info.This().As<Napi::Object>().Get(JS_AUTO_RENDER_PROPERTY_NAME).ToBoolean()}
         , RuntimeScheduler{runtime}
+        , FrameScheduler{runtime, JsRuntime::DispatchPriority::Frame}
         , m_runtime{runtime}
         , m_graphicsImpl{Graphics::Impl::GetFromJavaScript(info.Env())}
-        , m_engineState{BGFX_STATE_DEFAULT}
+        , m_encoderResetCallbackTicket{m_graphicsImpl.AddEncoderResetCallback(&RenderStateCache::NotifyDiscarded)}
     {
+        m_frameBufferManager.SetCompositor([this](bgfx::ViewId viewId, bgfx::TextureHandle texture) {
+            m_backBufferCompositor.Composite(viewId, texture);
+        });
     }
 
     NativeEngine::~NativeEngine()
@@ -492,6 +853,10 @@ namespace Babylon
     {
         return arcana::make_task(scheduler, m_cancelSource, [this] {
             m_isRenderScheduled = false;
+            m_programCreationBudget = MAX_PROGRAM_CREATIONS_PER_FRAME;
+            m_encoderState.StateCache.Reset();
+            m_textureResidencyManager.Update(m_textureStreamer);
+            GetFrameBufferManager().SetBackBuffer(m_graphicsImpl.GetBackBuffer());
 
             if (!m_requestAnimationFrameCallback.IsEmpty())
             {
@@ -499,7 +864,9 @@ namespace Babylon
                 // so we need to clear out the regular RequestAnimationFrame callback to make sure we don't incorrectly
                 // call it when we have transitioned to the XR RequestAnimationFrame.
                 auto callback{std::move(m_requestAnimationFrameCallback)};
+                const auto scriptStart = std::chrono::steady_clock::now();
                 callback({});
+                m_graphicsImpl.AddScriptTime(std::chrono::steady_clock::now() - scriptStart);
             }
 
             GetFrameBufferManager().Reset();
@@ -519,12 +886,13 @@ namespace Babylon
                 }
                 else
                 {
-                    m_graphicsImpl.AddRenderWorkTask(GetRequestAnimationFrameTask(RuntimeScheduler));
+                    m_graphicsImpl.AddRenderWorkTask(GetRequestAnimationFrameTask(FrameScheduler));
                 }
             });
             if (AutomaticRenderingEnabled)
             {
-                Dispatch([this] {
+                // Rendering runs the frame callbacks inline, so it gets their priority.
+                FrameScheduler([this] {
                     m_graphicsImpl.RenderCurrentFrame();
                 });
             }
@@ -536,12 +904,32 @@ namespace Babylon
         return m_frameBufferManager;
     }
 
+    void NativeEngine::ScheduleTextureStreaming()
+    {
+        if (!m_isTextureStreamingScheduled.exchange(true))
+        {
+            // Each step runs after a frame has been rendered, like the texture creation itself, so a frame
+            // must be coming even if nothing else changes. Rendering is scheduled from the JavaScript thread.
+            arcana::make_task(RuntimeScheduler, m_cancelSource, [this] { ScheduleRender(); });
+            m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [this] {
+                m_isTextureStreamingScheduled = false;
+                m_textureStreamer.Step();
+                if (m_textureStreamer.HasPendingWork())
+                {
+                    ScheduleTextureStreaming();
+                }
+            });
+        }
+    }
+
     void NativeEngine::Dispose()
     {
         m_cancelSource.cancel();
 
         // This collection contains bgfx data, so it must be cleared before bgfx::shutdown is called.
         m_programDataCollection.clear();
+        m_backBufferCompositor.Destroy();
+        m_frameBufferManager.Dispose();
     }
 
     void NativeEngine::Dispose(const Napi::CallbackInfo& /*info*/)
@@ -570,27 +958,44 @@ namespace Babylon
 
     Napi::Value NativeEngine::CreateVertexArray(const Napi::CallbackInfo& info)
     {
-        return Napi::External<VertexArray>::New(info.Env(), new VertexArray{});
+        return Napi::External<VertexArray>::New(info.Env(), new VertexArray{m_vertexLayoutCache});
     }
 
     void NativeEngine::DeleteVertexArray(const Napi::CallbackInfo& info)
     {
-        delete info[0].As<Napi::External<VertexArray>>().Data();
+        auto* vertexArray = info[0].As<Napi::External<VertexArray>>().Data();
+        m_dirtyVertexArrays.erase(vertexArray);
+        delete vertexArray;
     }
 
     void NativeEngine::BindVertexArray(const Napi::CallbackInfo& info)
     {
-        const auto& vertexArray = *(info[0].As<Napi::External<VertexArray>>().Data());
+        BindVertexArray(m_encoderState, *info[0].As<Napi::External<VertexArray>>().Data());
+    }
 
+    void NativeEngine::BindVertexArray(EncoderState& state, VertexArray& vertexArray)
+    {
         // a vertex array might not have an index buffer associated with
-        m_currentBoundIndexBuffer = vertexArray.indexBuffer.data;
+        state.CurrentBoundIndexBuffer = vertexArray.indexBuffer.data;
+        state.CurrentBoundInstanceBuffer = vertexArray.instanceBuffer;
+
+        if (vertexArray.vertexBuffersDirty)
+        {
+            // Dirty vertex arrays are all updated before passes are encoded.
+            assert(!state.PassState.has_value());
+            vertexArray.UpdateVertexBuffers();
+            m_dirtyVertexArrays.erase(&vertexArray);
+        }
 
         const auto& vertexBuffers = vertexArray.vertexBuffers;
-        for (auto vertexBufferPair : vertexBuffers)
+        for (size_t stream = 0; stream < vertexBuffers.size(); ++stream)
         {
-            const auto& vertexBuffer = vertexBufferPair.second;
-            vertexBuffer.data->SetAsBgfxVertexBuffer(static_cast<uint8_t>(vertexBufferPair.first), vertexBuffer.startVertex, vertexBuffer.vertexLayoutHandle);
+            const auto& vertexBuffer = vertexBuffers[stream];
+            vertexBuffer.data->SetAsBgfxVertexBuffer(state.StateCache, static_cast<uint8_t>(stream), vertexBuffer.startVertex, vertexBuffer.vertexLayoutHandle);
         }
+
+        // Streams are numbered from zero for every vertex array, so any left over from a previous one must be unbound.
+        state.StateCache.DisableVertexBuffers(static_cast<uint8_t>(vertexBuffers.size()));
     }
 
     Napi::Value NativeEngine::CreateIndexBuffer(const Napi::CallbackInfo& info)
@@ -598,9 +1003,13 @@ namespace Babylon
         const Napi::TypedArray data = info[0].As<Napi::TypedArray>();
         const bool dynamic = info[1].As<Napi::Boolean>().Value();
 
+        // Static buffers may reference the JavaScript data directly, in which case it must not be modified afterwards.
+        const bool pinData = !dynamic && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+
         const uint16_t flags = data.TypedArrayType() == napi_typedarray_type::napi_uint16_array ? 0 : BGFX_BUFFER_INDEX32;
 
-        return Napi::External<IndexBufferData>::New(info.Env(), new IndexBufferData(data, flags, dynamic));
+        auto pinnedData = pinData ? std::make_unique<PinnedTypedArray>(m_runtime, data) : nullptr;
+        return Napi::External<IndexBufferData>::New(info.Env(), new IndexBufferData(data, flags, dynamic, std::move(pinnedData)));
     }
 
     void NativeEngine::DeleteIndexBuffer(const Napi::CallbackInfo& info)
@@ -625,6 +1034,7 @@ namespace Babylon
         const uint32_t startingIdx = info[2].As<Napi::Number>().Uint32Value();
 
         indexBufferData.Update(info.Env(), data, startingIdx);
+        RenderStateCache::NotifyDynamicBufferUpdated();
     }
 
     Napi::Value NativeEngine::CreateVertexBuffer(const Napi::CallbackInfo& info)
@@ -632,6 +1042,13 @@ namespace Babylon
         const Napi::Uint8Array data = info[0].As<Napi::Uint8Array>();
         const bool dynamic = info[1].As<Napi::Boolean>().Value();
 
+        // Static buffers may reference the JavaScript data directly, in which case it must not be modified afterwards.
+        const bool pinData = !dynamic && info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+        if (pinData)
+        {
+            return Napi::External<VertexBufferData>::New(info.Env(), new VertexBufferData(std::make_unique<PinnedTypedArray>(m_runtime, data), dynamic));
+        }
+
         return Napi::External<VertexBufferData>::New(info.Env(), new VertexBufferData(data, dynamic));
     }
 
@@ -662,9 +1079,55 @@ namespace Babylon
         vertexLayout.m_stride = static_cast<uint16_t>(byteStride);
         vertexLayout.end();
 
+        // A divisor of 1 marks a per-instance attribute. bgfx has no notion of a divisor greater than 1.
+        const uint32_t divisor = info[8].IsUndefined() ? 0 : info[8].As<Napi::Number>().Uint32Value();
+        if (divisor > 1)
+        {
+            throw Napi::Error::New(info.Env(), "Instance divisors greater than 1 are not supported.");
+        }
+
         vertexBufferData->EnsureFinalized(info.Env(), vertexLayout);
 
-        vertexArray.vertexBuffers[location] = {vertexBufferData, byteOffset / byteStride, bgfx::createVertexLayout(vertexLayout)};
+        if (divisor == 1)
+        {
+            RecordInstanceAttribute(info.Env(), vertexArray, *vertexBufferData, location, byteOffset, byteStride);
+            return;
+        }
+
+        vertexArray.vertexAttributes[location] = {vertexBufferData, byteOffset, byteStride, static_cast<uint8_t>(numElements), attribType, normalized};
+        vertexArray.vertexBuffersDirty = true;
+        m_dirtyVertexArrays.insert(&vertexArray);
+    }
+
+    void NativeEngine::RecordInstanceAttribute(Napi::Env env, VertexArray& vertexArray, const VertexBufferData& vertexBufferData, uint32_t location, uint32_t byteOffset, uint32_t byteStride)
+    {
+        // Instance attributes are assigned to the highest locations by the shader compiler, starting with the
+        // first instance data element at TexCoord7, and are read from consecutive 16-byte elements of each instance.
+        const uint32_t element = static_cast<uint32_t>(bgfx::Attrib::TexCoord7) - location;
+        if (location > static_cast<uint32_t>(bgfx::Attrib::TexCoord7) || element >= MAX_INSTANCE_DATA_ELEMENTS)
+        {
+            throw Napi::Error::New(env, "Attribute cannot be used as a per-instance attribute.");
+        }
+
+        if (byteStride % INSTANCE_DATA_ELEMENT_SIZE != 0 || byteOffset < element * INSTANCE_DATA_ELEMENT_SIZE)
+        {
+            throw Napi::Error::New(env, "Per-instance attributes must be tightly packed 16-byte elements.");
+        }
+
+        // bgfx addresses instance data in whole instances.
+        const uint32_t instanceByteOffset = byteOffset - element * INSTANCE_DATA_ELEMENT_SIZE;
+        if (instanceByteOffset % byteStride != 0)
+        {
+            throw Napi::Error::New(env, "Per-instance data must start on an instance boundary.");
+        }
+
+        auto& instanceBuffer = vertexArray.instanceBuffer;
+        if (instanceBuffer.data != nullptr && (instanceBuffer.data != &vertexBufferData || instanceBuffer.byteOffset != instanceByteOffset || instanceBuffer.byteStride != byteStride))
+        {
+            throw Napi::Error::New(env, "All per-instance attributes of a vertex array must share a single buffer.");
+        }
+
+        instanceBuffer = {&vertexBufferData, instanceByteOffset, byteStride};
     }
 
     void NativeEngine::UpdateDynamicVertexBuffer(const Napi::CallbackInfo& info)
@@ -680,57 +1143,110 @@ namespace Babylon
         }
 
         vertexBufferData.Update(info.Env(), data, byteOffset, byteLength);
+        RenderStateCache::NotifyDynamicBufferUpdated();
     }
 
     Napi::Value NativeEngine::CreateProgram(const Napi::CallbackInfo& info)
     {
-        const std::string vertexSource{info[0].As<Napi::String>().Utf8Value()};
-        const std::string fragmentSource{info[1].As<Napi::String>().Utf8Value()};
+        std::string vertexSource{info[0].As<Napi::String>().Utf8Value()};
+        std::string fragmentSource{info[1].As<Napi::String>().Utf8Value()};
 
-        std::unique_ptr<ProgramData> programData{std::make_unique<ProgramData>()};
         ShaderCompiler::BgfxShaderInfo shaderInfo{};
-        
+
         try
         {
-            shaderInfo = m_shaderCompiler.Compile(vertexSource, fragmentSource);
+            shaderInfo = m_shaderCompilerPool.Compile(std::move(vertexSource), std::move(fragmentSource));
         }
         catch (const std::exception& ex)
         {
             throw Napi::Error::New(info.Env(), ex.what());
         }
 
-        static auto InitUniformInfos{[](bgfx::ShaderHandle shader, const std::unordered_map<std::string, uint8_t>& uniformStages, std::unordered_map<std::string, UniformInfo>& uniformInfos) {
-            auto numUniforms = bgfx::getShaderUniforms(shader);
-            std::vector<bgfx::UniformHandle> uniforms{numUniforms};
-            bgfx::getShaderUniforms(shader, uniforms.data(), gsl::narrow_cast<uint16_t>(uniforms.size()));
+        return WrapProgramData(info.Env(), CreateProgramData(std::move(shaderInfo)));
+    }
 
-            for (uint8_t index = 0; index < numUniforms; index++)
-            {
-                bgfx::UniformInfo info{};
-                bgfx::getUniformInfo(uniforms[index], info);
-                auto itStage = uniformStages.find(info.name);
-                uniformInfos[info.name] = {itStage == uniformStages.end() ? uint8_t{} : itStage->second, uniforms[index]};
-                bool YFlip{false};
-                if (!bgfx::getCaps()->originBottomLeft)
+    Napi::Value NativeEngine::CreateProgramAsync(const Napi::CallbackInfo& info)
+    {
+        std::string vertexSource{info[0].As<Napi::String>().Utf8Value()};
+        std::string fragmentSource{info[1].As<Napi::String>().Utf8Value()};
+
+        // Programs the caller needs in order to draw the current frame are compiled before speculative ones.
+        const auto priority = info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value() ? ShaderCompilerPool::Priority::Frame : ShaderCompilerPool::Priority::Background;
+
+        auto deferred{Napi::Promise::Deferred::New(info.Env())};
+        auto promise{deferred.Promise()};
+
+        // Shader translation does not touch bgfx, so it runs on the compiler pool. Only the creation of the
+        // bgfx shaders and program is synchronized with rendering.
+        m_shaderCompilerPool.CompileAsync(std::move(vertexSource), std::move(fragmentSource), priority)
+            .then(RuntimeScheduler, m_cancelSource, [this](const ShaderCompiler::BgfxShaderInfo& shaderInfo) {
+                return CreateProgramDataAsync(std::make_shared<ShaderCompiler::BgfxShaderInfo>(shaderInfo));
+            })
+            .then(RuntimeScheduler, m_cancelSource, [this, env{info.Env()}, deferred{std::move(deferred)}](arcana::expected<std::unique_ptr<ProgramData>, std::exception_ptr> result) {
+                if (result.has_error())
                 {
-                    YFlip = (!strcmp(info.name, "projection")) || (!strcmp(info.name, "viewProjection"));
+                    try
+                    {
+                        std::rethrow_exception(result.error());
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        deferred.Reject(Napi::Error::New(env, ex.what()).Value());
+                    }
+                    catch (...)
+                    {
+                        deferred.Reject(Napi::Error::New(env, "Unable to create program.").Value());
+                    }
                 }
-                uniformInfos[info.name].YFlip = YFlip;
+                else
+                {
+                    deferred.Resolve(WrapProgramData(env, std::move(result.value())));
+                }
+            });
+
+        return std::move(promise);
+    }
+
+    arcana::task<std::unique_ptr<ProgramData>, std::exception_ptr> NativeEngine::CreateProgramDataAsync(std::shared_ptr<ShaderCompiler::BgfxShaderInfo> shaderInfo)
+    {
+        ScheduleRender();
+        return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [this, shaderInfo{std::move(shaderInfo)}]() {
+            // Over budget for this frame; try again after the next one.
+            if (m_programCreationBudget == 0)
+            {
+                return arcana::make_task(RuntimeScheduler, m_cancelSource, [this, shaderInfo]() {
+                    return CreateProgramDataAsync(shaderInfo);
+                });
             }
-        }};
 
-        auto vertexShader = bgfx::createShader(bgfx::copy(shaderInfo.VertexBytes.data(), static_cast<uint32_t>(shaderInfo.VertexBytes.size())));
-        InitUniformInfos(vertexShader, shaderInfo.VertexUniformStages, programData->VertexUniformInfos);
-        programData->VertexAttributeLocations = std::move(shaderInfo.VertexAttributeLocations);
+            --m_programCreationBudget;
+            return arcana::task_from_result<std::exception_ptr>(CreateProgramData(std::move(*shaderInfo)));
+        });
+    }
+
+    Napi::Value NativeEngine::GetShaderCompilerStatistics(const Napi::CallbackInfo& info)
+    {
+        const auto statistics = m_shaderCompilerPool.GetStatistics();
+
+        auto latencyHistogram = Napi::Array::New(info.Env(), statistics.LatencyHistogram.size());
+        for (uint32_t index = 0; index < statistics.LatencyHistogram.size(); ++index)
+        {
+            latencyHistogram[index] = Napi::Value::From(info.Env(), statistics.LatencyHistogram[index]);
+        }
 
-        auto fragmentShader = bgfx::createShader(bgfx::copy(shaderInfo.FragmentBytes.data(), static_cast<uint32_t>(shaderInfo.FragmentBytes.size())));
-        InitUniformInfos(fragmentShader, shaderInfo.FragmentUniformStages, programData->FragmentUniformInfos);
+        auto result = Napi::Object::New(info.Env());
+        result.Set("queueDepth", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.QueueDepth)));
+        result.Set("inFlight", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.InFlight)));
+        result.Set("latencyHistogram", latencyHistogram);
+        return std::move(result);
+    }
 
-        programData->Program = bgfx::createProgram(vertexShader, fragmentShader, true);
+    Napi::Value NativeEngine::WrapProgramData(Napi::Env env, std::unique_ptr<ProgramData> programData)
+    {
         auto* rawProgramData = programData.get();
         auto ticket = m_programDataCollection.insert(std::move(programData));
         auto finalizer = [ticket = std::move(ticket)](Napi::Env, ProgramData*) {};
-        return Napi::External<ProgramData>::New(info.Env(), rawProgramData, std::move(finalizer));
+        return Napi::External<ProgramData>::New(env, rawProgramData, std::move(finalizer));
     }
 
     Napi::Value NativeEngine::GetUniforms(const Napi::CallbackInfo& info)
@@ -786,8 +1302,12 @@ namespace Babylon
 
     void NativeEngine::SetProgram(const Napi::CallbackInfo& info)
     {
-        auto program = info[0].As<Napi::External<ProgramData>>().Data();
-        m_currentProgram = program;
+        SetProgram(m_encoderState, *info[0].As<Napi::External<ProgramData>>().Data());
+    }
+
+    void NativeEngine::SetProgram(EncoderState& state, ProgramData& program)
+    {
+        state.CurrentProgram = &program;
     }
 
     void NativeEngine::SetState(const Napi::CallbackInfo& info)
@@ -795,28 +1315,33 @@ namespace Babylon
         const auto culling = info[0].As<Napi::Boolean>().Value();
         const auto reverseSide = info[2].As<Napi::Boolean>().Value();
 
-        m_engineState &= ~BGFX_STATE_CULL_MASK;
-        if (reverseSide)
-        {
-            m_engineState &= ~BGFX_STATE_FRONT_CCW;
-
+        // TODO: zOffset
+        //const auto zOffset = info[1].As<Napi::Number>().FloatValue();
+
+        SetState(m_encoderState, culling, reverseSide);
+    }
+
+    void NativeEngine::SetState(EncoderState& state, bool culling, bool reverseSide)
+    {
+        state.EngineState &= ~BGFX_STATE_CULL_MASK;
+        if (reverseSide)
+        {
+            state.EngineState &= ~BGFX_STATE_FRONT_CCW;
+
             if (culling)
             {
-                m_engineState |= BGFX_STATE_CULL_CW;
+                state.EngineState |= BGFX_STATE_CULL_CW;
             }
         }
         else
         {
-            m_engineState |= BGFX_STATE_FRONT_CCW;
+            state.EngineState |= BGFX_STATE_FRONT_CCW;
 
             if (culling)
             {
-                m_engineState |= BGFX_STATE_CULL_CCW;
+                state.EngineState |= BGFX_STATE_CULL_CCW;
             }
         }
-
-        // TODO: zOffset
-        //const auto zOffset = info[1].As<Napi::Number>().FloatValue();
     }
 
     void NativeEngine::SetZOffset(const Napi::CallbackInfo& /*info*/)
@@ -834,46 +1359,58 @@ namespace Babylon
 
     void NativeEngine::SetDepthTest(const Napi::CallbackInfo& info)
     {
-        const auto depthTest = info[0].As<Napi::Number>().Uint32Value();
+        SetDepthTest(m_encoderState, info[0].As<Napi::Number>().Uint32Value());
+    }
 
-        m_engineState &= ~BGFX_STATE_DEPTH_TEST_MASK;
-        m_engineState |= depthTest;
+    void NativeEngine::SetDepthTest(EncoderState& state, uint32_t depthTest)
+    {
+        state.EngineState &= ~BGFX_STATE_DEPTH_TEST_MASK;
+        state.EngineState |= depthTest;
     }
 
     Napi::Value NativeEngine::GetDepthWrite(const Napi::CallbackInfo& info)
     {
-        return Napi::Value::From(info.Env(), !!(m_engineState & BGFX_STATE_WRITE_Z));
+        return Napi::Value::From(info.Env(), !!(m_encoderState.EngineState & BGFX_STATE_WRITE_Z));
     }
 
     void NativeEngine::SetDepthWrite(const Napi::CallbackInfo& info)
     {
-        const auto enable = info[0].As<Napi::Boolean>().Value();
+        SetDepthWrite(m_encoderState, info[0].As<Napi::Boolean>().Value());
+    }
 
-        m_engineState &= ~BGFX_STATE_WRITE_Z;
-        m_engineState |= enable ? BGFX_STATE_WRITE_Z : 0;
+    void NativeEngine::SetDepthWrite(EncoderState& state, bool enable)
+    {
+        state.EngineState &= ~BGFX_STATE_WRITE_Z;
+        state.EngineState |= enable ? BGFX_STATE_WRITE_Z : 0;
     }
 
     void NativeEngine::SetColorWrite(const Napi::CallbackInfo& info)
     {
-        const auto enable = info[0].As<Napi::Boolean>().Value();
+        SetColorWrite(m_encoderState, info[0].As<Napi::Boolean>().Value());
+    }
 
-        m_engineState &= ~(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
-        m_engineState |= enable ? (BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A) : 0;
+    void NativeEngine::SetColorWrite(EncoderState& state, bool enable)
+    {
+        state.EngineState &= ~(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+        state.EngineState |= enable ? (BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A) : 0;
     }
 
     void NativeEngine::SetBlendMode(const Napi::CallbackInfo& info)
     {
-        const auto blendMode = info[0].As<Napi::Number>().Int64Value();
+        SetBlendMode(m_encoderState, static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value()));
+    }
 
-        m_engineState &= ~BGFX_STATE_BLEND_MASK;
-        m_engineState |= blendMode;
+    void NativeEngine::SetBlendMode(EncoderState& state, uint64_t blendMode)
+    {
+        state.EngineState &= ~BGFX_STATE_BLEND_MASK;
+        state.EngineState |= blendMode;
     }
 
     void NativeEngine::SetInt(const Napi::CallbackInfo& info)
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto value = info[1].As<Napi::Number>().FloatValue();
-        m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(&value, 1), uniformInfo->YFlip);
+        m_encoderState.SetUniform(*uniformInfo, gsl::make_span(&value, 1));
     }
 
     template<int size, typename arrayType>
@@ -881,10 +1418,15 @@ namespace Babylon
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto array = info[1].As<arrayType>();
+        SetTypeArrayN<size>(m_encoderState, *uniformInfo, gsl::make_span(array.Data(), array.ElementLength()));
+    }
 
-        size_t elementLength = array.ElementLength();
+    template<int size, typename T>
+    void NativeEngine::SetTypeArrayN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<T> array)
+    {
+        const size_t elementLength = static_cast<size_t>(array.size());
 
-        m_scratch.clear();
+        state.Scratch.clear();
         for (size_t index = 0; index < elementLength; index += size)
         {
             const float values[] = {
@@ -893,10 +1435,10 @@ namespace Babylon
                 (size > 2) ? static_cast<float>(array[index + 2]) : 0.f,
                 (size > 3) ? static_cast<float>(array[index + 3]) : 0.f,
             };
-            m_scratch.insert(m_scratch.end(), values, values + 4);
+            state.Scratch.insert(state.Scratch.end(), values, values + 4);
         }
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, m_scratch, uniformInfo->YFlip, elementLength / size);
+        state.SetUniform(uniformInfo, state.Scratch, elementLength / size);
     }
 
     template<int size>
@@ -910,7 +1452,15 @@ namespace Babylon
             (size > 3) ? info[4].As<Napi::Number>().FloatValue() : 0.f,
         };
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, values, uniformInfo->YFlip);
+        m_encoderState.SetUniform(*uniformInfo, values);
+    }
+
+    template<int size>
+    void NativeEngine::SetFloatN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<const float> values)
+    {
+        float paddedValues[4]{};
+        std::copy(values.begin(), values.begin() + size, paddedValues);
+        state.SetUniform(uniformInfo, paddedValues);
     }
 
     template<int size>
@@ -918,10 +1468,13 @@ namespace Babylon
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto matrix = info[1].As<Napi::Float32Array>();
+        SetMatrixN<size>(m_encoderState, *uniformInfo, gsl::make_span(matrix.Data(), matrix.ElementLength()));
+    }
 
-        const size_t elementLength = matrix.ElementLength();
-        assert(elementLength == size * size);
-        (void)elementLength;
+    template<int size>
+    void NativeEngine::SetMatrixN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<const float> matrix)
+    {
+        assert(static_cast<size_t>(matrix.size()) == size * size);
 
         if constexpr (size < 4)
         {
@@ -936,11 +1489,11 @@ namespace Babylon
                 }
             }
 
-            m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(matrixValues.data(), 16), uniformInfo->YFlip);
+            state.SetUniform(uniformInfo, gsl::make_span(matrixValues.data(), 16));
         }
         else
         {
-            m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(matrix.Data(), elementLength), uniformInfo->YFlip);
+            state.SetUniform(uniformInfo, matrix);
         }
     }
 
@@ -992,7 +1545,7 @@ namespace Babylon
         const size_t elementLength = matricesArray.ElementLength();
         assert(elementLength % 16 == 0);
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, gsl::span(matricesArray.Data(), elementLength), uniformInfo->YFlip, elementLength / 16);
+        m_encoderState.SetUniform(*uniformInfo, gsl::span(matricesArray.Data(), elementLength), elementLength / 16);
     }
 
     void NativeEngine::SetMatrix2x2(const Napi::CallbackInfo& info)
@@ -1032,7 +1585,9 @@ namespace Babylon
 
     Napi::Value NativeEngine::CreateTexture(const Napi::CallbackInfo& info)
     {
-        return Napi::External<TextureData>::New(info.Env(), new TextureData());
+        auto texture = new TextureData();
+        m_textureResidencyManager.Track(*texture);
+        return Napi::External<TextureData>::New(info.Env(), texture);
     }
 
     Napi::Value NativeEngine::CreateDepthTexture(const Napi::CallbackInfo& info)
@@ -1063,32 +1618,19 @@ namespace Babylon
         const auto onSuccess = info[4].As<Napi::Function>();
         const auto onError = info[5].As<Napi::Function>();
 
+        const auto priority = GetDecodePriority(info[6]);
+
         const auto dataSpan = gsl::make_span(static_cast<uint8_t*>(data.ArrayBuffer().Data()) + data.ByteOffset(), data.ByteLength());
 
-        arcana::make_task(arcana::threadpool_scheduler, m_cancelSource,
-            [this, dataSpan, generateMips, invertY]() {
-                bimg::ImageContainer* image = bimg::imageParse(&m_allocator, dataSpan.data(), static_cast<uint32_t>(dataSpan.size()));
-                if (image == nullptr)
-                {
-                    throw std::runtime_error("Unable to decode image."); // exception will be forwarded to JS
-                }
-                if (invertY)
-                {
-                    FlipY(image);
-                }
-                if (generateMips)
-                {
-                    GenerateMips(&m_allocator, &image);
-                }
-                return image;
-            })
-            .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRef{Napi::Persistent(data)}](bimg::ImageContainer* image) {
-                ScheduleRender();
-                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, image] {
-                    CreateTextureFromImage(texture, image);
-                });
-            })
-            .then(RuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
+        if (m_textureResidencyManager.IsEnabled())
+        {
+            // Keep a copy of the encoded image so that the texture can be reloaded after being evicted.
+            auto bytes = std::make_shared<const std::vector<uint8_t>>(dataSpan.begin(), dataSpan.end());
+            m_textureResidencyManager.SetSource(*texture, {std::move(bytes), generateMips, invertY});
+        }
+
+        LoadTextureAsync(texture, dataSpan, generateMips, invertY, priority)
+            .then(RuntimeScheduler, m_cancelSource, [dataRef{Napi::Persistent(data)}, onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
                 if (result.has_error())
                 {
                     onErrorRef.Call({});
@@ -1100,6 +1642,65 @@ namespace Babylon
             });
     }
 
+    arcana::task<void, std::exception_ptr> NativeEngine::LoadTextureAsync(TextureData* texture, gsl::span<const uint8_t> data, bool generateMips, bool invertY, TextureDecodePool::Priority priority)
+    {
+        TextureDecodePool::DecodeFunction decoder = [this, data, generateMips, invertY]() {
+            bimg::ImageContainer* image = ParseImage(&m_allocator, data);
+            PrepareImage(&m_allocator, &image, invertY, generateMips);
+            return image;
+        };
+
+        return m_textureDecodePool.DecodeAsync({std::move(decoder)}, priority)
+            .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, lifetime = std::weak_ptr<void>{texture->Lifetime}](std::vector<bimg::ImageContainer*> images) {
+                ScheduleRender();
+                // The decoded bytes are returned to the budget when the continuation below is destroyed,
+                // including when it is cancelled or throws.
+                auto reservation = m_textureDecodePool.Reserve(images.front()->m_size);
+                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [this, texture, lifetime, image = images.front(), reservation = std::move(reservation)] {
+                    // Reloads are not tied to a JavaScript callback, so the texture may have been deleted since.
+                    // Its memory is then still valid until this frame has rendered, but must not be touched.
+                    if (lifetime.expired())
+                    {
+                        bimg::imageFree(image);
+                        return;
+                    }
+
+                    // A reloaded texture replaces the placeholder it was evicted to.
+                    m_textureStreamer.Remove(*texture);
+                    if (bgfx::isValid(texture->Handle))
+                    {
+                        bgfx::destroy(texture->Handle);
+                    }
+                    m_textureResidencyManager.OnTextureCreated(*texture, *image);
+
+                    if (TextureStreamer::CanStream(*image))
+                    {
+                        // Large textures are usable right away at low resolution and refined over the next frames.
+                        m_textureStreamer.Create(*texture, image);
+                        ScheduleTextureStreaming();
+                    }
+                    else
+                    {
+                        CreateTextureFromImage(texture, image);
+                    }
+                });
+            });
+    }
+
+    void NativeEngine::ReloadTexture(TextureData& texture)
+    {
+        const auto source = m_textureResidencyManager.GetSource(texture);
+        if (!source.has_value())
+        {
+            return;
+        }
+
+        // The texture is bound right now, so it is decoded ahead of background loads. The source bytes are
+        // kept alive until the load completes, even if the texture is deleted in the meantime.
+        LoadTextureAsync(&texture, gsl::make_span(*source->Bytes), source->GenerateMips, source->InvertY, TextureDecodePool::Priority::Visible)
+            .then(arcana::inline_scheduler, arcana::cancellation::none(), [bytes = source->Bytes](const arcana::expected<void, std::exception_ptr>&) {});
+    }
+
     void NativeEngine::LoadCubeTexture(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
@@ -1107,28 +1708,30 @@ namespace Babylon
         const auto generateMips = info[2].As<Napi::Boolean>().Value();
         const auto onSuccess = info[3].As<Napi::Function>();
         const auto onError = info[4].As<Napi::Function>();
+        const auto priority = GetDecodePriority(info[5]);
 
         std::array<Napi::Reference<Napi::TypedArray>, 6> dataRefs;
-        std::array<arcana::task<bimg::ImageContainer*, std::exception_ptr>, 6> tasks;
+        std::vector<TextureDecodePool::DecodeFunction> decoders(data.Length());
         for (uint32_t face = 0; face < data.Length(); face++)
         {
             const auto typedArray = data[face].As<Napi::TypedArray>();
             const auto dataSpan = gsl::make_span(static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset(), typedArray.ByteLength());
             dataRefs[face] = Napi::Persistent(typedArray);
-            tasks[face] = arcana::make_task(arcana::threadpool_scheduler, m_cancelSource, [this, dataSpan, generateMips]() {
-                bimg::ImageContainer* image = bimg::imageParse(&m_allocator, dataSpan.data(), static_cast<uint32_t>(dataSpan.size()));
+            decoders[face] = [this, dataSpan, generateMips]() {
+                bimg::ImageContainer* image = ParseImage(&m_allocator, dataSpan);
                 if (generateMips)
                 {
                     GenerateMips(&m_allocator, &image);
                 }
                 return image;
-            });
+            };
         }
 
-        arcana::when_all(gsl::make_span(tasks))
+        m_textureDecodePool.DecodeAsync(std::move(decoders), priority)
             .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, generateMips, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
                 ScheduleRender();
-                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, generateMips, images = std::move(images)] {
+                auto reservation = m_textureDecodePool.Reserve(GetImagesByteCount(images));
+                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [this, texture, generateMips, images = std::move(images), reservation = std::move(reservation)] {
                     CreateCubeTextureFromImages(texture, images, generateMips);
                 });
             })
@@ -1150,10 +1753,11 @@ namespace Babylon
         const auto data = info[1].As<Napi::Array>();
         const auto onSuccess = info[2].As<Napi::Function>();
         const auto onError = info[3].As<Napi::Function>();
+        const auto priority = GetDecodePriority(info[4]);
 
         const auto numMips = data.Length();
         std::vector<Napi::Reference<Napi::TypedArray>> dataRefs(6 * numMips);
-        std::vector<arcana::task<bimg::ImageContainer*, std::exception_ptr>> tasks(6 * numMips);
+        std::vector<TextureDecodePool::DecodeFunction> decoders(6 * numMips);
         for (uint32_t mip = 0; mip < numMips; mip++)
         {
             const auto faceData = data[mip].As<Napi::Array>();
@@ -1162,18 +1766,19 @@ namespace Babylon
                 const auto typedArray = faceData[face].As<Napi::TypedArray>();
                 const auto dataSpan = gsl::make_span(static_cast<uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset(), typedArray.ByteLength());
                 dataRefs[(face * numMips) + mip] = Napi::Persistent(typedArray);
-                tasks[(face * numMips) + mip] = arcana::make_task(arcana::threadpool_scheduler, m_cancelSource, [this, dataSpan]() {
-                    bimg::ImageContainer* image = bimg::imageParse(&m_allocator, dataSpan.data(), static_cast<uint32_t>(dataSpan.size()));
+                decoders[(face * numMips) + mip] = [this, dataSpan]() {
+                    bimg::ImageContainer* image = ParseImage(&m_allocator, dataSpan);
                     FlipY(image);
                     return image;
-                });
+                };
             }
         }
 
-        arcana::when_all(gsl::make_span(tasks))
+        m_textureDecodePool.DecodeAsync(std::move(decoders), priority)
             .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
                 ScheduleRender();
-                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, images = std::move(images)] {
+                auto reservation = m_textureDecodePool.Reserve(GetImagesByteCount(images));
+                return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [this, texture, images = std::move(images), reservation = std::move(reservation)] {
                     CreateCubeTextureFromImages(texture, images, true);
                 });
             })
@@ -1189,6 +1794,68 @@ namespace Babylon
             });
     }
 
+    void NativeEngine::SetTextureDecodeOptions(const Napi::CallbackInfo& info)
+    {
+        const auto workerCount = info[0].As<Napi::Number>().Uint32Value();
+        const auto byteBudget = static_cast<uint64_t>(info[1].As<Napi::Number>().DoubleValue());
+        m_textureDecodePool.Configure(workerCount, byteBudget);
+    }
+
+    Napi::Value NativeEngine::GetTextureDecodeStatistics(const Napi::CallbackInfo& info)
+    {
+        const auto statistics = m_textureDecodePool.GetStatistics();
+
+        auto result = Napi::Object::New(info.Env());
+        result.Set("queueDepth", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.QueueDepth)));
+        result.Set("inFlight", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.InFlight)));
+        result.Set("pendingBytes", Napi::Value::From(info.Env(), static_cast<double>(statistics.PendingBytes)));
+        result.Set("byteBudget", Napi::Value::From(info.Env(), static_cast<double>(statistics.ByteBudget)));
+        result.Set("decodedImages", Napi::Value::From(info.Env(), static_cast<double>(statistics.DecodedImages)));
+        result.Set("decodedBytes", Napi::Value::From(info.Env(), static_cast<double>(statistics.DecodedBytes)));
+        result.Set("bytesPerSecond", Napi::Value::From(info.Env(), statistics.Throughput));
+        return std::move(result);
+    }
+
+    void NativeEngine::SetTextureStreamingOptions(const Napi::CallbackInfo& info)
+    {
+        const auto uploadBytesPerFrame = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+        m_textureStreamer.SetUploadBudget(uploadBytesPerFrame);
+    }
+
+    void NativeEngine::SetTextureTargetSize(const Napi::CallbackInfo& info)
+    {
+        const auto texture = info[0].As<Napi::External<TextureData>>().Data();
+        const auto pixelSize = info[1].As<Napi::Number>().Uint32Value();
+        if (m_textureStreamer.SetTargetSize(*texture, pixelSize))
+        {
+            ReloadTexture(*texture);
+        }
+        else if (m_textureStreamer.HasPendingWork())
+        {
+            ScheduleTextureStreaming();
+        }
+    }
+
+    void NativeEngine::SetTextureResidencyOptions(const Napi::CallbackInfo& info)
+    {
+        const auto byteBudget = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+        m_textureResidencyManager.SetByteBudget(byteBudget);
+    }
+
+    Napi::Value NativeEngine::GetTextureResidencyStatistics(const Napi::CallbackInfo& info)
+    {
+        const auto statistics = m_textureResidencyManager.GetStatistics();
+
+        auto result = Napi::Object::New(info.Env());
+        result.Set("trackedTextures", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.TrackedTextures)));
+        result.Set("evictedTextures", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.EvictedTextures)));
+        result.Set("residentBytes", Napi::Value::From(info.Env(), static_cast<double>(statistics.ResidentBytes)));
+        result.Set("byteBudget", Napi::Value::From(info.Env(), static_cast<double>(statistics.ByteBudget)));
+        result.Set("evictions", Napi::Value::From(info.Env(), static_cast<double>(statistics.Evictions)));
+        result.Set("reloads", Napi::Value::From(info.Env(), static_cast<double>(statistics.Reloads)));
+        return std::move(result);
+    }
+
     Napi::Value NativeEngine::GetTextureWidth(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
@@ -1204,47 +1871,57 @@ namespace Babylon
     void NativeEngine::SetTextureSampling(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
-        auto filter = static_cast<uint32_t>(info[1].As<Napi::Number>().Uint32Value());
+        SetTextureSampling(*texture, info[1].As<Napi::Number>().Uint32Value());
+    }
 
-        texture->Flags &= ~(BGFX_SAMPLER_MIN_MASK | BGFX_SAMPLER_MAG_MASK | BGFX_SAMPLER_MIP_MASK);
+    void NativeEngine::SetTextureSampling(TextureData& texture, uint32_t filter)
+    {
+        texture.Flags &= ~(BGFX_SAMPLER_MIN_MASK | BGFX_SAMPLER_MAG_MASK | BGFX_SAMPLER_MIP_MASK);
 
-        if (texture->AnisotropicLevel > 1)
+        if (texture.AnisotropicLevel > 1)
         {
-            texture->Flags |= BGFX_SAMPLER_MIN_ANISOTROPIC | BGFX_SAMPLER_MAG_ANISOTROPIC;
+            texture.Flags |= BGFX_SAMPLER_MIN_ANISOTROPIC | BGFX_SAMPLER_MAG_ANISOTROPIC;
         }
         else
         {
-            texture->Flags |= filter;
+            texture.Flags |= filter;
         }
     }
 
     void NativeEngine::SetTextureWrapMode(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
-        auto addressModeU = static_cast<uint32_t>(info[1].As<Napi::Number>().Uint32Value());
-        auto addressModeV = static_cast<uint32_t>(info[2].As<Napi::Number>().Uint32Value());
-        auto addressModeW = static_cast<uint32_t>(info[3].As<Napi::Number>().Uint32Value());
+        const auto addressModeU = info[1].As<Napi::Number>().Uint32Value();
+        const auto addressModeV = info[2].As<Napi::Number>().Uint32Value();
+        const auto addressModeW = info[3].As<Napi::Number>().Uint32Value();
+        SetTextureWrapMode(*texture, addressModeU, addressModeV, addressModeW);
+    }
 
+    void NativeEngine::SetTextureWrapMode(TextureData& texture, uint32_t addressModeU, uint32_t addressModeV, uint32_t addressModeW)
+    {
         uint32_t addressMode = addressModeU +
             (addressModeV << BGFX_SAMPLER_V_SHIFT) +
             (addressModeW << BGFX_SAMPLER_W_SHIFT);
 
-        texture->Flags &= ~(BGFX_SAMPLER_U_MASK | BGFX_SAMPLER_V_MASK | BGFX_SAMPLER_W_MASK);
-        texture->Flags |= addressMode;
+        texture.Flags &= ~(BGFX_SAMPLER_U_MASK | BGFX_SAMPLER_V_MASK | BGFX_SAMPLER_W_MASK);
+        texture.Flags |= addressMode;
     }
 
     void NativeEngine::SetTextureAnisotropicLevel(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
-        const auto value = info[1].As<Napi::Number>().Uint32Value();
+        SetTextureAnisotropicLevel(*texture, info[1].As<Napi::Number>().Uint32Value());
+    }
 
-        texture->AnisotropicLevel = static_cast<uint8_t>(value);
+    void NativeEngine::SetTextureAnisotropicLevel(TextureData& texture, uint32_t value)
+    {
+        texture.AnisotropicLevel = static_cast<uint8_t>(value);
 
         // if Anisotropic is set to 0 after being >1, then set texture flags back to linear
-        texture->Flags &= ~(BGFX_SAMPLER_MIN_MASK | BGFX_SAMPLER_MAG_MASK | BGFX_SAMPLER_MIP_MASK);
+        texture.Flags &= ~(BGFX_SAMPLER_MIN_MASK | BGFX_SAMPLER_MAG_MASK | BGFX_SAMPLER_MIP_MASK);
         if (value)
         {
-            texture->Flags |= BGFX_SAMPLER_MIN_ANISOTROPIC | BGFX_SAMPLER_MAG_ANISOTROPIC;
+            texture.Flags |= BGFX_SAMPLER_MIN_ANISOTROPIC | BGFX_SAMPLER_MAG_ANISOTROPIC;
         }
     }
 
@@ -1252,14 +1929,40 @@ namespace Babylon
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto texture = info[1].As<Napi::External<TextureData>>().Data();
+        SetTexture(m_encoderState, *uniformInfo, *texture);
+    }
+
+    void NativeEngine::SetTexture(EncoderState& state, const UniformInfo& uniformInfo, TextureData& texture)
+    {
+        if (m_textureResidencyManager.Touch(texture))
+        {
+            if (state.PassState.has_value())
+            {
+                state.PassState->EvictedTextures.push_back(&texture);
+            }
+            else
+            {
+                ReloadTexture(texture);
+            }
+        }
 
-        bgfx::setTexture(uniformInfo->Stage, uniformInfo->Handle, texture->Handle, texture->Flags);
+        state.StateCache.SetTexture(uniformInfo.Stage, uniformInfo.Handle, texture.Handle, texture.Flags);
     }
 
     void NativeEngine::DeleteTexture(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
-        delete texture;
+        m_textureStreamer.Remove(*texture);
+        m_textureResidencyManager.Untrack(*texture);
+
+        // A reload that completes on the render thread may be using the texture right now. Expiring its
+        // lifetime keeps later reloads away, and the texture is only deleted once the frame has rendered,
+        // after every reload that was already scheduled for it. Textures deleted after the engine has been
+        // disposed are left to bgfx::shutdown.
+        texture->Lifetime.reset();
+        m_graphicsImpl.GetAfterRenderTask().then(RuntimeScheduler, m_cancelSource, [texture] {
+            delete texture;
+        });
     }
 
     Napi::Value NativeEngine::CreateFrameBuffer(const Napi::CallbackInfo& info)
@@ -1273,48 +1976,52 @@ namespace Babylon
         bool generateDepth = info[6].As<Napi::Boolean>();
         bool generateMips = info[7].As<Napi::Boolean>();
 
-        bgfx::FrameBufferHandle frameBufferHandle{};
         if (generateStencilBuffer && !generateDepth)
         {
             throw std::runtime_error{"Does this case even make any sense?"};
         }
-        else if (!generateStencilBuffer && !generateDepth)
+
+        RenderTargetPool::Description description{width, height, format, RenderTargetPool::DepthStencil::None, false};
+        if (generateDepth)
         {
-            frameBufferHandle = bgfx::createFrameBuffer(width, height, format, BGFX_TEXTURE_RT);
+            description.DepthStencilBuffer = generateStencilBuffer ? RenderTargetPool::DepthStencil::DepthStencil : RenderTargetPool::DepthStencil::Depth;
+            // Mips are only allocated for targets with a depth buffer.
+            description.HasMips = generateMips;
         }
-        else
-        {
-            auto depthStencilFormat = bgfx::TextureFormat::D32;
-            if (generateStencilBuffer)
-            {
-                depthStencilFormat = bgfx::TextureFormat::D24S8;
-            }
 
-            assert(bgfx::isTextureValid(0, false, 1, format, BGFX_TEXTURE_RT));
-            assert(bgfx::isTextureValid(0, false, 1, depthStencilFormat, BGFX_TEXTURE_RT));
+        auto frameBufferData = m_frameBufferManager.CreatePooled(description);
 
-            std::array<bgfx::TextureHandle, 2> textures{
-                bgfx::createTexture2D(width, height, generateMips, 1, format, BGFX_TEXTURE_RT),
-                bgfx::createTexture2D(width, height, generateMips, 1, depthStencilFormat, BGFX_TEXTURE_RT)};
-            std::array<bgfx::Attachment, textures.size()> attachments{};
-            for (size_t idx = 0; idx < attachments.size(); ++idx)
-            {
-                attachments[idx].init(textures[idx]);
-            }
-            frameBufferHandle = bgfx::createFrameBuffer(static_cast<uint8_t>(attachments.size()), attachments.data(), true);
-        }
+        texture->Handle = bgfx::getTexture(frameBufferData->FrameBuffer);
+        texture->RenderTarget = frameBufferData->RenderTarget;
 
-        texture->Handle = bgfx::getTexture(frameBufferHandle);
-
-        return Napi::External<FrameBufferData>::New(info.Env(), m_frameBufferManager.CreateNew(frameBufferHandle, width, height));
+        return Napi::External<FrameBufferData>::New(info.Env(), frameBufferData);
     }
 
     void NativeEngine::DeleteFrameBuffer(const Napi::CallbackInfo& info)
     {
         const auto frameBufferData = info[0].As<Napi::External<FrameBufferData>>().Data();
+        if (&m_frameBufferManager.GetBound() == frameBufferData)
+        {
+            m_frameBufferManager.Unbind(frameBufferData);
+        }
         delete frameBufferData;
     }
 
+    Napi::Value NativeEngine::GetRenderTargetPoolStatistics(const Napi::CallbackInfo& info)
+    {
+        const auto statistics = m_frameBufferManager.GetRenderTargetPool().GetStatistics();
+
+        auto result = Napi::Object::New(info.Env());
+        result.Set("requests", Napi::Value::From(info.Env(), static_cast<double>(statistics.Requests)));
+        result.Set("hits", Napi::Value::From(info.Env(), static_cast<double>(statistics.Hits)));
+        result.Set("hitRate", Napi::Value::From(info.Env(), statistics.Requests > 0 ? static_cast<double>(statistics.Hits) / statistics.Requests : 0.0));
+        result.Set("activeTargets", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.ActiveTargets)));
+        result.Set("pooledTargets", Napi::Value::From(info.Env(), static_cast<uint32_t>(statistics.PooledTargets)));
+        result.Set("activeBytes", Napi::Value::From(info.Env(), static_cast<double>(statistics.ActiveBytes)));
+        result.Set("pooledBytes", Napi::Value::From(info.Env(), static_cast<double>(statistics.PooledBytes)));
+        return std::move(result);
+    }
+
     void NativeEngine::BindFrameBuffer(const Napi::CallbackInfo& info)
     {
         const auto frameBufferData = info[0].As<Napi::External<FrameBufferData>>().Data();
@@ -1332,11 +2039,45 @@ namespace Babylon
         const auto fillMode = info[0].As<Napi::Number>().Int32Value();
         const auto elementStart = info[1].As<Napi::Number>().Int32Value();
         const auto elementCount = info[2].As<Napi::Number>().Int32Value();
+        DrawIndexed(m_encoderState, fillMode, elementStart, elementCount);
+    }
+
+    void NativeEngine::DrawIndexedInstanced(const Napi::CallbackInfo& info)
+    {
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        const auto elementStart = info[1].As<Napi::Number>().Int32Value();
+        const auto elementCount = info[2].As<Napi::Number>().Int32Value();
+        const auto instanceCount = info[3].As<Napi::Number>().Uint32Value();
+        if (instanceCount > 0 && m_encoderState.CurrentBoundInstanceBuffer.data == nullptr)
+        {
+            throw Napi::Error::New(info.Env(), "Instanced draws require an instance data buffer.");
+        }
+
+        DrawIndexed(m_encoderState, fillMode, elementStart, elementCount, instanceCount);
+    }
+
+    void NativeEngine::DrawIndexed(EncoderState& state, int32_t fillMode, int32_t elementStart, int32_t elementCount, uint32_t instanceCount)
+    {
         // TODO: handle viewport
 
-        if (m_currentBoundIndexBuffer)
+        bgfx::Encoder& encoder = state.StateCache.GetEncoder();
+
+        if (state.CurrentBoundIndexBuffer)
         {
-            m_currentBoundIndexBuffer->SetBgfxIndexBuffer(elementStart, elementCount);
+            state.CurrentBoundIndexBuffer->SetBgfxIndexBuffer(state.StateCache, elementStart, elementCount);
+        }
+
+        if (instanceCount > 0)
+        {
+            // The direct draw methods check this up front, so this is only reached from submitted commands,
+            // which rethrow standard exceptions as JavaScript errors.
+            if (state.CurrentBoundInstanceBuffer.data == nullptr)
+            {
+                throw std::runtime_error{"Instanced draws require an instance data buffer."};
+            }
+
+            const auto& instanceBuffer = state.CurrentBoundInstanceBuffer;
+            instanceBuffer.data->SetAsBgfxInstanceDataBuffer(encoder, instanceBuffer.byteOffset / instanceBuffer.byteStride, instanceCount);
         }
 
         // TODO: support other fill modes
@@ -1357,7 +2098,10 @@ namespace Babylon
                 break;
         }
 
-        if (m_frameBufferManager.IsRenderingToTarget() && (!bgfx::getCaps()->originBottomLeft))
+        uint64_t renderState = state.EngineState | fillModeState;
+        const bool renderingToTarget = state.PassState.has_value() ? state.PassState->RenderingToTarget : m_frameBufferManager.IsRenderingToTarget();
+        const bool yFlip = renderingToTarget && (!bgfx::getCaps()->originBottomLeft);
+        if (yFlip)
         {
             // UV coordinates system are different between OpenGL and Direct3D/Metal
             // This is not an issue with loaded textures (png/jpg...) because
@@ -1371,74 +2115,124 @@ namespace Babylon
             // When rendering to texture, those matrices are flipped and set as uniform datas.
             // But because flipping clip-space coordinates also flips triangles winding,
             // Culling also has to be flipped.
-            for (const auto& it : m_currentProgram->Uniforms)
-            {
-                const ProgramData::UniformValue& value = it.second;
-                if (value.YFlip)
-                {
-                    float tmpMatrix[16];
-                    static const float flipMatrix[16] = {1.f, 0.f, 0.f, 0.f,
-                        0.f, -1.f, 0.f, 0.f,
-                        0.f, 0.f, 1.f, 0.f,
-                        0.f, 0.f, 0.f, 1.f};
-                    bx::mtxMul(tmpMatrix, value.Data.data(), flipMatrix);
-                    bgfx::setUniform({it.first}, tmpMatrix, value.ElementLength);
-                }
-                else
-                {
-                    bgfx::setUniform({it.first}, value.Data.data(), value.ElementLength);
-                }
-            }
 
             // We need to explicitly swap the culling state flags (instead of XOR)
             // because we would like to preserve the no culling configuration, which is 00.
-            const auto cullCW  = (m_engineState & BGFX_STATE_CULL_CCW) != 0 ? BGFX_STATE_CULL_CW : 0;
-            const auto cullCCW = (m_engineState & BGFX_STATE_CULL_CW) != 0 ? BGFX_STATE_CULL_CCW : 0;
+            const auto cullCW  = (state.EngineState & BGFX_STATE_CULL_CCW) != 0 ? BGFX_STATE_CULL_CW : 0;
+            const auto cullCCW = (state.EngineState & BGFX_STATE_CULL_CW) != 0 ? BGFX_STATE_CULL_CCW : 0;
 
-            uint64_t m_engineStateYFlipped = m_engineState;
-            m_engineStateYFlipped &= ~BGFX_STATE_CULL_MASK;
-            m_engineStateYFlipped |= (cullCW | cullCCW) << BGFX_STATE_CULL_SHIFT;
+            renderState &= ~BGFX_STATE_CULL_MASK;
+            renderState |= (cullCW | cullCCW) << BGFX_STATE_CULL_SHIFT;
+        }
 
-            bgfx::setState(m_engineStateYFlipped | fillModeState);
+        bgfx::ViewId viewId{};
+        if (state.PassState.has_value())
+        {
+            viewId = state.PassState->ViewId;
         }
         else
         {
-            for (const auto& it : m_currentProgram->Uniforms)
+            viewId = m_frameBufferManager.UseBound().ViewId;
+            // The frame buffer manager only reorders views whose sampled textures it knows.
+            state.StateCache.ForEachTexture([this](bgfx::TextureHandle texture) {
+                m_frameBufferManager.NotifySampled(texture);
+            });
+        }
+
+        // bgfx applies uniforms in the order in which it renders the draws, not per encoder, so a draw
+        // encoded in a pass cannot rely on uniforms uploaded by an earlier draw.
+        const bool uploadAll = state.StateCache.BeginSubmit(state.CurrentProgram, viewId, renderState) || state.PassState.has_value();
+        uint32_t uniformsIssued{0};
+        uint32_t uniformsElided{0};
+        auto& uniforms = state.GetUniforms(*state.CurrentProgram);
+        for (auto& slot : uniforms.Slots)
+        {
+            if (slot.ElementLength == 0)
+            {
+                continue;
+            }
+
+            if (!uploadAll && !slot.Dirty)
+            {
+                ++uniformsElided;
+                continue;
+            }
+
+            ++uniformsIssued;
+
+            const float* data = uniforms.Block.data() + slot.Offset;
+            if (yFlip && slot.YFlip)
+            {
+                float tmpMatrix[16];
+                static const float flipMatrix[16] = {1.f, 0.f, 0.f, 0.f,
+                    0.f, -1.f, 0.f, 0.f,
+                    0.f, 0.f, 1.f, 0.f,
+                    0.f, 0.f, 0.f, 1.f};
+                bx::mtxMul(tmpMatrix, data, flipMatrix);
+                encoder.setUniform(slot.Handle, tmpMatrix, slot.ElementLength);
+            }
+            else
             {
-                const ProgramData::UniformValue& value = it.second;
-                bgfx::setUniform({it.first}, value.Data.data(), value.ElementLength);
+                encoder.setUniform(slot.Handle, data, slot.ElementLength);
             }
-            bgfx::setState(m_engineState | fillModeState);
+
+            slot.Dirty = false;
         }
 
-        bgfx::submit(m_frameBufferManager.GetBound().ViewId, m_currentProgram->Program, 0, BGFX_DISCARD_INSTANCE_DATA | BGFX_DISCARD_STATE | BGFX_DISCARD_TRANSFORM);
+        state.StateCache.RecordUniforms(uniformsIssued, uniformsElided);
+        state.StateCache.SetState(renderState);
+
+        // The render state is kept across submits so that the render state cache can skip setting it again.
+        encoder.submit(viewId, state.CurrentProgram->Program, 0, BGFX_DISCARD_INSTANCE_DATA | BGFX_DISCARD_TRANSFORM);
     }
 
     void NativeEngine::Draw(const Napi::CallbackInfo& info)
     {
-        bgfx::discard(BGFX_DISCARD_INDEX_BUFFER);
-        m_currentBoundIndexBuffer = nullptr;
-        DrawIndexed(info);
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        const auto verticesStart = info[1].As<Napi::Number>().Int32Value();
+        const auto verticesCount = info[2].As<Napi::Number>().Int32Value();
+        Draw(m_encoderState, fillMode, verticesStart, verticesCount);
+    }
+
+    void NativeEngine::DrawInstanced(const Napi::CallbackInfo& info)
+    {
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        const auto verticesStart = info[1].As<Napi::Number>().Int32Value();
+        const auto verticesCount = info[2].As<Napi::Number>().Int32Value();
+        const auto instanceCount = info[3].As<Napi::Number>().Uint32Value();
+        if (instanceCount > 0 && m_encoderState.CurrentBoundInstanceBuffer.data == nullptr)
+        {
+            throw Napi::Error::New(info.Env(), "Instanced draws require an instance data buffer.");
+        }
+
+        Draw(m_encoderState, fillMode, verticesStart, verticesCount, instanceCount);
+    }
+
+    void NativeEngine::Draw(EncoderState& state, int32_t fillMode, int32_t verticesStart, int32_t verticesCount, uint32_t instanceCount)
+    {
+        state.StateCache.DiscardIndexBuffer();
+        state.CurrentBoundIndexBuffer = nullptr;
+        DrawIndexed(state, fillMode, verticesStart, verticesCount, instanceCount);
     }
 
     void NativeEngine::Clear(const Napi::CallbackInfo& info)
     {
-        m_frameBufferManager.GetBound().ViewClearState.UpdateFlags(info);
+        m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateFlags(info);
     }
 
     void NativeEngine::ClearColor(const Napi::CallbackInfo& info)
     {
-        m_frameBufferManager.GetBound().ViewClearState.UpdateColor(info);
+        m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateColor(info);
     }
 
     void NativeEngine::ClearStencil(const Napi::CallbackInfo& info)
     {
-        m_frameBufferManager.GetBound().ViewClearState.UpdateStencil(info);
+        m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateStencil(info);
     }
 
     void NativeEngine::ClearDepth(const Napi::CallbackInfo& info)
     {
-        m_frameBufferManager.GetBound().ViewClearState.UpdateDepth(info);
+        m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateDepth(info);
     }
 
     Napi::Value NativeEngine::GetRenderWidth(const Napi::CallbackInfo& info)
@@ -1457,9 +2251,14 @@ namespace Babylon
         const auto y = info[1].As<Napi::Number>().FloatValue();
         const auto width = info[2].As<Napi::Number>().FloatValue();
         const auto height = info[3].As<Napi::Number>().FloatValue();
+        SetViewPort(x, y, width, height);
+    }
+
+    void NativeEngine::SetViewPort(float x, float y, float width, float height)
+    {
         const float yOrigin = bgfx::getCaps()->originBottomLeft ? y : (1.f - y - height);
 
-        m_frameBufferManager.GetBound().SetViewPort(x, yOrigin, width, height);
+        m_frameBufferManager.SetViewPort(x, yOrigin, width, height);
     }
 
     void NativeEngine::GetFramebufferData(const Napi::CallbackInfo& info)
@@ -1476,6 +2275,390 @@ namespace Babylon
         return Napi::Value::From(info.Env(), static_cast<int>(bgfx::getRendererType()));
     }
 
+    void NativeEngine::SubmitCommands(const Napi::CallbackInfo& info)
+    {
+        const auto words = GetCommandWords(info[0]);
+        const auto objects = info[1].IsArray() ? info[1].As<Napi::Array>() : Napi::Array{};
+        CommandStreamReader reader{words, objects, m_commandObjects};
+
+        try
+        {
+            while (!reader.AtEnd())
+            {
+                ExecuteCommand(m_encoderState, reader);
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            throw Napi::Error::New(info.Env(), ex.what());
+        }
+    }
+
+    void NativeEngine::SubmitCommandPasses(const Napi::CallbackInfo& info)
+    {
+        const auto passArray = info[0].As<Napi::Array>();
+        std::vector<gsl::span<const uint32_t>> passWords(passArray.Length());
+        for (uint32_t index = 0; index < passArray.Length(); ++index)
+        {
+            passWords[index] = GetCommandWords(passArray.Get(index));
+        }
+
+        // Workers cannot call into JavaScript, so every object is unwrapped beforehand.
+        const auto objects = info[1].IsArray() ? info[1].As<Napi::Array>() : Napi::Array{};
+        CommandStreamReader::ResolveObjects(objects, m_commandObjects);
+
+        // Vertex arrays share the vertex layout cache, so they cannot update their vertex buffers in a pass.
+        for (auto* vertexArray : m_dirtyVertexArrays)
+        {
+            vertexArray->UpdateVertexBuffers();
+        }
+        m_dirtyVertexArrays.clear();
+
+        std::vector<EncoderState> states(passWords.size());
+        std::vector<CommandStreamReader> readers{};
+        readers.reserve(passWords.size());
+
+        // Passes are encoded once all of them have begun, or earlier if beginning one splits the frame, as
+        // the views of the passes that have begun belong to the frame being submitted.
+        size_t begunPasses{0};
+        size_t encodedPasses{0};
+        const auto encodeBegunPasses = [&]() {
+            const auto first = static_cast<std::ptrdiff_t>(encodedPasses);
+            const auto count = static_cast<std::ptrdiff_t>(begunPasses - encodedPasses);
+            EncodePasses(gsl::make_span(states).subspan(first, count), gsl::make_span(readers).subspan(first, count));
+            encodedPasses = begunPasses;
+        };
+
+        try
+        {
+            m_frameBufferManager.SetBeforeSplitCallback(encodeBegunPasses);
+            for (size_t index = 0; index < passWords.size(); ++index)
+            {
+                readers.emplace_back(passWords[index], m_commandObjects);
+                BeginPass(states[index], readers[index]);
+                ++begunPasses;
+            }
+            m_frameBufferManager.SetBeforeSplitCallback({});
+
+            encodeBegunPasses();
+        }
+        catch (const std::exception& ex)
+        {
+            m_frameBufferManager.SetBeforeSplitCallback({});
+            throw Napi::Error::New(info.Env(), ex.what());
+        }
+    }
+
+    void NativeEngine::BeginPass(EncoderState& state, CommandStreamReader& reader)
+    {
+        while (!reader.AtEnd() && IsSerialCommand(reader.PeekCommand()))
+        {
+            ExecuteCommand(m_encoderState, reader);
+        }
+
+        state.PassState.emplace();
+        state.PassState->ViewId = m_frameBufferManager.UsePassBound().ViewId;
+        state.PassState->RenderingToTarget = m_frameBufferManager.IsRenderingToTarget();
+    }
+
+    void NativeEngine::EncodePass(EncoderState& state, CommandStreamReader& reader)
+    {
+        // Like a worker encoder fresh from bgfx::begin, an encoder reused from an earlier pass starts clean.
+        state.StateCache.GetEncoder().discard(BGFX_DISCARD_ALL);
+
+        while (!reader.AtEnd())
+        {
+            ExecuteCommand(state, reader);
+        }
+    }
+
+    void NativeEngine::EncodePasses(gsl::span<EncoderState> states, gsl::span<CommandStreamReader> readers)
+    {
+        if (EncoderThreadPool::GetMaxConcurrency() == 0)
+        {
+            // Without encoders to spare, the passes are encoded in order into the encoder of this thread.
+            for (std::ptrdiff_t index = 0; index < states.size(); ++index)
+            {
+                EncodePass(states[index], readers[index]);
+            }
+
+            bgfx::discard(BGFX_DISCARD_ALL);
+            RenderStateCache::NotifyDiscarded();
+        }
+        else
+        {
+            m_encoderThreadPool.Run(static_cast<size_t>(states.size()), [&states, &readers, this](bgfx::Encoder& encoder, size_t index) {
+                auto& state = states[static_cast<std::ptrdiff_t>(index)];
+                state.StateCache.SetEncoder(&encoder);
+                EncodePass(state, readers[static_cast<std::ptrdiff_t>(index)]);
+            });
+        }
+
+        // Uniform values set by later passes win, as they would have if the passes had been encoded in order.
+        for (auto& state : states)
+        {
+            state.CommitPassUniforms();
+            for (auto* texture : state.PassState->EvictedTextures)
+            {
+                ReloadTexture(*texture);
+            }
+        }
+    }
+
+    Napi::Value NativeEngine::GetRenderStateStatistics(const Napi::CallbackInfo& info)
+    {
+        const auto statistics = m_encoderState.StateCache.GetStatistics();
+
+        auto result = Napi::Object::New(info.Env());
+        result.Set("issued", Napi::Value::From(info.Env(), static_cast<double>(statistics.Issued)));
+        result.Set("elided", Napi::Value::From(info.Env(), static_cast<double>(statistics.Elided)));
+        return std::move(result);
+    }
+
+    void NativeEngine::ExecuteCommand(EncoderState& state, CommandStreamReader& reader)
+    {
+        const auto command = reader.ReadCommand();
+        if (state.PassState.has_value() && IsSerialCommand(command))
+        {
+            throw std::runtime_error{"Frame buffer, clear, viewport and texture parameter commands must come before any other command of a parallel pass."};
+        }
+
+        switch (command)
+        {
+            case Command::BindVertexArray:
+                BindVertexArray(state, reader.ReadObject<VertexArray>());
+                break;
+            case Command::SetProgram:
+                SetProgram(state, reader.ReadObject<ProgramData>());
+                break;
+            case Command::SetState:
+            {
+                const auto culling = reader.ReadBool();
+                // The z offset is ignored, as by the setState method.
+                reader.ReadFloat();
+                const auto reverseSide = reader.ReadBool();
+                SetState(state, culling, reverseSide);
+                break;
+            }
+            case Command::SetZOffset:
+                // Ignored, as by the setZOffset method.
+                reader.ReadFloat();
+                break;
+            case Command::SetDepthTest:
+                SetDepthTest(state, reader.ReadUint32());
+                break;
+            case Command::SetDepthWrite:
+                SetDepthWrite(state, reader.ReadBool());
+                break;
+            case Command::SetColorWrite:
+                SetColorWrite(state, reader.ReadBool());
+                break;
+            case Command::SetBlendMode:
+                SetBlendMode(state, reader.ReadUint64());
+                break;
+            case Command::SetMatrix:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetMatrixN<4>(state, uniformInfo, reader.ReadSpan<float>(16));
+                break;
+            }
+            case Command::SetMatrix3x3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetMatrixN<3>(state, uniformInfo, reader.ReadSpan<float>(9));
+                break;
+            }
+            case Command::SetMatrix2x2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetMatrixN<2>(state, uniformInfo, reader.ReadSpan<float>(4));
+                break;
+            }
+            case Command::SetMatrices:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto matrices = reader.ReadArray<float>();
+                state.SetUniform(uniformInfo, matrices, static_cast<size_t>(matrices.size()) / 16);
+                break;
+            }
+            case Command::SetInt:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto value = static_cast<float>(reader.ReadInt32());
+                state.SetUniform(uniformInfo, gsl::make_span(&value, 1));
+                break;
+            }
+            case Command::SetIntArray:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<1>(state, uniformInfo, reader.ReadArray<int32_t>());
+                break;
+            }
+            case Command::SetIntArray2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<2>(state, uniformInfo, reader.ReadArray<int32_t>());
+                break;
+            }
+            case Command::SetIntArray3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<3>(state, uniformInfo, reader.ReadArray<int32_t>());
+                break;
+            }
+            case Command::SetIntArray4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<4>(state, uniformInfo, reader.ReadArray<int32_t>());
+                break;
+            }
+            case Command::SetFloatArray:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<1>(state, uniformInfo, reader.ReadArray<float>());
+                break;
+            }
+            case Command::SetFloatArray2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<2>(state, uniformInfo, reader.ReadArray<float>());
+                break;
+            }
+            case Command::SetFloatArray3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<3>(state, uniformInfo, reader.ReadArray<float>());
+                break;
+            }
+            case Command::SetFloatArray4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTypeArrayN<4>(state, uniformInfo, reader.ReadArray<float>());
+                break;
+            }
+            case Command::SetFloat:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetFloatN<1>(state, uniformInfo, reader.ReadSpan<float>(1));
+                break;
+            }
+            case Command::SetFloat2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetFloatN<2>(state, uniformInfo, reader.ReadSpan<float>(2));
+                break;
+            }
+            case Command::SetFloat3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetFloatN<3>(state, uniformInfo, reader.ReadSpan<float>(3));
+                break;
+            }
+            case Command::SetFloat4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetFloatN<4>(state, uniformInfo, reader.ReadSpan<float>(4));
+                break;
+            }
+            case Command::SetTexture:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetTexture(state, uniformInfo, reader.ReadObject<TextureData>());
+                break;
+            }
+            case Command::SetTextureSampling:
+            {
+                auto& texture = reader.ReadObject<TextureData>();
+                SetTextureSampling(texture, reader.ReadUint32());
+                break;
+            }
+            case Command::SetTextureWrapMode:
+            {
+                auto& texture = reader.ReadObject<TextureData>();
+                const auto addressModeU = reader.ReadUint32();
+                const auto addressModeV = reader.ReadUint32();
+                const auto addressModeW = reader.ReadUint32();
+                SetTextureWrapMode(texture, addressModeU, addressModeV, addressModeW);
+                break;
+            }
+            case Command::SetTextureAnisotropicLevel:
+            {
+                auto& texture = reader.ReadObject<TextureData>();
+                SetTextureAnisotropicLevel(texture, reader.ReadUint32());
+                break;
+            }
+            case Command::BindFrameBuffer:
+                m_frameBufferManager.Bind(&reader.ReadObject<FrameBufferData>());
+                break;
+            case Command::UnbindFrameBuffer:
+                m_frameBufferManager.Unbind(&reader.ReadObject<FrameBufferData>());
+                break;
+            case Command::DrawIndexed:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto elementStart = reader.ReadInt32();
+                const auto elementCount = reader.ReadInt32();
+                DrawIndexed(state, fillMode, elementStart, elementCount);
+                break;
+            }
+            case Command::Draw:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto verticesStart = reader.ReadInt32();
+                const auto verticesCount = reader.ReadInt32();
+                Draw(state, fillMode, verticesStart, verticesCount);
+                break;
+            }
+            case Command::DrawIndexedInstanced:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto elementStart = reader.ReadInt32();
+                const auto elementCount = reader.ReadInt32();
+                const auto instanceCount = reader.ReadUint32();
+                DrawIndexed(state, fillMode, elementStart, elementCount, instanceCount);
+                break;
+            }
+            case Command::DrawInstanced:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto verticesStart = reader.ReadInt32();
+                const auto verticesCount = reader.ReadInt32();
+                const auto instanceCount = reader.ReadUint32();
+                Draw(state, fillMode, verticesStart, verticesCount, instanceCount);
+                break;
+            }
+            case Command::Clear:
+                m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateFlags(static_cast<uint16_t>(reader.ReadUint32()));
+                break;
+            case Command::ClearColor:
+            {
+                const auto r = reader.ReadFloat();
+                const auto g = reader.ReadFloat();
+                const auto b = reader.ReadFloat();
+                const auto a = reader.ReadFloat();
+                m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateColor(r, g, b, a);
+                break;
+            }
+            case Command::ClearDepth:
+                m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateDepth(reader.ReadFloat());
+                break;
+            case Command::ClearStencil:
+                m_frameBufferManager.UseBoundForClear().ViewClearState.UpdateStencil(static_cast<uint8_t>(reader.ReadInt32()));
+                break;
+            case Command::SetViewPort:
+            {
+                const auto x = reader.ReadFloat();
+                const auto y = reader.ReadFloat();
+                const auto width = reader.ReadFloat();
+                const auto height = reader.ReadFloat();
+                SetViewPort(x, y, width, height);
+                break;
+            }
+            default:
+                throw std::runtime_error{"Unknown command in command stream."};
+        }
+    }
+
     void NativeEngine::Dispatch(std::function<void()> function)
     {
         m_runtime.Dispatch([function = std::move(function)](Napi::Env) {
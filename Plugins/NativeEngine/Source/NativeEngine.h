@@ -1,6 +1,16 @@
 #pragma once
 
+#include "BackBufferCompositor.h"
+#include "CommandStream.h"
+#include "EncoderThreadPool.h"
+#include "RenderStateCache.h"
+#include "RenderTargetPool.h"
 #include "ShaderCompiler.h"
+#include "ShaderCompilerPool.h"
+#include "TextureDecodePool.h"
+#include "TextureResidencyManager.h"
+#include "TextureStreamer.h"
+#include "VertexLayoutCache.h"
 #include "BgfxCallback.h"
 
 #include <Babylon/JsRuntime.h>
@@ -18,10 +28,19 @@
 #include <gsl/gsl>
 
 #include <assert.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
 
 #include <arcana/containers/weak_table.h>
 #include <arcana/threading/cancellation.h>
+#include <atomic>
+#include <map>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace Babylon
 {
@@ -43,14 +62,22 @@ namespace Babylon
 
         void UpdateFlags(const Napi::CallbackInfo& info)
         {
-            const auto flags = static_cast<uint16_t>(info[0].As<Napi::Number>().Uint32Value());
+            UpdateFlags(static_cast<uint16_t>(info[0].As<Napi::Number>().Uint32Value()));
+        }
+
+        void UpdateFlags(uint16_t flags)
+        {
             Flags = flags;
             Update();
         }
 
         void UpdateDepth(const Napi::CallbackInfo& info)
         {
-            const auto depth = info[0].As<Napi::Number>().FloatValue();
+            UpdateDepth(info[0].As<Napi::Number>().FloatValue());
+        }
+
+        void UpdateDepth(float depth)
+        {
             const bool needToUpdate = Depth != depth;
             if (needToUpdate)
             {
@@ -61,7 +88,11 @@ namespace Babylon
 
         void UpdateStencil(const Napi::CallbackInfo& info)
         {
-            const auto stencil = static_cast<uint8_t>(info[0].As<Napi::Number>().Int32Value());
+            UpdateStencil(static_cast<uint8_t>(info[0].As<Napi::Number>().Int32Value()));
+        }
+
+        void UpdateStencil(uint8_t stencil)
+        {
             const bool needToUpdate = Stencil != stencil;
             if (needToUpdate)
             {
@@ -136,16 +167,31 @@ namespace Babylon
             m_clearState.UpdateFlags(info);
         }
 
+        void UpdateFlags(uint16_t flags)
+        {
+            m_clearState.UpdateFlags(flags);
+        }
+
         void UpdateDepth(const Napi::CallbackInfo& info)
         {
             m_clearState.UpdateDepth(info);
         }
 
+        void UpdateDepth(float depth)
+        {
+            m_clearState.UpdateDepth(depth);
+        }
+
         void UpdateStencil(const Napi::CallbackInfo& info)
         {
             m_clearState.UpdateStencil(info);
         }
 
+        void UpdateStencil(uint8_t stencil)
+        {
+            m_clearState.UpdateStencil(stencil);
+        }
+
         void UpdateViewId(uint16_t viewId)
         {
             m_viewId = viewId;
@@ -164,6 +210,7 @@ namespace Babylon
                 // Submit an empty primitive so we always clear the framebuffer on bgfx::frame,
                 // even if no other geometry is rendered to this view.
                 bgfx::touch(m_viewId);
+                RenderStateCache::NotifyDiscarded();
             }
         }
 
@@ -209,7 +256,11 @@ namespace Babylon
 
         ~FrameBufferData()
         {
-            bgfx::destroy(FrameBuffer);
+            // Pooled frame buffers go back to the pool when the lease is released instead.
+            if (RenderTarget == nullptr)
+            {
+                bgfx::destroy(FrameBuffer);
+            }
         }
 
         void UseViewId(uint16_t viewId)
@@ -228,6 +279,7 @@ namespace Babylon
 
         void SetViewPort(const float x, const float y, const float width, const float height)
         {
+            ViewPort = {x, y, width, height};
             const auto viewRectWidth = SizeViewToWindow ? bgfx::getStats()->width : Width;
             const auto viewRectHeight = SizeViewToWindow ? bgfx::getStats()->height : Height;
             bgfx::setViewRect(ViewId,
@@ -238,8 +290,12 @@ namespace Babylon
         }
 
         bgfx::FrameBufferHandle FrameBuffer{bgfx::kInvalidHandle};
+        RenderTargetPool::Lease RenderTarget{};
         bgfx::ViewId ViewId{uint16_t(~0)};
         bool IsViewIdDirty{true};
+        bool IsRenderedThisFrame{false};
+        // The viewport of the current view, relative to the size of the frame buffer.
+        std::array<float, 4> ViewPort{0.f, 0.f, 1.f, 1.f};
         Babylon::ViewClearState ViewClearState;
         uint16_t Width{};
         uint16_t Height{};
@@ -253,6 +309,13 @@ namespace Babylon
 
     struct FrameBufferManager final
     {
+        // Draws a texture over the whole of a view that renders to the back buffer.
+        using Compositor = std::function<void(bgfx::ViewId viewId, bgfx::TextureHandle texture)>;
+
+        // Once a frame has been split, the back buffer is rendered offscreen for this many frames, so that
+        // the frames submitted early by later splits can present the last complete frame.
+        static constexpr uint32_t OFFSCREEN_FRAMES_AFTER_SPLIT{60};
+
         FrameBufferManager()
         {
             Bind(m_defaultBackBuffer = new FrameBufferData(BGFX_INVALID_HANDLE, m_activeFrameBuffers, GetNewViewId(), 0, 0, true, true));
@@ -268,15 +331,89 @@ namespace Babylon
             return new FrameBufferData(frameBufferHandle, m_activeFrameBuffers, GetNewViewId(), clearState, width, height, actAsBackBuffer);
         }
 
+        FrameBufferData* CreatePooled(const RenderTargetPool::Description& description)
+        {
+            auto lease = m_renderTargetPool.Acquire(description);
+            auto data = new FrameBufferData(*lease, m_activeFrameBuffers, GetNewViewId(), description.Width, description.Height);
+            data->RenderTarget = std::move(lease);
+            return data;
+        }
+
+        RenderTargetPool& GetRenderTargetPool()
+        {
+            return m_renderTargetPool;
+        }
+
+        // Releases the frame buffers of the manager, which must happen before bgfx::shutdown.
+        void Dispose()
+        {
+            m_offscreenBackBuffer = {};
+            m_defaultBackBuffer->FrameBuffer = m_backBuffer;
+            m_renderTargetPool.Clear();
+        }
+
+        // Called before the frame is split, so that draws recorded for its views on other encoders can be
+        // finished before it is submitted.
+        void SetBeforeSplitCallback(std::function<void()> callback)
+        {
+            m_beforeSplitCallback = std::move(callback);
+        }
+
+        // Without a compositor, the frames submitted early by splits present the back buffer as it is.
+        void SetCompositor(Compositor compositor)
+        {
+            m_compositor = std::move(compositor);
+        }
+
+        // Called at the start of every frame. Headless graphics render the back buffer into a frame buffer
+        // of their own, recreated on resize.
+        void SetBackBuffer(bgfx::FrameBufferHandle frameBufferHandle)
+        {
+            m_backBuffer = frameBufferHandle;
+            if (m_offscreenBackBuffer.RemainingFrames > 0)
+            {
+                RedirectBackBuffer();
+            }
+            else
+            {
+                SetDefaultFrameBuffer(frameBufferHandle);
+            }
+        }
+
+        // Views are rendered in the order their frame buffers were bound, so that passes that sample a render
+        // target come after the passes that rendered it. Binding a frame buffer again moves its latest view
+        // after all others and keeps drawing into it, as long as no later view renders to or samples what
+        // that view renders to or samples. A view nothing was submitted to is handed over to the next bind
+        // instead of being wasted.
         void Bind(FrameBufferData* data)
         {
-            m_boundFrameBuffer = data;
+            if (data == m_boundFrameBuffer && !data->IsViewIdDirty)
+            {
+                return;
+            }
 
-            const auto fbViewId = m_boundFrameBuffer->IsViewIdDirty ? GetNewViewId() : m_boundFrameBuffer->ViewId;
-            m_boundFrameBuffer->UseViewId(fbViewId);
+            if (!data->IsViewIdDirty && TryReuseView(*data))
+            {
+                m_boundFrameBuffer = data;
+            }
+            else
+            {
+                bgfx::ViewId viewId{};
+                if (m_boundFrameBuffer != nullptr && !m_boundFrameBuffer->IsViewIdDirty && !m_views.back().Used)
+                {
+                    viewId = m_views.back().Id;
+                    m_views.pop_back();
+                    m_boundFrameBuffer->IsViewIdDirty = true;
+                }
+                else
+                {
+                    viewId = GetNewViewId();
+                }
+
+                m_boundFrameBuffer = data;
+                AssignBoundView(viewId);
+            }
 
-            // bgfx::setTexture()? Why?
-            // TODO: View order?
             m_renderingToTarget = !m_boundFrameBuffer->ActAsBackBuffer;
         }
 
@@ -285,6 +422,68 @@ namespace Babylon
             return *m_boundFrameBuffer;
         }
 
+        // Returns the bound frame buffer for a draw, marking its view as used.
+        FrameBufferData& UseBound()
+        {
+            auto& view = m_views.back();
+            view.Used = true;
+            view.HasDraws = true;
+            m_boundFrameBuffer->IsRenderedThisFrame = true;
+            return *m_boundFrameBuffer;
+        }
+
+        // Returns the bound frame buffer for a clear. bgfx clears a view before anything is drawn in it, so a
+        // clear that follows draws starts a new view.
+        FrameBufferData& UseBoundForClear()
+        {
+            if (m_views.back().HasDraws)
+            {
+                StartBoundView();
+            }
+
+            m_views.back().Used = true;
+            m_boundFrameBuffer->IsRenderedThisFrame = true;
+            return *m_boundFrameBuffer;
+        }
+
+        // Returns the bound frame buffer for a pass encoded on another thread. Passes are encoded concurrently,
+        // so a pass never shares its view with earlier draws or passes, which would make the order of their
+        // draws depend on the encoders. The textures sampled by such passes are not reported, so their views
+        // are never reordered.
+        FrameBufferData& UsePassBound()
+        {
+            if (m_views.back().HasDraws)
+            {
+                StartBoundView();
+            }
+
+            UseBound();
+            m_views.back().ReadsUnknown = true;
+            return *m_boundFrameBuffer;
+        }
+
+        // Reports a texture sampled by a draw in the bound view.
+        void NotifySampled(bgfx::TextureHandle texture)
+        {
+            auto& reads = m_views.back().Reads;
+            if (std::find(reads.begin(), reads.end(), texture.idx) == reads.end())
+            {
+                reads.push_back(texture.idx);
+            }
+        }
+
+        // The view rect applies to everything in the view, so a viewport change that follows a draw or a
+        // clear starts a new view.
+        void SetViewPort(float x, float y, float width, float height)
+        {
+            if (m_views.back().Used && m_boundFrameBuffer->ViewPort != std::array<float, 4>{x, y, width, height})
+            {
+                StartBoundView();
+            }
+
+            m_boundFrameBuffer->SetViewPort(x, y, width, height);
+        }
+
         void Unbind(FrameBufferData* data)
         {
             (void)data;
@@ -297,17 +496,43 @@ namespace Babylon
 
         uint16_t GetNewViewId()
         {
+            // The last two views are left to compositing the back buffer and to Graphics, which reads back
+            // headless frames in the last one.
+            if (m_nextId + 3u >= bgfx::getCaps()->limits.maxViews)
+            {
+                SplitFrame();
+            }
+
             m_nextId++;
-            assert(m_nextId < bgfx::getCaps()->limits.maxViews);
             return m_nextId;
         }
 
         void Reset()
         {
+            if (m_offscreenBackBuffer.IsActive)
+            {
+                FinishOffscreenFrame();
+            }
+
+            m_renderTargetPool.Trim();
             m_nextId = 0;
+            m_views.clear();
             m_activeFrameBuffers.apply_to_all([](auto frameBufferData) {
                 frameBufferData->IsViewIdDirty = true;
+                frameBufferData->IsRenderedThisFrame = false;
             });
+
+            // The bound frame buffer starts the next frame with its first view.
+            AssignBoundView(++m_nextId);
+
+            // The view order of this frame must stay in effect until the frame is submitted, so the next frame
+            // restores the default order once it assigns a view.
+            m_isViewOrderStale = m_isViewOrderChanged;
+        }
+
+        uint64_t GetFrameSplitCount() const
+        {
+            return m_frameSplitCount;
         }
 
         bool IsRenderingToTarget() const
@@ -316,10 +541,300 @@ namespace Babylon
         }
 
     private:
+        // A view of the current frame. Frame buffers and textures are identified by their bgfx handle index.
+        struct View
+        {
+            bgfx::ViewId Id{};
+            uint16_t FrameBuffer{bgfx::kInvalidHandle};
+            bool BackBuffer{false};
+            // The color and depth textures rendered to, and the textures sampled by the draws of the view.
+            std::array<uint16_t, 2> Writes{bgfx::kInvalidHandle, bgfx::kInvalidHandle};
+            std::vector<uint16_t> Reads{};
+            bool ReadsUnknown{false};
+            // Whether anything was submitted to the view, and whether any of it was a draw.
+            bool Used{false};
+            bool HasDraws{false};
+        };
+
+        // The back buffer rendered offscreen after a frame has been split. Two targets are used in turn, so
+        // that the previous frame can still be presented while the current one is rendered.
+        struct OffscreenBackBuffer
+        {
+            RenderTargetPool::Description TargetDescription{};
+            std::array<RenderTargetPool::Lease, 2> Targets{};
+            size_t Current{0};
+            bool IsActive{false};
+            bool HasPreviousFrame{false};
+            uint32_t RemainingFrames{0};
+        };
+
+        void AssignBoundView(bgfx::ViewId viewId)
+        {
+            if (m_isViewOrderStale)
+            {
+                ResetViewOrder();
+            }
+
+            m_boundFrameBuffer->IsViewIdDirty = true;
+            m_boundFrameBuffer->UseViewId(viewId);
+            if (m_boundFrameBuffer->IsRenderedThisFrame)
+            {
+                // The frame buffer already has content from an earlier view of this frame, which must be kept
+                // unless it is cleared again.
+                bgfx::setViewClear(viewId, BGFX_CLEAR_NONE);
+            }
+
+            View view{};
+            view.Id = viewId;
+            view.FrameBuffer = m_boundFrameBuffer->FrameBuffer.idx;
+            view.BackBuffer = m_boundFrameBuffer == m_defaultBackBuffer;
+            if (!view.BackBuffer && bgfx::isValid(m_boundFrameBuffer->FrameBuffer))
+            {
+                for (uint8_t attachment = 0; attachment < view.Writes.size(); ++attachment)
+                {
+                    view.Writes[attachment] = bgfx::getTexture(m_boundFrameBuffer->FrameBuffer, attachment).idx;
+                }
+            }
+            m_views.push_back(std::move(view));
+        }
+
+        // Continues the bound frame buffer in a view of its own, with the same viewport.
+        void StartBoundView()
+        {
+            const auto viewPort = m_boundFrameBuffer->ViewPort;
+            AssignBoundView(GetNewViewId());
+            m_boundFrameBuffer->SetViewPort(viewPort[0], viewPort[1], viewPort[2], viewPort[3]);
+        }
+
+        // Moves the latest view of the frame buffer after all others if that keeps every view that depends on
+        // another one after it. A rebind resets the viewport, so views with another viewport are not reused.
+        bool TryReuseView(FrameBufferData& data)
+        {
+            const auto view = std::find_if(m_views.begin(), m_views.end(), [&data](const View& candidate) {
+                return candidate.Id == data.ViewId;
+            });
+
+            if (view == m_views.end() || data.ViewPort != std::array<float, 4>{0.f, 0.f, 1.f, 1.f})
+            {
+                return false;
+            }
+
+            for (auto later = view + 1; later != m_views.end(); ++later)
+            {
+                if (later->Used && AreDependent(*view, *later))
+                {
+                    return false;
+                }
+            }
+
+            if (view + 1 != m_views.end())
+            {
+                std::rotate(view, view + 1, m_views.end());
+                UpdateViewOrder();
+            }
+
+            return true;
+        }
+
+        static bool AreDependent(const View& first, const View& second)
+        {
+            if (first.ReadsUnknown || second.ReadsUnknown || first.FrameBuffer == second.FrameBuffer || (first.BackBuffer && second.BackBuffer))
+            {
+                return true;
+            }
+
+            const auto contains = [](const auto& textures, uint16_t texture) {
+                return std::find(textures.begin(), textures.end(), texture) != textures.end();
+            };
+
+            for (const auto texture : first.Writes)
+            {
+                if (texture != bgfx::kInvalidHandle && (contains(second.Reads, texture) || contains(second.Writes, texture)))
+                {
+                    return true;
+                }
+            }
+
+            for (const auto texture : second.Writes)
+            {
+                if (texture != bgfx::kInvalidHandle && contains(first.Reads, texture))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Renders the views of the frame in the order of m_views. View 0 belongs to Graphics and stays first,
+        // and the views not in use follow in id order, which keeps the last two views last and puts the views
+        // assigned later in the frame after the others.
+        void UpdateViewOrder()
+        {
+            const auto maxViews = static_cast<uint16_t>(bgfx::getCaps()->limits.maxViews);
+            std::vector<bool> isOrdered(maxViews, false);
+
+            m_viewOrder.clear();
+            m_viewOrder.push_back(0);
+            isOrdered[0] = true;
+            for (const auto& view : m_views)
+            {
+                m_viewOrder.push_back(view.Id);
+                isOrdered[view.Id] = true;
+            }
+
+            for (bgfx::ViewId viewId = 0; viewId < maxViews; ++viewId)
+            {
+                if (!isOrdered[viewId])
+                {
+                    m_viewOrder.push_back(viewId);
+                }
+            }
+
+            bgfx::setViewOrder(0, maxViews, m_viewOrder.data());
+            m_isViewOrderChanged = true;
+            m_isViewOrderStale = false;
+        }
+
+        void ResetViewOrder()
+        {
+            if (m_isViewOrderChanged)
+            {
+                bgfx::setViewOrder(0, static_cast<uint16_t>(bgfx::getCaps()->limits.maxViews), nullptr);
+            }
+
+            m_isViewOrderChanged = false;
+            m_isViewOrderStale = false;
+        }
+
+        void SetDefaultFrameBuffer(bgfx::FrameBufferHandle frameBufferHandle)
+        {
+            if (m_defaultBackBuffer->FrameBuffer.idx != frameBufferHandle.idx)
+            {
+                m_defaultBackBuffer->FrameBuffer = frameBufferHandle;
+                if (!m_defaultBackBuffer->IsViewIdDirty)
+                {
+                    bgfx::setViewFrameBuffer(m_defaultBackBuffer->ViewId, frameBufferHandle);
+                }
+            }
+        }
+
+        // Renders the back buffer of the rest of the frame offscreen, including the views of the frame that
+        // already render to it.
+        void RedirectBackBuffer()
+        {
+            auto& offscreen = m_offscreenBackBuffer;
+            const auto* stats = bgfx::getStats();
+            const RenderTargetPool::Description description{stats->width, stats->height, bgfx::TextureFormat::RGBA8, RenderTargetPool::DepthStencil::DepthStencil, false};
+            if (offscreen.Targets[0] == nullptr || !(offscreen.TargetDescription == description))
+            {
+                for (auto& target : offscreen.Targets)
+                {
+                    target = m_renderTargetPool.Acquire(description);
+                }
+
+                offscreen.TargetDescription = description;
+                offscreen.HasPreviousFrame = false;
+            }
+
+            const bgfx::FrameBufferHandle target{*offscreen.Targets[offscreen.Current]};
+            for (const auto& view : m_views)
+            {
+                if (view.BackBuffer)
+                {
+                    bgfx::setViewFrameBuffer(view.Id, target);
+                }
+            }
+
+            SetDefaultFrameBuffer(target);
+            offscreen.IsActive = true;
+        }
+
+        // Copies the offscreen back buffer of the frame to the back buffer, which Reset then hands back to the
+        // default frame buffer for the views that the next frame assigns before it starts.
+        void FinishOffscreenFrame()
+        {
+            auto& offscreen = m_offscreenBackBuffer;
+            Composite(offscreen.Current);
+            offscreen.HasPreviousFrame = true;
+            offscreen.Current = 1 - offscreen.Current;
+            offscreen.IsActive = false;
+            m_defaultBackBuffer->FrameBuffer = m_backBuffer;
+
+            if (--offscreen.RemainingFrames == 0)
+            {
+                offscreen = {};
+            }
+        }
+
+        void Composite(size_t targetIndex)
+        {
+            const auto viewId = static_cast<bgfx::ViewId>(bgfx::getCaps()->limits.maxViews - 2);
+            const auto* stats = bgfx::getStats();
+            bgfx::setViewFrameBuffer(viewId, m_backBuffer);
+            bgfx::setViewRect(viewId, 0, 0, stats->width, stats->height);
+            bgfx::setViewClear(viewId, BGFX_CLEAR_NONE);
+            m_compositor(viewId, bgfx::getTexture(*m_offscreenBackBuffer.Targets[targetIndex]));
+        }
+
+        // Submits the views recorded so far as a frame of their own when the frame needs more views than
+        // bgfx supports, so that the rest of it can start over from the first view id. A half drawn back
+        // buffer must not be presented, so the back buffer is rendered offscreen from then on and the frame
+        // submitted early presents the last complete frame instead. The first split has none yet and leaves
+        // the back buffer as it is.
+        void SplitFrame()
+        {
+            if (m_beforeSplitCallback)
+            {
+                m_beforeSplitCallback();
+            }
+
+            if (m_compositor)
+            {
+                m_offscreenBackBuffer.RemainingFrames = OFFSCREEN_FRAMES_AFTER_SPLIT;
+                if (!m_offscreenBackBuffer.IsActive)
+                {
+                    RedirectBackBuffer();
+                }
+
+                if (m_offscreenBackBuffer.HasPreviousFrame)
+                {
+                    Composite(1 - m_offscreenBackBuffer.Current);
+                }
+            }
+
+            bgfx::frame();
+            RenderStateCache::NotifyDiscarded();
+            ++m_frameSplitCount;
+            ResetViewOrder();
+
+            m_nextId = 0;
+            m_views.clear();
+            m_activeFrameBuffers.apply_to_all([](auto frameBufferData) {
+                frameBufferData->IsViewIdDirty = true;
+            });
+
+            if (m_boundFrameBuffer != nullptr)
+            {
+                AssignBoundView(++m_nextId);
+            }
+        }
+
         FrameBufferData* m_boundFrameBuffer{nullptr};
         FrameBufferData* m_defaultBackBuffer{nullptr};
+        bgfx::FrameBufferHandle m_backBuffer{bgfx::kInvalidHandle};
         arcana::weak_table<FrameBufferData*> m_activeFrameBuffers{};
+        RenderTargetPool m_renderTargetPool{};
+        OffscreenBackBuffer m_offscreenBackBuffer{};
+        std::function<void()> m_beforeSplitCallback{};
+        Compositor m_compositor{};
+        // The views of the frame in the order they are rendered. The last one belongs to the bound frame buffer.
+        std::vector<View> m_views{};
+        std::vector<bgfx::ViewId> m_viewOrder{};
+        bool m_isViewOrderChanged{false};
+        bool m_isViewOrderStale{false};
         uint16_t m_nextId{0};
+        uint64_t m_frameSplitCount{0};
         bool m_renderingToTarget{false};
     };
 
@@ -327,17 +842,29 @@ namespace Babylon
     {
         ~TextureData()
         {
-            if (bgfx::isValid(Handle))
+            // The texture of a pooled render target belongs to its frame buffer.
+            if (RenderTarget == nullptr && bgfx::isValid(Handle))
             {
                 bgfx::destroy(Handle);
             }
         }
 
         bgfx::TextureHandle Handle{bgfx::kInvalidHandle};
+        RenderTargetPool::Lease RenderTarget{};
         uint32_t Width{0};
         uint32_t Height{0};
         uint32_t Flags{0};
         uint8_t AnisotropicLevel{0};
+
+        // Residency bookkeeping, see TextureResidencyManager. Written when the texture is created or evicted
+        // and read by the residency manager on another thread.
+        std::atomic<uint64_t> ByteSize{0};
+        std::atomic<uint32_t> LastUsedFrame{0};
+        std::atomic<bool> Evicted{false};
+
+        // Expires when the texture is deleted, so that loads completing afterwards leave it alone. The
+        // texture itself is only deleted after the next frame, see NativeEngine::DeleteTexture.
+        std::shared_ptr<void> Lifetime{std::make_shared<bool>()};
     };
 
     struct UniformInfo final
@@ -345,6 +872,8 @@ namespace Babylon
         uint8_t Stage{};
         bgfx::UniformHandle Handle{bgfx::kInvalidHandle};
         bool YFlip{false};
+        // Index of this uniform in the owning program's uniform slots.
+        uint16_t Slot{};
     };
 
     struct ProgramData final
@@ -364,22 +893,72 @@ namespace Babylon
 
         bgfx::ProgramHandle Program{};
 
-        struct UniformValue
+        // Each non-sampler uniform of the program owns a fixed range of the uniform block, assigned when the
+        // program is created, so setting a value never allocates. A slot is marked dirty when its value
+        // changes and cleared once the value has been handed to bgfx.
+        struct UniformSlot
         {
-            std::vector<float> Data{};
+            bgfx::UniformHandle Handle{bgfx::kInvalidHandle};
+            uint32_t Offset{};
+            uint32_t Capacity{};
+            // The number of floats per element: 4 for vectors, 16 for matrices.
+            uint32_t ElementStride{};
             uint16_t ElementLength{};
             bool YFlip{false};
+            bool Dirty{false};
         };
 
-        std::unordered_map<uint16_t, UniformValue> Uniforms{};
-
-        void SetUniform(bgfx::UniformHandle handle, gsl::span<const float> data, bool YFlip, size_t elementLength = 1)
+        struct UniformValues
         {
-            UniformValue& value = Uniforms[handle.idx];
-            value.Data.assign(data.begin(), data.end());
-            value.ElementLength = static_cast<uint16_t>(elementLength);
-            value.YFlip = YFlip;
-        }
+            std::vector<UniformSlot> Slots{};
+            std::vector<float> Block{};
+
+            // Returns the slot of the uniform, or nullptr if the program does not use it.
+            UniformSlot* Set(const UniformInfo& info, gsl::span<const float> data, size_t elementLength = 1)
+            {
+                UniformSlot* slot{Find(info)};
+                if (slot == nullptr)
+                {
+                    return nullptr;
+                }
+
+                // bgfx reads ElementLength whole elements, which must all fit in the slot.
+                const size_t size{std::min(static_cast<size_t>(data.size()), static_cast<size_t>(slot->Capacity))};
+                float* const destination{Block.data() + slot->Offset};
+                const auto length{static_cast<uint16_t>(std::min(elementLength, static_cast<size_t>(slot->Capacity / slot->ElementStride)))};
+                if (slot->ElementLength == length && std::memcmp(destination, data.data(), size * sizeof(float)) == 0)
+                {
+                    return slot;
+                }
+
+                std::memcpy(destination, data.data(), size * sizeof(float));
+                slot->ElementLength = length;
+                slot->Dirty = true;
+                return slot;
+            }
+
+        private:
+            UniformSlot* Find(const UniformInfo& info)
+            {
+                if (info.Slot < Slots.size() && Slots[info.Slot].Handle.idx == info.Handle.idx)
+                {
+                    return &Slots[info.Slot];
+                }
+
+                // The uniform was looked up on a different program that shares the same bgfx uniform.
+                for (auto& slot : Slots)
+                {
+                    if (slot.Handle.idx == info.Handle.idx)
+                    {
+                        return &slot;
+                    }
+                }
+
+                return nullptr;
+            }
+        };
+
+        UniformValues Uniforms{};
     };
 
     class IndexBufferData;
@@ -387,14 +966,19 @@ namespace Babylon
 
     struct VertexArray final
     {
+        explicit VertexArray(std::shared_ptr<VertexLayoutCache> layoutCache)
+            : vertexLayoutCache{std::move(layoutCache)}
+        {
+        }
+
         ~VertexArray()
         {
-            for (auto& vertexBufferPair : vertexBuffers)
-            {
-                bgfx::destroy(vertexBufferPair.second.vertexLayoutHandle);
-            }
+            ReleaseVertexBuffers();
         }
 
+        VertexArray(const VertexArray&) = delete;
+        VertexArray& operator=(const VertexArray&) = delete;
+
         struct IndexBuffer
         {
             const IndexBufferData* data{};
@@ -402,6 +986,19 @@ namespace Babylon
 
         IndexBuffer indexBuffer{};
 
+        struct VertexAttribute
+        {
+            const VertexBufferData* data{};
+            uint32_t byteOffset{};
+            uint32_t byteStride{};
+            uint8_t numElements{};
+            bgfx::AttribType::Enum type{};
+            bool normalized{};
+        };
+
+        // Attributes recorded per location. They are combined into vertex buffers on the next bind.
+        std::map<uint32_t, VertexAttribute> vertexAttributes;
+
         struct VertexBuffer
         {
             const VertexBufferData* data{};
@@ -409,7 +1006,126 @@ namespace Babylon
             bgfx::VertexLayoutHandle vertexLayoutHandle{};
         };
 
-        std::unordered_map<uint32_t, VertexBuffer> vertexBuffers;
+        // One entry per bgfx vertex stream.
+        std::vector<VertexBuffer> vertexBuffers;
+        bool vertexBuffersDirty{false};
+
+        // Attributes that read from the same buffer with the same stride and starting vertex share a single
+        // interleaved stream whose layout is interned in the layout cache.
+        void UpdateVertexBuffers();
+
+        // Per-instance attributes all come from a single bgfx instance data buffer.
+        struct InstanceBuffer
+        {
+            const VertexBufferData* data{};
+            uint32_t byteOffset{};
+            uint32_t byteStride{};
+        };
+
+        InstanceBuffer instanceBuffer{};
+
+    private:
+        void ReleaseVertexBuffers();
+
+        // Shared with the engine so that vertex arrays finalized after the engine is disposed can still
+        // release their layouts.
+        std::shared_ptr<VertexLayoutCache> vertexLayoutCache;
+    };
+
+    /// The draw state that WebGL keeps per context: the current program, vertex array and render state, which
+    /// are recorded into one bgfx encoder. The NativeEngine methods share the state of the JavaScript thread,
+    /// while each pass given to submitCommandPasses gets a state of its own so that passes can be encoded on
+    /// worker threads. Uniform values belong to programs, which passes share, so a pass sets uniforms on
+    /// copies of them that are written back to the programs once all passes have been encoded.
+    struct EncoderState final
+    {
+        struct PassUniforms
+        {
+            ProgramData::UniformValues Values{};
+            std::vector<bool> Written{};
+        };
+
+        // What only the state of a pass has.
+        struct Pass
+        {
+            // The view of the frame buffer bound by the pass, assigned on the JavaScript thread.
+            bgfx::ViewId ViewId{};
+            bool RenderingToTarget{false};
+
+            std::unordered_map<ProgramData*, PassUniforms> Uniforms{};
+            // Evicted textures are reloaded on the JavaScript thread once the pass has been encoded.
+            std::vector<TextureData*> EvictedTextures{};
+        };
+
+        RenderStateCache StateCache{};
+        ProgramData* CurrentProgram{nullptr};
+        uint64_t EngineState{BGFX_STATE_DEFAULT};
+
+        // webgl/opengl draw call parameters allow to set first index and number of indices used for that call
+        // but with bgfx, those parameters must be set when binding the index buffer
+        // at the time of webgl binding, we don't know those values yet
+        // so a pointer to the to-bind buffer is kept and the buffer is bound to bgfx at the time of the drawcall
+        const IndexBufferData* CurrentBoundIndexBuffer{};
+        VertexArray::InstanceBuffer CurrentBoundInstanceBuffer{};
+
+        // Scratch vector used for data alignment.
+        std::vector<float> Scratch{};
+
+        std::optional<Pass> PassState{};
+
+        ProgramData::UniformValues& GetUniforms(ProgramData& program)
+        {
+            return PassState.has_value() ? GetPassUniforms(program).Values : program.Uniforms;
+        }
+
+        void SetUniform(const UniformInfo& info, gsl::span<const float> data, size_t elementLength = 1)
+        {
+            if (!PassState.has_value())
+            {
+                CurrentProgram->Uniforms.Set(info, data, elementLength);
+                return;
+            }
+
+            auto& uniforms = GetPassUniforms(*CurrentProgram);
+            const auto* slot = uniforms.Values.Set(info, data, elementLength);
+            if (slot != nullptr)
+            {
+                uniforms.Written[slot - uniforms.Values.Slots.data()] = true;
+            }
+        }
+
+        // Writes the uniform values set by the pass back to their programs.
+        void CommitPassUniforms()
+        {
+            for (auto& [program, uniforms] : PassState->Uniforms)
+            {
+                for (size_t index = 0; index < uniforms.Written.size(); ++index)
+                {
+                    if (!uniforms.Written[index])
+                    {
+                        continue;
+                    }
+
+                    const auto& source = uniforms.Values.Slots[index];
+                    auto& destination = program->Uniforms.Slots[index];
+                    std::copy_n(uniforms.Values.Block.data() + source.Offset, source.Capacity, program->Uniforms.Block.data() + destination.Offset);
+                    destination.ElementLength = source.ElementLength;
+                    destination.Dirty = true;
+                }
+            }
+        }
+
+    private:
+        PassUniforms& GetPassUniforms(ProgramData& program)
+        {
+            auto it = PassState->Uniforms.find(&program);
+            if (it == PassState->Uniforms.end())
+            {
+                // Programs are not modified while passes are encoded, so the copy is taken on first use.
+                it = PassState->Uniforms.emplace(&program, PassUniforms{program.Uniforms, std::vector<bool>(program.Uniforms.Slots.size())}).first;
+            }
+            return it->second;
+        }
     };
 
     class NativeEngine final : public Napi::ObjectWrap<NativeEngine>
@@ -433,6 +1149,8 @@ namespace Babylon
 
         const bool AutomaticRenderingEnabled{};
         JsRuntimeScheduler RuntimeScheduler;
+        // Runs frame callbacks ahead of any other work on the JavaScript thread.
+        JsRuntimeScheduler FrameScheduler;
 
     private:
         void Dispose();
@@ -451,7 +1169,10 @@ namespace Babylon
         void DeleteVertexBuffer(const Napi::CallbackInfo& info);
         void RecordVertexBuffer(const Napi::CallbackInfo& info);
         void UpdateDynamicVertexBuffer(const Napi::CallbackInfo& info);
+        void RecordInstanceAttribute(Napi::Env env, VertexArray& vertexArray, const VertexBufferData& vertexBufferData, uint32_t location, uint32_t byteOffset, uint32_t byteStride);
         Napi::Value CreateProgram(const Napi::CallbackInfo& info);
+        Napi::Value CreateProgramAsync(const Napi::CallbackInfo& info);
+        Napi::Value GetShaderCompilerStatistics(const Napi::CallbackInfo& info);
         Napi::Value GetUniforms(const Napi::CallbackInfo& info);
         Napi::Value GetAttributes(const Napi::CallbackInfo& info);
         void SetProgram(const Napi::CallbackInfo& info);
@@ -485,6 +1206,12 @@ namespace Babylon
         void LoadTexture(const Napi::CallbackInfo& info);
         void LoadCubeTexture(const Napi::CallbackInfo& info);
         void LoadCubeTextureWithMips(const Napi::CallbackInfo& info);
+        void SetTextureDecodeOptions(const Napi::CallbackInfo& info);
+        Napi::Value GetTextureDecodeStatistics(const Napi::CallbackInfo& info);
+        void SetTextureStreamingOptions(const Napi::CallbackInfo& info);
+        void SetTextureTargetSize(const Napi::CallbackInfo& info);
+        void SetTextureResidencyOptions(const Napi::CallbackInfo& info);
+        Napi::Value GetTextureResidencyStatistics(const Napi::CallbackInfo& info);
         Napi::Value GetTextureWidth(const Napi::CallbackInfo& info);
         Napi::Value GetTextureHeight(const Napi::CallbackInfo& info);
         void SetTextureSampling(const Napi::CallbackInfo& info);
@@ -494,10 +1221,13 @@ namespace Babylon
         void DeleteTexture(const Napi::CallbackInfo& info);
         Napi::Value CreateFrameBuffer(const Napi::CallbackInfo& info);
         void DeleteFrameBuffer(const Napi::CallbackInfo& info);
+        Napi::Value GetRenderTargetPoolStatistics(const Napi::CallbackInfo& info);
         void BindFrameBuffer(const Napi::CallbackInfo& info);
         void UnbindFrameBuffer(const Napi::CallbackInfo& info);
         void DrawIndexed(const Napi::CallbackInfo& info);
+        void DrawIndexedInstanced(const Napi::CallbackInfo& info);
         void Draw(const Napi::CallbackInfo& info);
+        void DrawInstanced(const Napi::CallbackInfo& info);
         void Clear(const Napi::CallbackInfo& info);
         void ClearColor(const Napi::CallbackInfo& info);
         void ClearStencil(const Napi::CallbackInfo& info);
@@ -507,45 +1237,98 @@ namespace Babylon
         void SetViewPort(const Napi::CallbackInfo& info);
         void GetFramebufferData(const Napi::CallbackInfo& info);
         Napi::Value GetRenderAPI(const Napi::CallbackInfo& info);
+        void SubmitCommands(const Napi::CallbackInfo& info);
+        void SubmitCommandPasses(const Napi::CallbackInfo& info);
+        Napi::Value GetRenderStateStatistics(const Napi::CallbackInfo& info);
+
+        // Typed implementations shared by the individual methods above and by SubmitCommands, recording
+        // into the given encoder state.
+        void ExecuteCommand(EncoderState& state, CommandStreamReader& reader);
+        void BindVertexArray(EncoderState& state, VertexArray& vertexArray);
+        void SetProgram(EncoderState& state, ProgramData& program);
+        void SetState(EncoderState& state, bool culling, bool reverseSide);
+        void SetDepthTest(EncoderState& state, uint32_t depthTest);
+        void SetDepthWrite(EncoderState& state, bool enable);
+        void SetColorWrite(EncoderState& state, bool enable);
+        void SetBlendMode(EncoderState& state, uint64_t blendMode);
+        void SetTextureSampling(TextureData& texture, uint32_t filter);
+        void SetTextureWrapMode(TextureData& texture, uint32_t addressModeU, uint32_t addressModeV, uint32_t addressModeW);
+        void SetTextureAnisotropicLevel(TextureData& texture, uint32_t value);
+        void SetTexture(EncoderState& state, const UniformInfo& uniformInfo, TextureData& texture);
+        void DrawIndexed(EncoderState& state, int32_t fillMode, int32_t elementStart, int32_t elementCount, uint32_t instanceCount = 0);
+        void Draw(EncoderState& state, int32_t fillMode, int32_t verticesStart, int32_t verticesCount, uint32_t instanceCount = 0);
+        void SetViewPort(float x, float y, float width, float height);
+
+        // Runs the leading frame buffer, clear and viewport commands of a pass on the JavaScript thread and
+        // assigns the pass the view of the frame buffer bound at that point.
+        void BeginPass(EncoderState& state, CommandStreamReader& reader);
+        void EncodePass(EncoderState& state, CommandStreamReader& reader);
+        void EncodePasses(gsl::span<EncoderState> states, gsl::span<CommandStreamReader> readers);
 
         template<typename SchedulerT>
         arcana::task<void, std::exception_ptr> GetRequestAnimationFrameTask(SchedulerT&);
         
         bool m_isRenderScheduled{false};
 
+        arcana::task<void, std::exception_ptr> LoadTextureAsync(TextureData* texture, gsl::span<const uint8_t> data, bool generateMips, bool invertY, TextureDecodePool::Priority priority);
+        void ReloadTexture(TextureData& texture);
+
+        void ScheduleTextureStreaming();
+        std::atomic<bool> m_isTextureStreamingScheduled{false};
+
         arcana::cancellation_source m_cancelSource{};
 
-        ShaderCompiler m_shaderCompiler;
+        Napi::Value WrapProgramData(Napi::Env env, std::unique_ptr<ProgramData> programData);
+        arcana::task<std::unique_ptr<ProgramData>, std::exception_ptr> CreateProgramDataAsync(std::shared_ptr<ShaderCompiler::BgfxShaderInfo> shaderInfo);
+
+        ShaderCompilerPool m_shaderCompilerPool{};
+        BackBufferCompositor m_backBufferCompositor{m_shaderCompilerPool};
 
-        ProgramData* m_currentProgram{nullptr};
+        // Creating bgfx shaders can be expensive (the driver compiles them on some platforms), so programs
+        // compiled asynchronously are created at most this many at a time after each frame.
+        static constexpr uint32_t MAX_PROGRAM_CREATIONS_PER_FRAME{4};
+        std::atomic<uint32_t> m_programCreationBudget{MAX_PROGRAM_CREATIONS_PER_FRAME};
+
+        EncoderState m_encoderState{};
+        EncoderThreadPool m_encoderThreadPool{};
+        std::shared_ptr<VertexLayoutCache> m_vertexLayoutCache{std::make_shared<VertexLayoutCache>()};
+        // Vertex arrays whose vertex buffers are rebuilt on their next bind, which parallel passes cannot do.
+        std::unordered_set<VertexArray*> m_dirtyVertexArrays{};
         arcana::weak_table<std::unique_ptr<ProgramData>> m_programDataCollection{};
 
         JsRuntime& m_runtime;
         Graphics::Impl& m_graphicsImpl;
+        // Invalidates the render state caches when Graphics frames, touches or discards the encoder state.
+        Graphics::Impl::EncoderResetCallbackTicket m_encoderResetCallbackTicket;
 
         bx::DefaultAllocator m_allocator;
-        uint64_t m_engineState;
+        // Declared after the allocator so that the workers are joined before it goes away.
+        TextureDecodePool m_textureDecodePool{};
+        TextureStreamer m_textureStreamer{};
+        TextureResidencyManager m_textureResidencyManager{};
 
         FrameBufferManager m_frameBufferManager{};
 
         template<int size, typename arrayType>
         void SetTypeArrayN(const Napi::CallbackInfo& info);
 
+        template<int size, typename T>
+        void SetTypeArrayN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<T> array);
+
         template<int size>
         void SetFloatN(const Napi::CallbackInfo& info);
 
+        template<int size>
+        void SetFloatN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<const float> values);
+
         template<int size>
         void SetMatrixN(const Napi::CallbackInfo& info);
 
-        // Scratch vector used for data alignment.
-        std::vector<float> m_scratch{};
+        template<int size>
+        void SetMatrixN(EncoderState& state, const UniformInfo& uniformInfo, gsl::span<const float> matrix);
+
+        std::vector<void*> m_commandObjects{};
         
         Napi::FunctionReference m_requestAnimationFrameCallback{};
-
-        // webgl/opengl draw call parameters allow to set first index and number of indices used for that call
-        // but with bgfx, those parameters must be set when binding the index buffer
-        // at the time of webgl binding, we don't know those values yet
-        // so a pointer to the to-bind buffer is kept and the buffer is bound to bgfx at the time of the drawcall
-        const IndexBufferData* m_currentBoundIndexBuffer{};
     };
 }
@@ -1,5 +1,6 @@
 #include <Babylon/Plugins/NativeEngine.h>
 #include "NativeEngine.h"
+#include "ShaderCache.h"
 
 namespace Babylon::Plugins::NativeEngine
 {
@@ -7,4 +8,20 @@ namespace Babylon::Plugins::NativeEngine
     {
         Babylon::NativeEngine::Initialize(env, renderAutomatically);
     }
+
+    void EnableShaderCache(std::string directory)
+    {
+        ShaderCache::Enable(std::move(directory));
+    }
+
+    void DisableShaderCache()
+    {
+        ShaderCache::Disable();
+    }
+
+    ShaderCacheStatistics GetShaderCacheStatistics()
+    {
+        const auto statistics = ShaderCache::GetStatistics();
+        return {statistics.Hits, statistics.Misses};
+    }
 }
@@ -0,0 +1,136 @@
+#include "RenderStateCache.h"
+
+#include <atomic>
+
+namespace Babylon
+{
+    namespace
+    {
+        // bgfx::discard and bgfx::touch reset the state of the single API thread encoder, so a global epoch is
+        // enough to tell every cache of that encoder that its shadow copy is stale. Caches of other encoders
+        // merely issue their state again.
+        std::atomic<uint32_t> s_discardEpoch{};
+
+        // Bumped by every update of a dynamic buffer, which invalidates the dynamic bindings of every cache.
+        std::atomic<uint32_t> s_dynamicBufferEpoch{};
+    }
+
+    void RenderStateCache::NotifyDiscarded()
+    {
+        ++s_discardEpoch;
+    }
+
+    void RenderStateCache::NotifyDynamicBufferUpdated()
+    {
+        ++s_dynamicBufferEpoch;
+    }
+
+    void RenderStateCache::Reset()
+    {
+        m_state = {};
+        m_vertexBuffers = {};
+        m_indexBuffer = {};
+        m_textures = {};
+        m_lastSubmit = {};
+        m_discardEpoch = s_discardEpoch;
+    }
+
+    void RenderStateCache::SetEncoder(bgfx::Encoder* encoder)
+    {
+        m_encoder = encoder;
+        Reset();
+    }
+
+    bgfx::Encoder& RenderStateCache::GetEncoder() const
+    {
+        // On the API thread bgfx::begin returns the encoder that the bgfx free functions record into.
+        return m_encoder != nullptr ? *m_encoder : *bgfx::begin();
+    }
+
+    void RenderStateCache::SetState(uint64_t state)
+    {
+        const Buffer value{false, 0, static_cast<uint32_t>(state), static_cast<uint32_t>(state >> 32)};
+        if (Update(&m_state, value))
+        {
+            GetEncoder().setState(state);
+        }
+    }
+
+    void RenderStateCache::DisableVertexBuffers(uint8_t firstStream)
+    {
+        Synchronize();
+        for (uint8_t stream = firstStream; stream < m_vertexBuffers.size(); ++stream)
+        {
+            auto& binding = m_vertexBuffers[stream];
+            if (binding.Valid && binding.Value.Handle != bgfx::kInvalidHandle)
+            {
+                GetEncoder().setVertexBuffer(stream, bgfx::VertexBufferHandle{bgfx::kInvalidHandle});
+                binding = {true, Buffer{}};
+                ++m_statistics.Issued;
+            }
+        }
+    }
+
+    void RenderStateCache::DiscardIndexBuffer()
+    {
+        Synchronize();
+        GetEncoder().discard(BGFX_DISCARD_INDEX_BUFFER);
+        m_indexBuffer = {};
+    }
+
+    void RenderStateCache::SetTexture(uint8_t stage, bgfx::UniformHandle sampler, bgfx::TextureHandle texture, uint32_t flags)
+    {
+        const Buffer value{false, texture.idx, sampler.idx, flags};
+        if (Update(stage < m_textures.size() ? &m_textures[stage] : nullptr, value))
+        {
+            GetEncoder().setTexture(stage, sampler, texture, flags);
+        }
+    }
+
+    bool RenderStateCache::BeginSubmit(const void* program, bgfx::ViewId viewId, uint64_t state)
+    {
+        Synchronize();
+        const bool changed = m_lastSubmit.Program != program || m_lastSubmit.ViewId != viewId || m_lastSubmit.State != state;
+        m_lastSubmit = {program, viewId, state};
+        return changed;
+    }
+
+    void RenderStateCache::RecordUniforms(uint32_t issued, uint32_t elided)
+    {
+        m_statistics.Issued += issued;
+        m_statistics.Elided += elided;
+    }
+
+    RenderStateCache::Statistics RenderStateCache::GetStatistics() const
+    {
+        return m_statistics;
+    }
+
+    bool RenderStateCache::Update(Binding* binding, const Buffer& value)
+    {
+        Synchronize();
+
+        const uint32_t dynamicBufferEpoch = s_dynamicBufferEpoch;
+        if (binding != nullptr && binding->Valid && binding->Value == value && (!value.Dynamic || binding->DynamicBufferEpoch == dynamicBufferEpoch))
+        {
+            ++m_statistics.Elided;
+            return false;
+        }
+
+        if (binding != nullptr)
+        {
+            *binding = {true, value, dynamicBufferEpoch};
+        }
+
+        ++m_statistics.Issued;
+        return true;
+    }
+
+    void RenderStateCache::Synchronize()
+    {
+        if (m_discardEpoch != s_discardEpoch)
+        {
+            Reset();
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <array>
+#include <type_traits>
+
+namespace Babylon
+{
+    /// Shadow copy of the bgfx encoder state set by the NativeEngine. bgfx keeps the render state, vertex
+    /// streams, index buffer and texture bindings from one submit to the next, so a call that would set a
+    /// value that is already in effect is skipped and counted as elided. Each cache shadows one encoder.
+    class RenderStateCache final
+    {
+    public:
+        struct Statistics
+        {
+            uint64_t Issued{};
+            uint64_t Elided{};
+        };
+
+        // Must be called whenever the encoder state is reset outside of the cache (bgfx::discard, bgfx::touch).
+        static void NotifyDiscarded();
+
+        // Must be called whenever a dynamic vertex or index buffer is updated. bgfx resolves the memory of a
+        // dynamic buffer when it is bound, and an update may move it, so every cached binding of a dynamic
+        // buffer must be issued again.
+        static void NotifyDynamicBufferUpdated();
+
+        // Forgets all shadowed state, e.g. at the start of a frame.
+        void Reset();
+
+        // Records into the given encoder from now on. Without one, the cache records into the encoder of the
+        // bgfx API thread, which must then be the calling thread.
+        void SetEncoder(bgfx::Encoder* encoder);
+        bgfx::Encoder& GetEncoder() const;
+
+        void SetState(uint64_t state);
+
+        template<typename HandleT>
+        void SetVertexBuffer(uint8_t stream, HandleT handle, uint32_t startVertex, bgfx::VertexLayoutHandle layout)
+        {
+            const Buffer buffer{std::is_same_v<HandleT, bgfx::DynamicVertexBufferHandle>, handle.idx, startVertex, layout.idx};
+            if (!Update(stream < m_vertexBuffers.size() ? &m_vertexBuffers[stream] : nullptr, buffer))
+            {
+                return;
+            }
+
+            GetEncoder().setVertexBuffer(stream, handle, startVertex, UINT32_MAX, layout);
+        }
+
+        // Unbinds the vertex streams from firstStream onwards that are still bound by earlier draws.
+        void DisableVertexBuffers(uint8_t firstStream);
+
+        template<typename HandleT>
+        void SetIndexBuffer(HandleT handle, uint32_t firstIndex, uint32_t numIndices)
+        {
+            const Buffer buffer{std::is_same_v<HandleT, bgfx::DynamicIndexBufferHandle>, handle.idx, firstIndex, numIndices};
+            if (!Update(&m_indexBuffer, buffer))
+            {
+                return;
+            }
+
+            GetEncoder().setIndexBuffer(handle, firstIndex, numIndices);
+        }
+
+        void DiscardIndexBuffer();
+
+        void SetTexture(uint8_t stage, bgfx::UniformHandle sampler, bgfx::TextureHandle texture, uint32_t flags);
+
+        // Calls the callback with every texture that the next submit samples.
+        template<typename CallbackT>
+        void ForEachTexture(CallbackT&& callback)
+        {
+            Synchronize();
+            for (const auto& binding : m_textures)
+            {
+                if (binding.Valid && binding.Value.Handle != bgfx::kInvalidHandle)
+                {
+                    callback(bgfx::TextureHandle{binding.Value.Handle});
+                }
+            }
+        }
+
+        // bgfx sorts draws within a view by state and program but keeps submission order among equal keys, so
+        // a submit that immediately follows one with the same view, state and program only needs to upload the
+        // uniforms that changed in between. Returns true if all uniforms must be uploaded.
+        bool BeginSubmit(const void* program, bgfx::ViewId viewId, uint64_t state);
+        void RecordUniforms(uint32_t issued, uint32_t elided);
+
+        Statistics GetStatistics() const;
+
+    private:
+        // Generic binding record: a handle tagged with whether it is dynamic, plus two values whose meaning
+        // depends on the binding (start vertex and layout, first index and count, or sampler and flags).
+        struct Buffer
+        {
+            bool Dynamic{};
+            uint16_t Handle{bgfx::kInvalidHandle};
+            uint32_t First{};
+            uint32_t Second{};
+
+            bool operator==(const Buffer& other) const
+            {
+                return Dynamic == other.Dynamic && Handle == other.Handle && First == other.First && Second == other.Second;
+            }
+        };
+
+        struct Binding
+        {
+            bool Valid{false};
+            Buffer Value{};
+            // The dynamic buffer epoch at the time a dynamic buffer was bound.
+            uint32_t DynamicBufferEpoch{};
+        };
+
+        // Returns true if the value differs from the shadowed one and must be issued to bgfx. A null binding
+        // means the slot is not tracked and the value is always issued.
+        bool Update(Binding* binding, const Buffer& value);
+        void Synchronize();
+
+        bgfx::Encoder* m_encoder{nullptr};
+        uint32_t m_discardEpoch{};
+
+        Binding m_state{};
+        std::array<Binding, 16> m_vertexBuffers{};
+        Binding m_indexBuffer{};
+        std::array<Binding, 16> m_textures{};
+
+        struct
+        {
+            const void* Program{nullptr};
+            bgfx::ViewId ViewId{};
+            uint64_t State{};
+        } m_lastSubmit{};
+
+        Statistics m_statistics{};
+    };
+}
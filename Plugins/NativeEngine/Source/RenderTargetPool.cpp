@@ -0,0 +1,149 @@
+#include "RenderTargetPool.h"
+
+#include <bimg/bimg.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace Babylon
+{
+    RenderTargetPool::RenderTargetPool()
+        : m_state{std::make_shared<State>()}
+    {
+    }
+
+    RenderTargetPool::Lease RenderTargetPool::Acquire(const Description& description)
+    {
+        auto& state = *m_state;
+        ++state.Requests;
+        // A pool that is used again after being cleared takes released frame buffers back.
+        state.Cleared = false;
+
+        bgfx::FrameBufferHandle frameBuffer{bgfx::kInvalidHandle};
+        // The most recently released frame buffer is the most likely to still be in the GPU caches.
+        auto it = std::find_if(state.PooledTargets.rbegin(), state.PooledTargets.rend(), [&description](const PooledTarget& target) {
+            return target.TargetDescription == description;
+        });
+        if (it != state.PooledTargets.rend())
+        {
+            frameBuffer = it->FrameBuffer;
+            state.PooledTargets.erase(std::next(it).base());
+            ++state.Hits;
+        }
+        else
+        {
+            frameBuffer = Create(description);
+        }
+
+        ++state.ActiveTargets;
+        state.ActiveBytes += GetByteCount(description);
+
+        return {new bgfx::FrameBufferHandle{frameBuffer}, [weakState = std::weak_ptr<State>{m_state}, description](const bgfx::FrameBufferHandle* handle) {
+                    Release(weakState, description, *handle);
+                    delete handle;
+                }};
+    }
+
+    void RenderTargetPool::Trim()
+    {
+        auto& state = *m_state;
+        ++state.Frame;
+
+        state.PooledTargets.erase(std::remove_if(state.PooledTargets.begin(), state.PooledTargets.end(), [&state](const PooledTarget& target) {
+            if (state.Frame - target.ReleaseFrame <= MAX_IDLE_FRAMES)
+            {
+                return false;
+            }
+
+            bgfx::destroy(target.FrameBuffer);
+            return true;
+        }),
+            state.PooledTargets.end());
+    }
+
+    void RenderTargetPool::Clear()
+    {
+        for (const auto& target : m_state->PooledTargets)
+        {
+            bgfx::destroy(target.FrameBuffer);
+        }
+        m_state->PooledTargets.clear();
+        m_state->Cleared = true;
+    }
+
+    RenderTargetPool::Statistics RenderTargetPool::GetStatistics() const
+    {
+        const auto& state = *m_state;
+
+        uint64_t pooledBytes{0};
+        for (const auto& target : state.PooledTargets)
+        {
+            pooledBytes += GetByteCount(target.TargetDescription);
+        }
+
+        return {state.Requests, state.Hits, state.ActiveTargets, state.PooledTargets.size(), state.ActiveBytes, pooledBytes};
+    }
+
+    bgfx::FrameBufferHandle RenderTargetPool::Create(const Description& description)
+    {
+        if (description.DepthStencilBuffer == DepthStencil::None)
+        {
+            return bgfx::createFrameBuffer(description.Width, description.Height, description.Format, BGFX_TEXTURE_RT);
+        }
+
+        const auto depthStencilFormat = description.DepthStencilBuffer == DepthStencil::DepthStencil ? bgfx::TextureFormat::D24S8 : bgfx::TextureFormat::D32;
+
+        assert(bgfx::isTextureValid(0, false, 1, description.Format, BGFX_TEXTURE_RT));
+        assert(bgfx::isTextureValid(0, false, 1, depthStencilFormat, BGFX_TEXTURE_RT));
+
+        std::array<bgfx::TextureHandle, 2> textures{
+            bgfx::createTexture2D(description.Width, description.Height, description.HasMips, 1, description.Format, BGFX_TEXTURE_RT),
+            bgfx::createTexture2D(description.Width, description.Height, description.HasMips, 1, depthStencilFormat, BGFX_TEXTURE_RT)};
+        std::array<bgfx::Attachment, textures.size()> attachments{};
+        for (size_t idx = 0; idx < attachments.size(); ++idx)
+        {
+            attachments[idx].init(textures[idx]);
+        }
+        return bgfx::createFrameBuffer(static_cast<uint8_t>(attachments.size()), attachments.data(), true);
+    }
+
+    uint64_t RenderTargetPool::GetByteCount(const Description& description)
+    {
+        static_assert(static_cast<bimg::TextureFormat::Enum>(bgfx::TextureFormat::Count) == bimg::TextureFormat::Count);
+
+        uint64_t bitsPerPixel{bimg::getBitsPerPixel(static_cast<bimg::TextureFormat::Enum>(description.Format))};
+        if (description.DepthStencilBuffer != DepthStencil::None)
+        {
+            // Both D32 and D24S8 take 32 bits per pixel.
+            bitsPerPixel += 32;
+        }
+
+        uint64_t byteCount{uint64_t{description.Width} * description.Height * bitsPerPixel / 8};
+        if (description.HasMips)
+        {
+            // A full mip chain adds a third to the size of the top level.
+            byteCount += byteCount / 3;
+        }
+        return byteCount;
+    }
+
+    void RenderTargetPool::Release(const std::weak_ptr<State>& weakState, const Description& description, bgfx::FrameBufferHandle frameBuffer)
+    {
+        const auto state = weakState.lock();
+        if (state == nullptr)
+        {
+            return;
+        }
+
+        --state->ActiveTargets;
+        state->ActiveBytes -= GetByteCount(description);
+        if (state->Cleared)
+        {
+            bgfx::destroy(frameBuffer);
+            return;
+        }
+
+        state->PooledTargets.push_back({description, frameBuffer, state->Frame});
+    }
+}
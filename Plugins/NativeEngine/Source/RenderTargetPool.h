@@ -0,0 +1,101 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <memory>
+#include <vector>
+
+namespace Babylon
+{
+    /// Recycles the bgfx frame buffers behind render targets. A render target that is deleted goes back to
+    /// the pool and is handed out again to the next render target created with the same description, even
+    /// within the same frame: views are rendered in bind order, and a view is never moved after a later one
+    /// that renders to or samples the same textures, so every view that used the deleted target has been
+    /// rendered before the new one is first drawn to.
+    /// Frame buffers that stay unused for a while are destroyed.
+    class RenderTargetPool final
+    {
+    public:
+        enum class DepthStencil
+        {
+            None,
+            Depth,
+            DepthStencil,
+        };
+
+        struct Description
+        {
+            uint16_t Width{};
+            uint16_t Height{};
+            bgfx::TextureFormat::Enum Format{};
+            DepthStencil DepthStencilBuffer{};
+            bool HasMips{};
+
+            bool operator==(const Description& other) const
+            {
+                return Width == other.Width && Height == other.Height && Format == other.Format && DepthStencilBuffer == other.DepthStencilBuffer && HasMips == other.HasMips;
+            }
+        };
+
+        // Shared by the frame buffer and texture objects of a render target. The frame buffer goes back to
+        // the pool once both have been deleted, so that its texture is never handed out while still in use.
+        // A lease released after the pool has been cleared destroys its frame buffer instead, and one released
+        // after the pool has been destroyed leaves it to bgfx::shutdown.
+        using Lease = std::shared_ptr<const bgfx::FrameBufferHandle>;
+
+        struct Statistics
+        {
+            uint64_t Requests{};
+            uint64_t Hits{};
+            size_t ActiveTargets{};
+            size_t PooledTargets{};
+            uint64_t ActiveBytes{};
+            uint64_t PooledBytes{};
+        };
+
+        // Pooled frame buffers that have not been reused for this many frames are destroyed.
+        static constexpr uint32_t MAX_IDLE_FRAMES{60};
+
+        // Frame buffers still pooled when the pool is destroyed are left to bgfx::shutdown.
+        RenderTargetPool();
+        RenderTargetPool(const RenderTargetPool&) = delete;
+        RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+        Lease Acquire(const Description& description);
+
+        // Starts a new frame, destroying the frame buffers that have been idle for too long.
+        void Trim();
+
+        // Destroys every pooled frame buffer. Frame buffers still leased are destroyed when released.
+        void Clear();
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct PooledTarget
+        {
+            Description TargetDescription{};
+            bgfx::FrameBufferHandle FrameBuffer{bgfx::kInvalidHandle};
+            uint32_t ReleaseFrame{};
+        };
+
+        // Leases refer to the state of the pool rather than to the pool itself, since they may outlive it.
+        struct State
+        {
+            std::vector<PooledTarget> PooledTargets{};
+            uint32_t Frame{0};
+            bool Cleared{false};
+
+            uint64_t Requests{0};
+            uint64_t Hits{0};
+            size_t ActiveTargets{0};
+            uint64_t ActiveBytes{0};
+        };
+
+        static bgfx::FrameBufferHandle Create(const Description& description);
+        static uint64_t GetByteCount(const Description& description);
+        static void Release(const std::weak_ptr<State>& weakState, const Description& description, bgfx::FrameBufferHandle frameBuffer);
+
+        std::shared_ptr<State> m_state;
+    };
+}
@@ -0,0 +1,340 @@
+#include "ShaderCache.h"
+#include "ShaderCompilerCommon.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+
+namespace Babylon
+{
+    namespace
+    {
+        // Bump this whenever the output of the ShaderCompiler or the layout of a cache entry changes
+        // so that stale entries written by older builds are ignored.
+        constexpr uint32_t SHADER_CACHE_VERSION = 2;
+        constexpr uint32_t SHADER_CACHE_MAGIC = 'B' | ('N' << 8) | ('S' << 16) | ('C' << 24);
+
+#if APID3D
+        constexpr std::string_view TARGET_API{"D3D"};
+#elif APIMetal
+        constexpr std::string_view TARGET_API{"Metal"};
+#elif APIOpenGL
+        constexpr std::string_view TARGET_API{"OpenGL"};
+#else
+        constexpr std::string_view TARGET_API{"Unknown"};
+#endif
+
+        struct
+        {
+            std::mutex Mutex{};
+            std::string Directory{};
+            std::atomic<uint32_t> Hits{};
+            std::atomic<uint32_t> Misses{};
+            // Numbers the temporary files written by this process.
+            std::atomic<uint64_t> NextTemporaryId{};
+        } s_state{};
+
+        class Fnv1a64 final
+        {
+        public:
+            void Add(const void* data, size_t size)
+            {
+                const auto* bytes = static_cast<const uint8_t*>(data);
+                for (size_t idx = 0; idx < size; ++idx)
+                {
+                    m_hash ^= bytes[idx];
+                    m_hash *= 0x100000001b3ULL;
+                }
+            }
+
+            void Add(std::string_view string)
+            {
+                const auto length = static_cast<uint32_t>(string.size());
+                Add(&length, sizeof(length));
+                Add(string.data(), string.size());
+            }
+
+            uint64_t Value() const
+            {
+                return m_hash;
+            }
+
+        private:
+            uint64_t m_hash{0xcbf29ce484222325ULL};
+        };
+
+        std::string GetEntryPath(const std::string& directory, std::string_view vertexSource, std::string_view fragmentSource)
+        {
+            Fnv1a64 hash{};
+            hash.Add(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+            hash.Add(TARGET_API);
+            hash.Add(vertexSource);
+            hash.Add(fragmentSource);
+
+            char fileName[32];
+            std::snprintf(fileName, sizeof(fileName), "%016llx.bin", static_cast<unsigned long long>(hash.Value()));
+
+            std::string path{directory};
+            if (!path.empty() && path.back() != '/' && path.back() != '\\')
+            {
+                path += '/';
+            }
+            path += fileName;
+            return path;
+        }
+
+        void AppendString(std::vector<uint8_t>& bytes, std::string_view string)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(string.size()));
+            bytes.insert(bytes.end(), string.begin(), string.end());
+        }
+
+        void AppendBlob(std::vector<uint8_t>& bytes, const std::vector<uint8_t>& blob)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(blob.size()));
+            bytes.insert(bytes.end(), blob.begin(), blob.end());
+        }
+
+        template<typename ValueT>
+        void AppendMap(std::vector<uint8_t>& bytes, const std::unordered_map<std::string, ValueT>& map)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(map.size()));
+            for (const auto& [name, value] : map)
+            {
+                AppendString(bytes, name);
+                ShaderCompilerCommon::AppendBytes(bytes, value);
+            }
+        }
+
+        std::vector<uint8_t> Serialize(std::string_view vertexSource, std::string_view fragmentSource, const ShaderCompiler::BgfxShaderInfo& shaderInfo)
+        {
+            std::vector<uint8_t> bytes{};
+            ShaderCompilerCommon::AppendBytes(bytes, SHADER_CACHE_MAGIC);
+            ShaderCompilerCommon::AppendBytes(bytes, SHADER_CACHE_VERSION);
+
+            // The sources are stored alongside the compiled shaders so that hash collisions are detected on load.
+            AppendString(bytes, vertexSource);
+            AppendString(bytes, fragmentSource);
+
+            AppendBlob(bytes, shaderInfo.VertexBytes);
+            AppendMap(bytes, shaderInfo.VertexAttributeLocations);
+            AppendMap(bytes, shaderInfo.VertexUniformStages);
+
+            AppendBlob(bytes, shaderInfo.FragmentBytes);
+            AppendMap(bytes, shaderInfo.FragmentUniformStages);
+
+            return bytes;
+        }
+
+        class Reader final
+        {
+        public:
+            Reader(const std::vector<uint8_t>& bytes)
+                : m_bytes{bytes}
+            {
+            }
+
+            template<typename T>
+            T Read()
+            {
+                T value{};
+                Read(&value, sizeof(T));
+                return value;
+            }
+
+            std::string_view ReadString()
+            {
+                const auto length = Read<uint32_t>();
+                Check(length);
+                std::string_view string{reinterpret_cast<const char*>(m_bytes.data() + m_offset), length};
+                m_offset += length;
+                return string;
+            }
+
+            std::vector<uint8_t> ReadBlob()
+            {
+                const auto length = Read<uint32_t>();
+                Check(length);
+                const auto begin = m_bytes.begin() + static_cast<std::ptrdiff_t>(m_offset);
+                std::vector<uint8_t> blob{begin, begin + static_cast<std::ptrdiff_t>(length)};
+                m_offset += length;
+                return blob;
+            }
+
+            template<typename ValueT>
+            std::unordered_map<std::string, ValueT> ReadMap()
+            {
+                std::unordered_map<std::string, ValueT> map{};
+                const auto count = Read<uint32_t>();
+                for (uint32_t idx = 0; idx < count; ++idx)
+                {
+                    std::string name{ReadString()};
+                    map[std::move(name)] = Read<ValueT>();
+                }
+                return map;
+            }
+
+            bool AtEnd() const
+            {
+                return m_offset == m_bytes.size();
+            }
+
+        private:
+            void Read(void* data, size_t size)
+            {
+                Check(size);
+                std::memcpy(data, m_bytes.data() + m_offset, size);
+                m_offset += size;
+            }
+
+            void Check(size_t size) const
+            {
+                if (m_bytes.size() - m_offset < size)
+                {
+                    throw std::runtime_error{"Truncated shader cache entry."};
+                }
+            }
+
+            const std::vector<uint8_t>& m_bytes;
+            size_t m_offset{};
+        };
+
+        std::optional<ShaderCompiler::BgfxShaderInfo> Deserialize(const std::vector<uint8_t>& bytes, std::string_view vertexSource, std::string_view fragmentSource)
+        {
+            Reader reader{bytes};
+            if (reader.Read<uint32_t>() != SHADER_CACHE_MAGIC ||
+                reader.Read<uint32_t>() != SHADER_CACHE_VERSION ||
+                reader.ReadString() != vertexSource ||
+                reader.ReadString() != fragmentSource)
+            {
+                return {};
+            }
+
+            ShaderCompiler::BgfxShaderInfo shaderInfo{};
+            shaderInfo.VertexBytes = reader.ReadBlob();
+            shaderInfo.VertexAttributeLocations = reader.ReadMap<uint32_t>();
+            shaderInfo.VertexUniformStages = reader.ReadMap<uint8_t>();
+            shaderInfo.FragmentBytes = reader.ReadBlob();
+            shaderInfo.FragmentUniformStages = reader.ReadMap<uint8_t>();
+
+            if (!reader.AtEnd())
+            {
+                return {};
+            }
+
+            return shaderInfo;
+        }
+
+        std::optional<ShaderCompiler::BgfxShaderInfo> Load(const std::string& path, std::string_view vertexSource, std::string_view fragmentSource)
+        {
+            std::ifstream file{path, std::ios::binary};
+            if (!file)
+            {
+                return {};
+            }
+
+            std::vector<uint8_t> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+            try
+            {
+                return Deserialize(bytes, vertexSource, fragmentSource);
+            }
+            catch (const std::exception&)
+            {
+                // A corrupt entry is treated as a miss and overwritten by the next store.
+                return {};
+            }
+        }
+
+        // Returns a temporary path next to the given one that no other writer uses, whether it is another
+        // thread of this process or another process sharing the cache directory.
+        std::string GetTemporaryPath(const std::string& path)
+        {
+            static const uint64_t processId{(static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()};
+
+            char suffix[48]{};
+            std::snprintf(suffix, sizeof(suffix), ".%016llx.%llu.tmp", static_cast<unsigned long long>(processId), static_cast<unsigned long long>(s_state.NextTemporaryId++));
+            return path + suffix;
+        }
+
+        void Store(const std::string& path, const std::vector<uint8_t>& bytes)
+        {
+            // Write to a temporary file first so that concurrent readers never observe a partial entry.
+            const std::string temporaryPath{GetTemporaryPath(path)};
+            {
+                std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+                if (!file)
+                {
+                    return;
+                }
+
+                file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                if (!file)
+                {
+                    file.close();
+                    std::remove(temporaryPath.data());
+                    return;
+                }
+            }
+
+            // Renaming replaces an existing entry atomically where the file system allows it. Elsewhere (e.g.
+            // on Windows) the existing entry is removed first, and readers briefly see a miss.
+            if (std::rename(temporaryPath.data(), path.data()) != 0)
+            {
+                std::remove(path.data());
+                if (std::rename(temporaryPath.data(), path.data()) != 0)
+                {
+                    std::remove(temporaryPath.data());
+                }
+            }
+        }
+    }
+
+    void ShaderCache::Enable(std::string directory)
+    {
+        std::scoped_lock lock{s_state.Mutex};
+        s_state.Directory = std::move(directory);
+    }
+
+    void ShaderCache::Disable()
+    {
+        std::scoped_lock lock{s_state.Mutex};
+        s_state.Directory.clear();
+    }
+
+    ShaderCache::Statistics ShaderCache::GetStatistics()
+    {
+        return {s_state.Hits.load(), s_state.Misses.load()};
+    }
+
+    ShaderCompiler::BgfxShaderInfo ShaderCache::Compile(ShaderCompiler& compiler, std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        std::string directory{};
+        {
+            std::scoped_lock lock{s_state.Mutex};
+            directory = s_state.Directory;
+        }
+
+        if (directory.empty())
+        {
+            return compiler.Compile(vertexSource, fragmentSource);
+        }
+
+        const std::string path{GetEntryPath(directory, vertexSource, fragmentSource)};
+        if (auto shaderInfo = Load(path, vertexSource, fragmentSource))
+        {
+            ++s_state.Hits;
+            return std::move(shaderInfo.value());
+        }
+
+        ++s_state.Misses;
+        auto shaderInfo = compiler.Compile(vertexSource, fragmentSource);
+        Store(path, Serialize(vertexSource, fragmentSource, shaderInfo));
+        return shaderInfo;
+    }
+}
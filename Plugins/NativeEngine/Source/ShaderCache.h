@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+
+#include <string>
+#include <string_view>
+
+namespace Babylon
+{
+    /// This class persists the output of the ShaderCompiler to disk so that programs compiled during
+    /// a previous run of the application can be recreated without going through glslang and SPIRV-Cross.
+    /// Entries are content-addressed by the shader sources, the target graphics API and the cache version.
+    class ShaderCache final
+    {
+    public:
+        struct Statistics
+        {
+            uint32_t Hits{};
+            uint32_t Misses{};
+        };
+
+        static void Enable(std::string directory);
+        static void Disable();
+        static Statistics GetStatistics();
+
+        static ShaderCompiler::BgfxShaderInfo Compile(ShaderCompiler& compiler, std::string_view vertexSource, std::string_view fragmentSource);
+    };
+}
@@ -14,6 +14,7 @@ namespace Babylon
 {
     /// This class is responsible for compiling the GLSL shader from Babylon.js into
     /// bgfx shader bytes with information about the shader attributes and uniforms.
+    /// Compile does not touch bgfx and may be called concurrently from multiple threads.
     class ShaderCompiler final
     {
     public:
@@ -2,6 +2,8 @@
 #include "ShaderCompiler.h"
 #include <bx/bx.h>
 #include <bgfx/bgfx.h>
+#include <glslang/Public/ShaderLang.h>
+#include <mutex>
 
 #define BGFX_UNIFORM_FRAGMENTBIT UINT8_C(0x10) // Copy-pasta from bgfx_p.h
 #define BGFX_UNIFORM_SAMPLERBIT UINT8_C(0x20)  // Copy-pasta from bgfx_p.h
@@ -12,6 +14,35 @@ namespace bgfx
     uint16_t attribToId(Attrib::Enum _attr);
 }
 
+namespace Babylon
+{
+    namespace
+    {
+        // glslang keeps process-wide state (symbol tables, thread-local pool indices) which must be
+        // initialized once before any compile and torn down only after the last compiler is gone.
+        std::mutex s_glslangMutex{};
+        uint32_t s_glslangClients{0};
+    }
+
+    ShaderCompiler::ShaderCompiler()
+    {
+        std::scoped_lock lock{s_glslangMutex};
+        if (s_glslangClients++ == 0)
+        {
+            glslang::InitializeProcess();
+        }
+    }
+
+    ShaderCompiler::~ShaderCompiler()
+    {
+        std::scoped_lock lock{s_glslangMutex};
+        if (--s_glslangClients == 0)
+        {
+            glslang::FinalizeProcess();
+        }
+    }
+}
+
 namespace Babylon::ShaderCompilerCommon
 {
     void AppendUniformBuffer(std::vector<uint8_t>& bytes, const NonSamplerUniformsInfo& uniformBuffer, bool isFragment)
@@ -65,16 +65,6 @@ namespace Babylon
         }
     }
 
-    ShaderCompiler::ShaderCompiler()
-    {
-        glslang::InitializeProcess();
-    }
-
-    ShaderCompiler::~ShaderCompiler()
-    {
-        glslang::FinalizeProcess();
-    }
-
     ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource)
     {
         glslang::TProgram program;
@@ -0,0 +1,228 @@
+#include "ShaderCompilerPool.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+
+namespace Babylon
+{
+    ShaderCompilerPool::ShaderCompilerPool(size_t workerCount)
+    {
+        m_workers.reserve(workerCount);
+        for (size_t idx = 0; idx < workerCount; ++idx)
+        {
+            m_workers.emplace_back([this] { WorkerProcedure(); });
+        }
+    }
+
+    ShaderCompilerPool::~ShaderCompilerPool()
+    {
+        std::vector<std::shared_ptr<Job>> abandonedJobs{};
+        {
+            std::scoped_lock lock{m_mutex};
+            m_shutdown = true;
+            for (auto& [key, job] : m_queue)
+            {
+                abandonedJobs.push_back(std::move(job));
+            }
+            m_queue.clear();
+        }
+        m_jobQueued.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+
+        for (auto& job : abandonedJobs)
+        {
+            job->Completion.complete(arcana::make_unexpected(std::make_exception_ptr(std::runtime_error{"Shader compiler pool was destroyed."})));
+        }
+    }
+
+    size_t ShaderCompilerPool::DefaultWorkerCount()
+    {
+        // Leave a core for the JavaScript and render threads, and don't spin up more compilers than
+        // a typical level load can keep busy.
+        constexpr size_t MAX_WORKER_COUNT = 4;
+        const size_t hardwareConcurrency = std::thread::hardware_concurrency();
+        return std::clamp<size_t>(hardwareConcurrency > 1 ? hardwareConcurrency - 1 : 1, 1, MAX_WORKER_COUNT);
+    }
+
+    std::string ShaderCompilerPool::MakeKey(const std::string& vertexSource, const std::string& fragmentSource)
+    {
+        std::string key{};
+        key.reserve(vertexSource.size() + fragmentSource.size() + 1);
+        key.append(vertexSource);
+        key.push_back('\0');
+        key.append(fragmentSource);
+        return key;
+    }
+
+    arcana::task<ShaderCompiler::BgfxShaderInfo, std::exception_ptr> ShaderCompilerPool::CompileAsync(std::string vertexSource, std::string fragmentSource, Priority priority)
+    {
+        std::scoped_lock lock{m_mutex};
+
+        auto key = MakeKey(vertexSource, fragmentSource);
+        const auto it = m_jobs.find(key);
+        if (it != m_jobs.end())
+        {
+            auto& job = it->second;
+            job->JobPriority = std::max(job->JobPriority, priority);
+            return job->Completion.as_task();
+        }
+
+        auto job = std::make_shared<Job>();
+        job->VertexSource = std::move(vertexSource);
+        job->FragmentSource = std::move(fragmentSource);
+        job->JobPriority = priority;
+        job->Sequence = m_nextSequence++;
+
+        m_jobs.emplace(key, job);
+        m_queue.emplace_back(std::move(key), job);
+        m_jobQueued.notify_one();
+
+        return job->Completion.as_task();
+    }
+
+    ShaderCompiler::BgfxShaderInfo ShaderCompilerPool::Compile(std::string vertexSource, std::string fragmentSource)
+    {
+        std::unique_lock lock{m_mutex};
+
+        auto key = MakeKey(vertexSource, fragmentSource);
+        std::shared_ptr<Job> job{};
+
+        const auto it = m_jobs.find(key);
+        if (it != m_jobs.end())
+        {
+            job = it->second;
+            if (job->Started)
+            {
+                m_jobFinished.wait(lock, [&job] { return job->Finished; });
+                if (job->Error != nullptr)
+                {
+                    std::rethrow_exception(job->Error);
+                }
+                return *job->Result;
+            }
+
+            // The program is queued but no worker has picked it up yet, so compile it right away
+            // rather than making the caller wait behind other programs.
+            m_queue.erase(std::find_if(m_queue.begin(), m_queue.end(), [&job](const auto& entry) { return entry.second == job; }));
+        }
+        else
+        {
+            job = std::make_shared<Job>();
+            job->VertexSource = std::move(vertexSource);
+            job->FragmentSource = std::move(fragmentSource);
+            job->JobPriority = Priority::Frame;
+            job->Sequence = m_nextSequence++;
+            m_jobs.emplace(key, job);
+        }
+
+        job->Started = true;
+        ++m_inFlight;
+        lock.unlock();
+
+        Execute(m_compiler, key, job);
+
+        if (job->Error != nullptr)
+        {
+            std::rethrow_exception(job->Error);
+        }
+        return *job->Result;
+    }
+
+    ShaderCompilerPool::Statistics ShaderCompilerPool::GetStatistics() const
+    {
+        std::scoped_lock lock{m_mutex};
+        return {m_queue.size(), m_inFlight, m_latencyHistogram};
+    }
+
+    void ShaderCompilerPool::WorkerProcedure()
+    {
+        ShaderCompiler compiler{};
+
+        std::unique_lock lock{m_mutex};
+        while (true)
+        {
+            m_jobQueued.wait(lock, [this] { return m_shutdown || !m_queue.empty(); });
+            if (m_shutdown)
+            {
+                return;
+            }
+
+            auto [key, job] = PopNextJob();
+            job->Started = true;
+            ++m_inFlight;
+
+            lock.unlock();
+            Execute(compiler, key, job);
+            lock.lock();
+        }
+    }
+
+    std::pair<std::string, std::shared_ptr<ShaderCompilerPool::Job>> ShaderCompilerPool::PopNextJob()
+    {
+        // Programs needed by the current frame first, then in submission order.
+        const auto next = std::min_element(m_queue.begin(), m_queue.end(), [](const auto& left, const auto& right) {
+            if (left.second->JobPriority != right.second->JobPriority)
+            {
+                return left.second->JobPriority > right.second->JobPriority;
+            }
+            return left.second->Sequence < right.second->Sequence;
+        });
+
+        auto entry = std::move(*next);
+        m_queue.erase(next);
+        return entry;
+    }
+
+    void ShaderCompilerPool::Execute(ShaderCompiler& compiler, const std::string& key, const std::shared_ptr<Job>& job)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        std::shared_ptr<ShaderCompiler::BgfxShaderInfo> result{};
+        std::exception_ptr error{};
+        try
+        {
+            result = std::make_shared<ShaderCompiler::BgfxShaderInfo>(ShaderCache::Compile(compiler, job->VertexSource, job->FragmentSource));
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::scoped_lock lock{m_mutex};
+            RecordLatency(std::chrono::steady_clock::now() - start);
+            job->Finished = true;
+            job->Result = result;
+            job->Error = error;
+            --m_inFlight;
+            m_jobs.erase(key);
+        }
+        m_jobFinished.notify_all();
+
+        if (error != nullptr)
+        {
+            job->Completion.complete(arcana::make_unexpected(error));
+        }
+        else
+        {
+            job->Completion.complete(*result);
+        }
+    }
+
+    void ShaderCompilerPool::RecordLatency(std::chrono::steady_clock::duration duration)
+    {
+        const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+
+        size_t bucket = 0;
+        while (bucket < LATENCY_BUCKET_COUNT - 1 && milliseconds >= (int64_t{1} << bucket))
+        {
+            ++bucket;
+        }
+
+        ++m_latencyHistogram[bucket];
+    }
+}
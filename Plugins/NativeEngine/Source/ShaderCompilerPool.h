@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+
+#include <arcana/threading/task.h>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Babylon
+{
+    /// A bounded set of worker threads, each owning its own ShaderCompiler, which translate programs
+    /// in parallel. Identical (vertex, fragment) pairs that are already queued or compiling are shared
+    /// rather than compiled twice, and programs that are needed to draw the current frame can jump
+    /// ahead of speculative background compiles.
+    class ShaderCompilerPool final
+    {
+    public:
+        enum class Priority
+        {
+            Background,
+            Frame,
+        };
+
+        // Bucket N counts compiles that took less than 2^N milliseconds; the last bucket counts the rest.
+        static constexpr size_t LATENCY_BUCKET_COUNT = 12;
+
+        struct Statistics
+        {
+            size_t QueueDepth{};
+            size_t InFlight{};
+            std::array<uint32_t, LATENCY_BUCKET_COUNT> LatencyHistogram{};
+        };
+
+        explicit ShaderCompilerPool(size_t workerCount = DefaultWorkerCount());
+        ~ShaderCompilerPool();
+
+        ShaderCompilerPool(const ShaderCompilerPool&) = delete;
+        ShaderCompilerPool& operator=(const ShaderCompilerPool&) = delete;
+
+        arcana::task<ShaderCompiler::BgfxShaderInfo, std::exception_ptr> CompileAsync(std::string vertexSource, std::string fragmentSource, Priority priority);
+
+        // Blocks until the program is compiled. If a worker is already compiling the same program its
+        // result is reused; otherwise the program is compiled on the calling thread.
+        ShaderCompiler::BgfxShaderInfo Compile(std::string vertexSource, std::string fragmentSource);
+
+        Statistics GetStatistics() const;
+
+        static size_t DefaultWorkerCount();
+
+    private:
+        struct Job
+        {
+            std::string VertexSource{};
+            std::string FragmentSource{};
+            Priority JobPriority{};
+            uint64_t Sequence{};
+            bool Started{};
+            bool Finished{};
+            std::shared_ptr<ShaderCompiler::BgfxShaderInfo> Result{};
+            std::exception_ptr Error{};
+            arcana::task_completion_source<ShaderCompiler::BgfxShaderInfo, std::exception_ptr> Completion{};
+        };
+
+        static std::string MakeKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+        void WorkerProcedure();
+        void Execute(ShaderCompiler& compiler, const std::string& key, const std::shared_ptr<Job>& job);
+        // Must be called with m_mutex held and a non-empty queue.
+        std::pair<std::string, std::shared_ptr<Job>> PopNextJob();
+        void RecordLatency(std::chrono::steady_clock::duration duration);
+
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_jobQueued{};
+        std::condition_variable m_jobFinished{};
+        bool m_shutdown{false};
+        uint64_t m_nextSequence{0};
+
+        std::unordered_map<std::string, std::shared_ptr<Job>> m_jobs{};
+        std::vector<std::pair<std::string, std::shared_ptr<Job>>> m_queue{};
+        size_t m_inFlight{0};
+        std::array<uint32_t, LATENCY_BUCKET_COUNT> m_latencyHistogram{};
+
+        // Used for compiles performed on the calling thread.
+        ShaderCompiler m_compiler{};
+        std::vector<std::thread> m_workers{};
+    };
+}
@@ -11,6 +11,10 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
 #include <stdexcept>
 #include <arcana/macros.h>
 
@@ -475,16 +479,44 @@ namespace Babylon::ShaderCompilerTraversers
             BX_STATIC_ASSERT(bgfx::Attrib::Count == BX_COUNTOF(s_attribName));
 #endif
 
+            // Per-instance attributes are read from the bgfx instance data buffer rather than from a vertex stream.
+            // bgfx binds the instance data to the i_data inputs by name on OpenGL and Metal and by semantic on
+            // DirectX, where i_data0 is TEXCOORD7, i_data1 is TEXCOORD6 and so on. The world matrix rows are the
+            // only per-instance attributes that are packed contiguously in a single Babylon.js instance buffer.
+            constexpr static std::array<std::pair<const char*, const char*>, 4> s_instanceAttributes{{
+                {"world0", "i_data0"},
+                {"world1", "i_data1"},
+                {"world2", "i_data2"},
+                {"world3", "i_data3"},
+            }};
+
+            static std::optional<unsigned int> GetInstanceDataIndex(const char* name)
+            {
+                for (unsigned int index = 0; index < s_instanceAttributes.size(); ++index)
+                {
+                    if (std::strcmp(name, s_instanceAttributes[index].first) == 0)
+                    {
+                        return index;
+                    }
+                }
+
+                return {};
+            }
+
             std::pair<unsigned int, const char*> GetVaryingLocationAndNewNameForName(const char* name)
             {
+                if (const auto instanceDataIndex = GetInstanceDataIndex(name))
+                {
+                    return {static_cast<unsigned int>(bgfx::Attrib::TexCoord7) - *instanceDataIndex, s_instanceAttributes[*instanceDataIndex].second};
+                }
+
 #if __APPLE__ || APIOpenGL
                 // For OpenGL and Metal platforms, we have an issue where we have a hard limit on the number shader attributes supported.
                 // To work around this issue, instead of mapping our attributes to the most similar bgfx::attribute, instead replace
                 // the first attribute encountered with the symbol bgfx uses for attribute 0 and increment for each subsequent attribute encountered.
                 // This will cause our shader to have nonsensical naming, but will allow us to efficiently "pack" the attributes.
-                UNUSED(name);
                 m_genericAttributesRunningCount++;
-                if (m_genericAttributesRunningCount >= static_cast<unsigned int>(bgfx::Attrib::Count))
+                if (m_genericAttributesRunningCount >= static_cast<unsigned int>(bgfx::Attrib::Count) - m_reservedInstanceLocations)
                     throw std::runtime_error("Cannot support more than 18 vertex attributes.");
 
                 return {static_cast<unsigned int>(m_genericAttributesRunningCount-1), s_attribName[static_cast<unsigned int>(m_genericAttributesRunningCount-1)]};
@@ -506,7 +538,7 @@ namespace Babylon::ShaderCompilerTraversers
                 IF_NAME_RETURN_ATTRIB("matricesWeights", bgfx::Attrib::Weight, "a_weight")
 #undef IF_NAME_RETURN_ATTRIB
                 const unsigned int attributeLocation = FIRST_GENERIC_ATTRIBUTE_LOCATION + m_genericAttributesRunningCount++;
-                if (attributeLocation >= static_cast<unsigned int>(bgfx::Attrib::Count))
+                if (attributeLocation >= static_cast<unsigned int>(bgfx::Attrib::Count) - m_reservedInstanceLocations)
                     throw std::runtime_error("Cannot support more than 18 vertex attributes.");
                 return {attributeLocation, name};
 #endif
@@ -525,6 +557,15 @@ namespace Babylon::ShaderCompilerTraversers
                 TPublicType publicType{};
                 publicType.qualifier.clearLayout();
 
+                // The highest locations are reserved for the instance data inputs used by this shader.
+                for (const auto& [name, symbol] : traverser.m_varyingNameToSymbol)
+                {
+                    if (const auto instanceDataIndex = GetInstanceDataIndex(name.c_str()))
+                    {
+                        traverser.m_reservedInstanceLocations = std::max(traverser.m_reservedInstanceLocations, *instanceDataIndex + 1);
+                    }
+                }
+
 #if !(__APPLE__ || APIOpenGL)
                 // UVs are effectively a special kind of generic attribute since they both use
                 // are implemented using texture coordinates, so we preprocess to pre-count the
@@ -572,6 +613,7 @@ namespace Babylon::ShaderCompilerTraversers
             const unsigned int FIRST_GENERIC_ATTRIBUTE_LOCATION{10};
 # endif
             unsigned int m_genericAttributesRunningCount{0};
+            unsigned int m_reservedInstanceLocations{0};
             std::map<std::string, TIntermSymbol*> m_varyingNameToSymbol{};
             std::vector<std::pair<TIntermSymbol*, TIntermNode*>> m_symbolsToParents{};
         };
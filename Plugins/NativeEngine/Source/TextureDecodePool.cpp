@@ -0,0 +1,296 @@
+#include "TextureDecodePool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Babylon
+{
+    // Reservations reach their pool through this link, which the pool cuts when it is destroyed.
+    struct TextureDecodePool::Reservation::Link
+    {
+        std::mutex Mutex{};
+        TextureDecodePool* Pool{};
+    };
+
+    TextureDecodePool::Reservation::Reservation(std::shared_ptr<Link> link, uint64_t byteCount)
+        : m_link{std::move(link)}
+        , m_byteCount{byteCount}
+    {
+    }
+
+    TextureDecodePool::Reservation::~Reservation()
+    {
+        if (m_link != nullptr)
+        {
+            std::scoped_lock lock{m_link->Mutex};
+            if (m_link->Pool != nullptr)
+            {
+                m_link->Pool->Release(m_byteCount);
+            }
+        }
+    }
+
+    TextureDecodePool::TextureDecodePool(size_t workerCount, uint64_t byteBudget)
+        : m_workerLimit{workerCount}
+        , m_byteBudget{byteBudget}
+        , m_link{std::make_shared<Reservation::Link>()}
+    {
+        m_link->Pool = this;
+        AddWorkers(workerCount);
+    }
+
+    TextureDecodePool::~TextureDecodePool()
+    {
+        {
+            std::scoped_lock lock{m_link->Mutex};
+            m_link->Pool = nullptr;
+        }
+
+        std::vector<std::shared_ptr<Batch>> abandonedBatches{};
+        {
+            std::scoped_lock lock{m_mutex};
+            m_shutdown = true;
+            for (auto& job : m_queue)
+            {
+                if (std::find(abandonedBatches.begin(), abandonedBatches.end(), job.JobBatch) == abandonedBatches.end())
+                {
+                    abandonedBatches.push_back(std::move(job.JobBatch));
+                }
+            }
+            m_queue.clear();
+        }
+        m_wake.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+
+        for (auto& batch : abandonedBatches)
+        {
+            for (auto* image : batch->Images)
+            {
+                if (image != nullptr)
+                {
+                    bimg::imageFree(image);
+                }
+            }
+
+            batch->Completion.complete(arcana::make_unexpected(std::make_exception_ptr(std::runtime_error{"Texture decode pool was destroyed."})));
+        }
+    }
+
+    size_t TextureDecodePool::DefaultWorkerCount()
+    {
+        // Leave a core for the JavaScript and render threads. Decoding is memory bound enough that more
+        // than a few workers mostly adds to the peak memory use.
+        constexpr size_t MAX_WORKER_COUNT = 4;
+        const size_t hardwareConcurrency = std::thread::hardware_concurrency();
+        return std::clamp<size_t>(hardwareConcurrency > 1 ? hardwareConcurrency - 1 : 1, 1, MAX_WORKER_COUNT);
+    }
+
+    arcana::task<std::vector<bimg::ImageContainer*>, std::exception_ptr> TextureDecodePool::DecodeAsync(std::vector<DecodeFunction> decoders, Priority priority)
+    {
+        auto batch = std::make_shared<Batch>();
+        batch->Images.resize(decoders.size());
+        batch->Remaining = decoders.size();
+
+        if (decoders.empty())
+        {
+            batch->Completion.complete(std::vector<bimg::ImageContainer*>{});
+            return batch->Completion.as_task();
+        }
+
+        {
+            std::scoped_lock lock{m_mutex};
+            for (size_t index = 0; index < decoders.size(); ++index)
+            {
+                m_queue.push_back({std::move(decoders[index]), batch, index, priority, m_nextSequence++});
+            }
+        }
+        m_wake.notify_all();
+
+        return batch->Completion.as_task();
+    }
+
+    TextureDecodePool::Reservation TextureDecodePool::Reserve(uint64_t byteCount)
+    {
+        return {m_link, byteCount};
+    }
+
+    void TextureDecodePool::Release(uint64_t byteCount)
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_pendingBytes -= std::min(byteCount, m_pendingBytes);
+        }
+        m_wake.notify_all();
+    }
+
+    void TextureDecodePool::Configure(size_t workerCount, uint64_t byteBudget)
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_workerLimit = std::max<size_t>(workerCount, 1);
+            m_byteBudget = byteBudget;
+            if (m_workers.size() < m_workerLimit)
+            {
+                AddWorkers(m_workerLimit - m_workers.size());
+            }
+        }
+        m_wake.notify_all();
+    }
+
+    TextureDecodePool::Statistics TextureDecodePool::GetStatistics() const
+    {
+        std::scoped_lock lock{m_mutex};
+
+        const double decodeSeconds = std::chrono::duration<double>(m_decodeTime).count();
+        const double throughput = decodeSeconds > 0 ? m_decodedBytes / decodeSeconds : 0;
+        return {m_queue.size(), m_inFlight, m_pendingBytes, m_byteBudget, m_decodedImages, m_decodedBytes, throughput};
+    }
+
+    void TextureDecodePool::AddWorkers(size_t workerCount)
+    {
+        const size_t firstIndex = m_workers.size();
+        for (size_t index = firstIndex; index < firstIndex + workerCount; ++index)
+        {
+            m_workers.emplace_back([this, index] { WorkerProcedure(index); });
+        }
+    }
+
+    void TextureDecodePool::WorkerProcedure(size_t workerIndex)
+    {
+        std::unique_lock lock{m_mutex};
+        while (true)
+        {
+            std::optional<size_t> next{};
+            m_wake.wait(lock, [this, workerIndex, &next] {
+                if (m_shutdown)
+                {
+                    return true;
+                }
+
+                // Workers beyond the configured limit stay parked until the limit is raised again.
+                next = workerIndex < m_workerLimit ? FindNextJob() : std::nullopt;
+                return next.has_value();
+            });
+
+            if (m_shutdown)
+            {
+                return;
+            }
+
+            Job job = std::move(m_queue[*next]);
+            m_queue.erase(m_queue.begin() + *next);
+            job.JobBatch->Admitted = true;
+            ++m_inFlight;
+
+            lock.unlock();
+            Execute(job);
+            lock.lock();
+        }
+    }
+
+    std::optional<size_t> TextureDecodePool::FindNextJob() const
+    {
+        // A worker that is already decoding may push the pending bytes past the budget, but no new group
+        // is started until enough images have been released. Nothing is pending when the budget is smaller
+        // than a single image, so that image is decoded regardless.
+        const bool withinBudget = m_pendingBytes == 0 || m_pendingBytes < m_byteBudget;
+
+        std::optional<size_t> next{};
+        for (size_t index = 0; index < m_queue.size(); ++index)
+        {
+            const auto& job = m_queue[index];
+            if (!withinBudget && !job.JobBatch->Admitted)
+            {
+                continue;
+            }
+
+            // Visible images first, then in submission order.
+            if (!next.has_value() || job.JobPriority > m_queue[*next].JobPriority ||
+                (job.JobPriority == m_queue[*next].JobPriority && job.Sequence < m_queue[*next].Sequence))
+            {
+                next = index;
+            }
+        }
+
+        return next;
+    }
+
+    void TextureDecodePool::Execute(Job& job)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        bimg::ImageContainer* image{};
+        std::exception_ptr error{};
+        try
+        {
+            image = job.Decode();
+            if (image == nullptr)
+            {
+                throw std::runtime_error{"Unable to decode image."};
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        auto& batch = *job.JobBatch;
+        bool finished{};
+        std::vector<bimg::ImageContainer*> discardedImages{};
+        {
+            std::scoped_lock lock{m_mutex};
+            m_decodeTime += std::chrono::steady_clock::now() - start;
+            --m_inFlight;
+
+            if (image != nullptr)
+            {
+                batch.Images[job.Index] = image;
+                m_pendingBytes += image->m_size;
+                ++m_decodedImages;
+                m_decodedBytes += image->m_size;
+            }
+
+            if (error != nullptr && batch.Error == nullptr)
+            {
+                batch.Error = error;
+            }
+
+            finished = --batch.Remaining == 0;
+            if (finished && batch.Error != nullptr)
+            {
+                for (auto* decodedImage : batch.Images)
+                {
+                    if (decodedImage != nullptr)
+                    {
+                        m_pendingBytes -= decodedImage->m_size;
+                        discardedImages.push_back(decodedImage);
+                    }
+                }
+            }
+        }
+        m_wake.notify_all();
+
+        if (!finished)
+        {
+            return;
+        }
+
+        for (auto* discardedImage : discardedImages)
+        {
+            bimg::imageFree(discardedImage);
+        }
+
+        if (batch.Error != nullptr)
+        {
+            batch.Completion.complete(arcana::make_unexpected(batch.Error));
+        }
+        else
+        {
+            batch.Completion.complete(std::move(batch.Images));
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <arcana/threading/task.h>
+
+#include <bimg/bimg.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace Babylon
+{
+    /// Decodes texture images on a bounded set of worker threads. Images that are needed for visible
+    /// content are decoded before background ones, and decoded images count against a byte budget until
+    /// they are released after being handed to bgfx: once the budget is used up, workers stop picking up
+    /// new requests until earlier images are released.
+    class TextureDecodePool final
+    {
+    public:
+        enum class Priority
+        {
+            Background,
+            Visible,
+        };
+
+        using DecodeFunction = std::function<bimg::ImageContainer*()>;
+
+        static constexpr uint64_t DEFAULT_BYTE_BUDGET{128 * 1024 * 1024};
+
+        struct Statistics
+        {
+            size_t QueueDepth{};
+            size_t InFlight{};
+            uint64_t PendingBytes{};
+            uint64_t ByteBudget{};
+            uint64_t DecodedImages{};
+            uint64_t DecodedBytes{};
+            // Decoded bytes per second of time spent decoding, summed over all workers.
+            double Throughput{};
+        };
+
+        explicit TextureDecodePool(size_t workerCount = DefaultWorkerCount(), uint64_t byteBudget = DEFAULT_BYTE_BUDGET);
+        ~TextureDecodePool();
+
+        TextureDecodePool(const TextureDecodePool&) = delete;
+        TextureDecodePool& operator=(const TextureDecodePool&) = delete;
+
+        // Decodes a group of images that are used together, such as the faces of a cube map. The decoders
+        // may run concurrently. Once a worker starts on a group the rest of it bypasses the byte budget,
+        // so a group never waits for memory that only its own completion would release. If any decoder
+        // fails, the images decoded so far are freed and the task fails with the first error.
+        arcana::task<std::vector<bimg::ImageContainer*>, std::exception_ptr> DecodeAsync(std::vector<DecodeFunction> decoders, Priority priority);
+
+        /// Holds the size of decoded images against the byte budget and returns it when destroyed, whether
+        /// or not the images made it to bgfx. A reservation may outlive its pool, in which case it returns
+        /// nothing.
+        class Reservation final
+        {
+        public:
+            Reservation() = default;
+            ~Reservation();
+
+            Reservation(Reservation&&) = default;
+            Reservation& operator=(Reservation&&) = delete;
+            Reservation(const Reservation&) = delete;
+            Reservation& operator=(const Reservation&) = delete;
+
+        private:
+            friend class TextureDecodePool;
+            struct Link;
+
+            Reservation(std::shared_ptr<Link> link, uint64_t byteCount);
+
+            std::shared_ptr<Link> m_link{};
+            uint64_t m_byteCount{};
+        };
+
+        // Takes over the size of the images of a completed decode, which stays charged to the byte budget
+        // for as long as the returned reservation lives.
+        Reservation Reserve(uint64_t byteCount);
+
+        void Configure(size_t workerCount, uint64_t byteBudget);
+
+        Statistics GetStatistics() const;
+
+        static size_t DefaultWorkerCount();
+
+    private:
+        struct Batch
+        {
+            std::vector<bimg::ImageContainer*> Images{};
+            size_t Remaining{};
+            bool Admitted{};
+            std::exception_ptr Error{};
+            arcana::task_completion_source<std::vector<bimg::ImageContainer*>, std::exception_ptr> Completion{};
+        };
+
+        struct Job
+        {
+            DecodeFunction Decode{};
+            std::shared_ptr<Batch> JobBatch{};
+            size_t Index{};
+            Priority JobPriority{};
+            uint64_t Sequence{};
+        };
+
+        void Release(uint64_t byteCount);
+        void WorkerProcedure(size_t workerIndex);
+        void Execute(Job& job);
+        // Must be called with m_mutex held.
+        std::optional<size_t> FindNextJob() const;
+        void AddWorkers(size_t workerCount);
+
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_wake{};
+        bool m_shutdown{false};
+        uint64_t m_nextSequence{0};
+
+        std::vector<Job> m_queue{};
+        size_t m_inFlight{0};
+        size_t m_workerLimit{0};
+        uint64_t m_pendingBytes{0};
+        uint64_t m_byteBudget{0};
+
+        uint64_t m_decodedImages{0};
+        uint64_t m_decodedBytes{0};
+        std::chrono::steady_clock::duration m_decodeTime{};
+
+        std::vector<std::thread> m_workers{};
+        std::shared_ptr<Reservation::Link> m_link;
+    };
+}
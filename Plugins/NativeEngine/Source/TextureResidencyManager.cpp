@@ -0,0 +1,179 @@
+#include "TextureResidencyManager.h"
+#include "NativeEngine.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Babylon
+{
+    bool TextureResidencyManager::IsEnabled() const
+    {
+        std::scoped_lock lock{m_mutex};
+        return m_byteBudget > 0;
+    }
+
+    void TextureResidencyManager::SetByteBudget(uint64_t byteBudget)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_byteBudget = byteBudget;
+    }
+
+    void TextureResidencyManager::Track(TextureData& texture)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_entries.emplace(&texture, Entry{});
+    }
+
+    void TextureResidencyManager::Untrack(TextureData& texture)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_entries.erase(&texture);
+    }
+
+    void TextureResidencyManager::SetSource(TextureData& texture, Source source)
+    {
+        std::scoped_lock lock{m_mutex};
+        auto it = m_entries.find(&texture);
+        if (it != m_entries.end())
+        {
+            it->second.TextureSource = std::move(source);
+        }
+    }
+
+    std::optional<TextureResidencyManager::Source> TextureResidencyManager::GetSource(TextureData& texture) const
+    {
+        std::scoped_lock lock{m_mutex};
+        auto it = m_entries.find(&texture);
+        return it != m_entries.end() ? it->second.TextureSource : std::nullopt;
+    }
+
+    void TextureResidencyManager::OnTextureCreated(TextureData& texture, const bimg::ImageContainer& image)
+    {
+        texture.LastUsedFrame = m_frame.load();
+
+        if (image.m_cubeMap || image.m_depth != 1 || image.m_numLayers != 1)
+        {
+            return;
+        }
+
+        std::scoped_lock lock{m_mutex};
+        auto it = m_entries.find(&texture);
+        if (it == m_entries.end() || !it->second.TextureSource.has_value() || it->second.TexturePlaceholder.has_value())
+        {
+            return;
+        }
+
+        // The first level that fits in the placeholder size, unless that is the whole image.
+        for (uint8_t lod = 1; lod < image.m_numMips; ++lod)
+        {
+            bimg::ImageMip mip{};
+            if (!bimg::imageGetRawData(image, 0, lod, image.m_data, image.m_size, mip))
+            {
+                return;
+            }
+
+            if (std::max(mip.m_width, mip.m_height) <= PLACEHOLDER_SIZE)
+            {
+                // The rest of the mip chain follows the level in memory.
+                const auto* end = static_cast<const uint8_t*>(image.m_data) + image.m_size;
+                Placeholder placeholder{{mip.m_data, end}, static_cast<uint16_t>(mip.m_width), static_cast<uint16_t>(mip.m_height),
+                    static_cast<bgfx::TextureFormat::Enum>(image.m_format), lod + 1 < image.m_numMips};
+                it->second.TexturePlaceholder = std::move(placeholder);
+                return;
+            }
+        }
+    }
+
+    bool TextureResidencyManager::Touch(TextureData& texture)
+    {
+        texture.LastUsedFrame = m_frame.load();
+        // Passes encoded in parallel may touch the same texture, only one of them reloads it.
+        if (!texture.Evicted.exchange(false))
+        {
+            return false;
+        }
+
+        std::scoped_lock lock{m_mutex};
+        ++m_reloads;
+        return true;
+    }
+
+    void TextureResidencyManager::Update(TextureStreamer& streamer)
+    {
+        ++m_frame;
+
+        std::scoped_lock lock{m_mutex};
+        if (m_byteBudget == 0)
+        {
+            return;
+        }
+
+        uint64_t residentBytes{GetResidentBytes()};
+        if (residentBytes <= m_byteBudget)
+        {
+            return;
+        }
+
+        for (auto* texture : GetEvictionCandidates())
+        {
+            if (residentBytes <= m_byteBudget)
+            {
+                return;
+            }
+
+            const auto& placeholder = m_entries.at(texture).TexturePlaceholder;
+            if (texture->Evicted || texture->ByteSize <= placeholder->Bytes.size())
+            {
+                continue;
+            }
+
+            streamer.Remove(*texture);
+            if (bgfx::isValid(texture->Handle))
+            {
+                bgfx::destroy(texture->Handle);
+            }
+
+            const auto byteCount = static_cast<uint32_t>(placeholder->Bytes.size());
+            texture->Handle = bgfx::createTexture2D(placeholder->Width, placeholder->Height, placeholder->HasMips, 1, placeholder->Format, BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, bgfx::copy(placeholder->Bytes.data(), byteCount));
+            residentBytes -= texture->ByteSize - std::min<uint64_t>(texture->ByteSize, byteCount);
+            texture->ByteSize = byteCount;
+            texture->Evicted = true;
+            ++m_evictions;
+        }
+    }
+
+    TextureResidencyManager::Statistics TextureResidencyManager::GetStatistics() const
+    {
+        std::scoped_lock lock{m_mutex};
+
+        const size_t evictedTextures = std::count_if(m_entries.begin(), m_entries.end(), [](const auto& entry) { return entry.first->Evicted.load(); });
+        return {m_entries.size(), evictedTextures, GetResidentBytes(), m_byteBudget, m_evictions, m_reloads};
+    }
+
+    uint64_t TextureResidencyManager::GetResidentBytes() const
+    {
+        uint64_t residentBytes{0};
+        for (const auto& [texture, entry] : m_entries)
+        {
+            residentBytes += texture->ByteSize;
+        }
+        return residentBytes;
+    }
+
+    std::vector<TextureData*> TextureResidencyManager::GetEvictionCandidates() const
+    {
+        // Reloadable textures with a placeholder that were not used in the previous frame, least recently
+        // used first.
+        std::vector<TextureData*> candidates{};
+        for (const auto& [texture, entry] : m_entries)
+        {
+            if (entry.TextureSource.has_value() && entry.TexturePlaceholder.has_value() && texture->LastUsedFrame + 1 < m_frame)
+            {
+                candidates.push_back(texture);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const TextureData* a, const TextureData* b) { return a->LastUsedFrame < b->LastUsedFrame; });
+        return candidates;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "TextureStreamer.h"
+
+#include <bgfx/bgfx.h>
+#include <bimg/bimg.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace Babylon
+{
+    struct TextureData;
+
+    /// Keeps the memory used by textures within a budget. Every texture is accounted for by the size of the
+    /// levels it has uploaded, and when the total goes over the budget the textures that have gone unused
+    /// the longest are evicted down to a small placeholder made of their lowest mip levels. They are sampled
+    /// from the placeholder until they are decoded again from their retained source bytes, the next time they
+    /// are bound. Only textures with both a source and a placeholder can be evicted, so that an evicted texture
+    /// always has a valid handle to bind.
+    class TextureResidencyManager final
+    {
+    public:
+        // Evicted textures keep the levels at the end of their mip chain that are at most this large.
+        static constexpr uint32_t PLACEHOLDER_SIZE{32};
+
+        // What is needed to load an evicted texture again.
+        struct Source
+        {
+            std::shared_ptr<const std::vector<uint8_t>> Bytes{};
+            bool GenerateMips{};
+            bool InvertY{};
+        };
+
+        struct Statistics
+        {
+            size_t TrackedTextures{};
+            size_t EvictedTextures{};
+            uint64_t ResidentBytes{};
+            uint64_t ByteBudget{};
+            uint64_t Evictions{};
+            uint64_t Reloads{};
+        };
+
+        TextureResidencyManager() = default;
+        TextureResidencyManager(const TextureResidencyManager&) = delete;
+        TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+
+        // A budget of zero, the default, disables eviction. Sources only need to be retained when enabled.
+        bool IsEnabled() const;
+        void SetByteBudget(uint64_t byteBudget);
+
+        void Track(TextureData& texture);
+        void Untrack(TextureData& texture);
+
+        void SetSource(TextureData& texture, Source source);
+        std::optional<Source> GetSource(TextureData& texture) const;
+
+        // Called when the texture is created from a decoded image. The texture counts as used in the current
+        // frame, so that it is not evicted before it is first bound, and if it has a source to be reloaded
+        // from, a copy of the lowest levels of the image is kept as its placeholder.
+        void OnTextureCreated(TextureData& texture, const bimg::ImageContainer& image);
+
+        // Records that the texture is used in the current frame. Returns true if the texture had been
+        // evicted, in which case the caller must load it again from its source.
+        bool Touch(TextureData& texture);
+
+        // Starts a new frame and evicts textures until the budget is met. Textures used in the previous
+        // frame are never evicted. Must be called at the start of a frame, before any texture is bound.
+        void Update(TextureStreamer& streamer);
+
+        Statistics GetStatistics() const;
+
+    private:
+        struct Placeholder
+        {
+            std::vector<uint8_t> Bytes{};
+            uint16_t Width{};
+            uint16_t Height{};
+            bgfx::TextureFormat::Enum Format{};
+            bool HasMips{};
+        };
+
+        struct Entry
+        {
+            std::optional<Source> TextureSource{};
+            std::optional<Placeholder> TexturePlaceholder{};
+        };
+
+        // Must be called with m_mutex held.
+        uint64_t GetResidentBytes() const;
+        std::vector<TextureData*> GetEvictionCandidates() const;
+
+        mutable std::mutex m_mutex{};
+        std::unordered_map<TextureData*, Entry> m_entries{};
+        uint64_t m_byteBudget{0};
+        std::atomic<uint32_t> m_frame{0};
+
+        uint64_t m_evictions{0};
+        uint64_t m_reloads{0};
+    };
+}
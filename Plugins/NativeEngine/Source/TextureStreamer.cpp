@@ -0,0 +1,182 @@
+#include "TextureStreamer.h"
+#include "NativeEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Babylon
+{
+    namespace
+    {
+        bimg::ImageMip GetMip(const bimg::ImageContainer& image, uint8_t lod)
+        {
+            bimg::ImageMip mip{};
+            if (!bimg::imageGetRawData(image, 0, lod, image.m_data, image.m_size, mip))
+            {
+                throw std::runtime_error{"Unable to get image mip data."};
+            }
+            return mip;
+        }
+
+        uint32_t GetMipSize(uint32_t width, uint32_t height, uint8_t lod)
+        {
+            return std::max<uint32_t>(std::max(width, height) >> lod, 1);
+        }
+
+        // The smallest level whose largest dimension is at least the given size.
+        uint8_t GetLodForSize(uint32_t width, uint32_t height, uint8_t numMips, uint32_t pixelSize)
+        {
+            for (uint8_t lod = numMips - 1; lod > 0; --lod)
+            {
+                if (GetMipSize(width, height, lod) >= pixelSize)
+                {
+                    return lod;
+                }
+            }
+            return 0;
+        }
+
+        // Bytes from the given level to the end of the mip chain, which bimg stores contiguously.
+        uint64_t GetTailSize(const bimg::ImageContainer& image, uint8_t lod)
+        {
+            const auto mip = GetMip(image, lod);
+            return image.m_size - static_cast<uint64_t>(mip.m_data - static_cast<const uint8_t*>(image.m_data));
+        }
+
+        bgfx::TextureHandle CreateTexture(const std::shared_ptr<bimg::ImageContainer>& image, uint8_t lod)
+        {
+            const auto mip = GetMip(*image, lod);
+
+            // The memory reference keeps the image alive until bgfx has copied the levels.
+            auto releaseFn = [](void* /*ptr*/, void* userData) {
+                delete static_cast<std::shared_ptr<bimg::ImageContainer>*>(userData);
+            };
+            const auto mem = bgfx::makeRef(mip.m_data, static_cast<uint32_t>(GetTailSize(*image, lod)), releaseFn, new std::shared_ptr<bimg::ImageContainer>{image});
+
+            const bool hasMips = image->m_numMips - lod > 1;
+            return bgfx::createTexture2D(static_cast<uint16_t>(mip.m_width), static_cast<uint16_t>(mip.m_height), hasMips, 1, static_cast<bgfx::TextureFormat::Enum>(image->m_format), BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE, mem);
+        }
+    }
+
+    bool TextureStreamer::CanStream(const bimg::ImageContainer& image)
+    {
+        return !image.m_cubeMap && image.m_depth == 1 && image.m_numLayers == 1 && image.m_numMips > 1 && GetMipSize(image.m_width, image.m_height, 1) >= INITIAL_SIZE;
+    }
+
+    void TextureStreamer::Create(TextureData& texture, bimg::ImageContainer* image)
+    {
+        Entry entry{&texture, {image, bimg::imageFree}, image->m_width, image->m_height, image->m_numMips};
+        entry.Lod = GetLodForSize(entry.Width, entry.Height, entry.NumMips, INITIAL_SIZE);
+        entry.TargetLod = 0;
+
+        texture.Handle = CreateTexture(entry.Image, entry.Lod);
+        texture.ByteSize = GetTailSize(*image, entry.Lod);
+        texture.Width = image->m_width;
+        texture.Height = image->m_height;
+
+        std::scoped_lock lock{m_mutex};
+        m_entries.push_back(std::move(entry));
+    }
+
+    bool TextureStreamer::SetTargetSize(const TextureData& texture, uint32_t pixelSize)
+    {
+        std::scoped_lock lock{m_mutex};
+        auto it = Find(texture);
+        if (it == m_entries.end())
+        {
+            return false;
+        }
+
+        it->TargetLod = pixelSize == 0 ? 0 : GetLodForSize(it->Width, it->Height, it->NumMips, pixelSize);
+        if (it->Image == nullptr && it->TargetLod < it->Lod && !it->ReloadRequested)
+        {
+            it->ReloadRequested = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    void TextureStreamer::Remove(const TextureData& texture)
+    {
+        std::scoped_lock lock{m_mutex};
+        auto it = Find(texture);
+        if (it != m_entries.end())
+        {
+            m_entries.erase(it);
+        }
+    }
+
+    void TextureStreamer::Step()
+    {
+        std::scoped_lock lock{m_mutex};
+
+        uint64_t remainingBudget{m_uploadBudget};
+        bool uploaded{false};
+        while (true)
+        {
+            // Textures displayed at the lowest resolution relative to their size are refined first.
+            Entry* next{};
+            for (auto& entry : m_entries)
+            {
+                if (entry.Image != nullptr && entry.Lod > entry.TargetLod && (next == nullptr || entry.Lod > next->Lod))
+                {
+                    next = &entry;
+                }
+            }
+
+            if (next == nullptr)
+            {
+                break;
+            }
+
+            // bgfx textures created from memory cannot have levels added later, so the texture is
+            // recreated from the next level down, which uploads the whole remaining mip chain again.
+            const uint8_t lod = next->Lod - 1;
+            const uint64_t byteCount = GetTailSize(*next->Image, lod);
+            if (uploaded && byteCount > remainingBudget)
+            {
+                break;
+            }
+
+            const bgfx::TextureHandle handle = CreateTexture(next->Image, lod);
+            bgfx::destroy(next->Texture->Handle);
+            next->Texture->Handle = handle;
+            next->Texture->ByteSize = byteCount;
+            next->Lod = lod;
+
+            remainingBudget -= std::min(byteCount, remainingBudget);
+            uploaded = true;
+        }
+
+        // Textures that reached their target no longer need their image. Those that are not fully resident
+        // are still tracked so that they can be reloaded if they are later displayed larger.
+        for (auto& entry : m_entries)
+        {
+            if (entry.Lod <= entry.TargetLod)
+            {
+                entry.Image.reset();
+            }
+        }
+
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return entry.Lod == 0; }), m_entries.end());
+    }
+
+    bool TextureStreamer::HasPendingWork() const
+    {
+        std::scoped_lock lock{m_mutex};
+        // Entries keep their image only while it has levels left to upload or until the next step drops it.
+        return std::any_of(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return entry.Image != nullptr; });
+    }
+
+    void TextureStreamer::SetUploadBudget(uint64_t bytesPerFrame)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_uploadBudget = bytesPerFrame;
+    }
+
+    std::vector<TextureStreamer::Entry>::iterator TextureStreamer::Find(const TextureData& texture)
+    {
+        return std::find_if(m_entries.begin(), m_entries.end(), [&texture](const Entry& entry) { return entry.Texture == &texture; });
+    }
+}
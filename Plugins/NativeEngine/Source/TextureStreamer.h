@@ -0,0 +1,75 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+#include <bimg/bimg.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Babylon
+{
+    struct TextureData;
+
+    /// Uploads large mipmapped textures progressively. A texture is first created from the small levels at
+    /// the end of its mip chain, so that it can be sampled as soon as it is decoded, and is then recreated
+    /// one level larger at a time, within a per-frame upload budget, until it reaches the resolution it is
+    /// displayed at. The decoded image is dropped as soon as the texture reaches that resolution; a texture
+    /// that is later displayed larger than that has to be reloaded to get the larger levels back.
+    class TextureStreamer final
+    {
+    public:
+        // Streamed textures are first created from the smallest level whose largest dimension is at least
+        // this many pixels.
+        static constexpr uint32_t INITIAL_SIZE{64};
+        static constexpr uint64_t DEFAULT_UPLOAD_BUDGET{8 * 1024 * 1024};
+
+        TextureStreamer() = default;
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Whether the image is a single 2D image with mip levels above the initial size.
+        static bool CanStream(const bimg::ImageContainer& image);
+
+        // Creates the texture from the smallest levels of the image and takes ownership of the image.
+        void Create(TextureData& texture, bimg::ImageContainer* image);
+
+        // Sets the largest dimension, in pixels, the texture is displayed at. The texture is streamed up to
+        // the first level at least that large; zero streams the whole mip chain. Levels that have already
+        // been uploaded are kept when the size shrinks. Returns true, once, when the image of the texture
+        // has already been dropped and it must be reloaded to reach the new size.
+        bool SetTargetSize(const TextureData& texture, uint32_t pixelSize);
+
+        // Must be called before the texture is destroyed.
+        void Remove(const TextureData& texture);
+
+        // Uploads the next levels of the textures that are furthest from their target. At least one level
+        // is uploaded per step, even if it is larger than the budget. Must be called on the render thread,
+        // outside of a frame.
+        void Step();
+
+        bool HasPendingWork() const;
+
+        void SetUploadBudget(uint64_t bytesPerFrame);
+
+    private:
+        struct Entry
+        {
+            TextureData* Texture{};
+            // Null once the texture has reached its target level.
+            std::shared_ptr<bimg::ImageContainer> Image{};
+            uint32_t Width{};
+            uint32_t Height{};
+            uint8_t NumMips{};
+            uint8_t Lod{};
+            uint8_t TargetLod{};
+            bool ReloadRequested{};
+        };
+
+        std::vector<Entry>::iterator Find(const TextureData& texture);
+
+        mutable std::mutex m_mutex{};
+        std::vector<Entry> m_entries{};
+        uint64_t m_uploadBudget{DEFAULT_UPLOAD_BUDGET};
+    };
+}
@@ -0,0 +1,87 @@
+#include "VertexLayoutCache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Babylon
+{
+    namespace
+    {
+        void HashCombine(size_t& seed, size_t value)
+        {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+    }
+
+    bgfx::VertexLayoutHandle VertexLayoutCache::Acquire(gsl::span<const Attribute> attributes, uint16_t stride)
+    {
+        Key key{{attributes.begin(), attributes.end()}, stride};
+        std::sort(key.Attributes.begin(), key.Attributes.end(), [](const Attribute& a, const Attribute& b) { return a.Attrib < b.Attrib; });
+
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+        {
+            bgfx::VertexLayout layout{};
+            layout.begin();
+            for (const auto& attribute : key.Attributes)
+            {
+                layout.add(attribute.Attrib, attribute.Count, attribute.Type, attribute.Normalized);
+            }
+
+            // bgfx packs attributes in the order they are added; interleaved buffers need the actual offsets.
+            for (const auto& attribute : key.Attributes)
+            {
+                layout.m_offset[attribute.Attrib] = attribute.Offset;
+            }
+
+            layout.m_stride = stride;
+            layout.end();
+
+            const bgfx::VertexLayoutHandle handle = bgfx::createVertexLayout(layout);
+            if (!bgfx::isValid(handle))
+            {
+                throw std::runtime_error{"Out of vertex layout handles."};
+            }
+
+            it = m_entries.emplace(std::move(key), Entry{handle, 0}).first;
+            m_keys.emplace(handle.idx, &it->first);
+        }
+
+        ++it->second.RefCount;
+        return it->second.Handle;
+    }
+
+    void VertexLayoutCache::Release(bgfx::VertexLayoutHandle handle)
+    {
+        const auto keyIt = m_keys.find(handle.idx);
+        if (keyIt == m_keys.end())
+        {
+            return;
+        }
+
+        const auto it = m_entries.find(*keyIt->second);
+        if (--it->second.RefCount == 0)
+        {
+            bgfx::destroy(handle);
+            m_keys.erase(keyIt);
+            m_entries.erase(it);
+        }
+    }
+
+    size_t VertexLayoutCache::GetSize() const
+    {
+        return m_entries.size();
+    }
+
+    size_t VertexLayoutCache::KeyHash::operator()(const Key& key) const
+    {
+        size_t seed = std::hash<uint16_t>{}(key.Stride);
+        for (const auto& attribute : key.Attributes)
+        {
+            HashCombine(seed, std::hash<uint32_t>{}(static_cast<uint32_t>(attribute.Attrib) | (static_cast<uint32_t>(attribute.Count) << 8) | (static_cast<uint32_t>(attribute.Type) << 16) | (static_cast<uint32_t>(attribute.Normalized) << 24)));
+            HashCombine(seed, std::hash<uint16_t>{}(attribute.Offset));
+        }
+
+        return seed;
+    }
+}
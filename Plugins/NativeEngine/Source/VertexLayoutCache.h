@@ -0,0 +1,71 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <gsl/gsl>
+
+#include <unordered_map>
+#include <vector>
+
+namespace Babylon
+{
+    /// Interns bgfx vertex layouts. bgfx only has a small fixed pool of layout handles, so every vertex
+    /// array that describes the same layout shares a single reference counted handle, which is destroyed
+    /// once the last vertex array using it releases it.
+    class VertexLayoutCache final
+    {
+    public:
+        struct Attribute
+        {
+            bgfx::Attrib::Enum Attrib{};
+            uint8_t Count{};
+            bgfx::AttribType::Enum Type{};
+            bool Normalized{};
+            uint16_t Offset{};
+
+            bool operator==(const Attribute& other) const
+            {
+                return Attrib == other.Attrib && Count == other.Count && Type == other.Type && Normalized == other.Normalized && Offset == other.Offset;
+            }
+        };
+
+        // Layouts still in use when the cache is destroyed are left to bgfx::shutdown.
+        VertexLayoutCache() = default;
+        VertexLayoutCache(const VertexLayoutCache&) = delete;
+        VertexLayoutCache& operator=(const VertexLayoutCache&) = delete;
+
+        // Returns a handle for the layout made of the given attributes, each of which must be used at most
+        // once. Every acquired handle must be released exactly once.
+        bgfx::VertexLayoutHandle Acquire(gsl::span<const Attribute> attributes, uint16_t stride);
+        void Release(bgfx::VertexLayoutHandle handle);
+
+        size_t GetSize() const;
+
+    private:
+        struct Key
+        {
+            std::vector<Attribute> Attributes{};
+            uint16_t Stride{};
+
+            bool operator==(const Key& other) const
+            {
+                return Stride == other.Stride && Attributes == other.Attributes;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            bgfx::VertexLayoutHandle Handle{bgfx::kInvalidHandle};
+            uint32_t RefCount{};
+        };
+
+        std::unordered_map<Key, Entry, KeyHash> m_entries{};
+        // Element pointers of an unordered_map remain valid when it rehashes.
+        std::unordered_map<uint16_t, const Key*> m_keys{};
+    };
+}
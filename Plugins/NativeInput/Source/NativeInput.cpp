@@ -55,7 +55,7 @@ namespace Babylon::Plugins
     }
 
     NativeInput::Impl::Impl(Napi::Env env)
-        : m_runtimeScheduler{JsRuntime::GetFromJavaScript(env)}
+        : m_runtimeScheduler{JsRuntime::GetFromJavaScript(env), JsRuntime::DispatchPriority::Input}
     {
         NativeInput::Impl::DeviceInputSystem::Initialize(env);
     }
@@ -278,7 +278,7 @@ namespace Babylon
                 }
                 else
                 {
-                    m_graphicsImpl.AddRenderWorkTask(arcana::make_task(m_engineImpl->RuntimeScheduler, arcana::cancellation::none(), [this, callback = std::move(callback)] {
+                    m_graphicsImpl.AddRenderWorkTask(arcana::make_task(m_engineImpl->FrameScheduler, arcana::cancellation::none(), [this, callback = std::move(callback)] {
                         callback(*m_frame);
                     }));
                 }
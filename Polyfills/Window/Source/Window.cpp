@@ -1,7 +1,9 @@
 #include "Window.h"
 #include <basen.hpp>
+#include <algorithm>
 #include <chrono>
 #include <iterator>
+#include <vector>
 
 namespace Babylon::Polyfills::Internal
 {
@@ -9,9 +11,20 @@ namespace Babylon::Polyfills::Internal
     {
         constexpr auto JS_CLASS_NAME = "Window";
         constexpr auto JS_SET_TIMEOUT_NAME = "setTimeout";
+        constexpr auto JS_SET_INTERVAL_NAME = "setInterval";
+        constexpr auto JS_CLEAR_TIMEOUT_NAME = "clearTimeout";
+        constexpr auto JS_CLEAR_INTERVAL_NAME = "clearInterval";
+        constexpr auto JS_REQUEST_IDLE_CALLBACK_NAME = "requestIdleCallback";
+        constexpr auto JS_CANCEL_IDLE_CALLBACK_NAME = "cancelIdleCallback";
+        constexpr auto JS_TIMEOUT_NAME = "timeout";
+        constexpr auto JS_DID_TIMEOUT_NAME = "didTimeout";
+        constexpr auto JS_TIME_REMAINING_NAME = "timeRemaining";
         constexpr auto JS_A_TO_B_NAME = "atob";
         constexpr auto JS_ADD_EVENT_LISTENER_NAME = "addEventListener";
         constexpr auto JS_REMOVE_EVENT_LISTENER_NAME = "removeEventListener";
+
+        // Intervals shorter than this would keep the JavaScript thread from ever sleeping.
+        constexpr std::chrono::milliseconds MIN_INTERVAL{1};
     }
 
     void Window::Initialize(Napi::Env env)
@@ -39,6 +52,32 @@ namespace Babylon::Polyfills::Internal
             global.Set(JS_SET_TIMEOUT_NAME, Napi::Function::New(env, &Window::SetTimeout, JS_SET_TIMEOUT_NAME, Window::Unwrap(jsWindow)));
         }
 
+        if (global.Get(JS_SET_INTERVAL_NAME).IsUndefined())
+        {
+            global.Set(JS_SET_INTERVAL_NAME, Napi::Function::New(env, &Window::SetInterval, JS_SET_INTERVAL_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        // Timeouts and intervals share their ids, so either function clears both, as in browsers.
+        if (global.Get(JS_CLEAR_TIMEOUT_NAME).IsUndefined())
+        {
+            global.Set(JS_CLEAR_TIMEOUT_NAME, Napi::Function::New(env, &Window::ClearTimer, JS_CLEAR_TIMEOUT_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        if (global.Get(JS_CLEAR_INTERVAL_NAME).IsUndefined())
+        {
+            global.Set(JS_CLEAR_INTERVAL_NAME, Napi::Function::New(env, &Window::ClearTimer, JS_CLEAR_INTERVAL_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        if (global.Get(JS_REQUEST_IDLE_CALLBACK_NAME).IsUndefined())
+        {
+            global.Set(JS_REQUEST_IDLE_CALLBACK_NAME, Napi::Function::New(env, &Window::RequestIdleCallback, JS_REQUEST_IDLE_CALLBACK_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        if (global.Get(JS_CANCEL_IDLE_CALLBACK_NAME).IsUndefined())
+        {
+            global.Set(JS_CANCEL_IDLE_CALLBACK_NAME, Napi::Function::New(env, &Window::CancelIdleCallback, JS_CANCEL_IDLE_CALLBACK_NAME, Window::Unwrap(jsWindow)));
+        }
+
         if (global.Get(JS_A_TO_B_NAME).IsUndefined())
         {
             global.Set(JS_A_TO_B_NAME, Napi::Function::New(env, &Window::DecodeBase64, JS_A_TO_B_NAME));
@@ -66,14 +105,65 @@ namespace Babylon::Polyfills::Internal
     {
     }
 
-    void Window::SetTimeout(const Napi::CallbackInfo& info)
+    Napi::Value Window::SetTimeout(const Napi::CallbackInfo& info)
     {
-        auto function = Napi::Persistent(info[0].As<Napi::Function>());
-        auto milliseconds = std::chrono::milliseconds{info[1].As<Napi::Number>().Int32Value()};
+        auto& window = *static_cast<Window*>(info.Data());
+        return window.AddTimer(info, false);
+    }
 
+    Napi::Value Window::SetInterval(const Napi::CallbackInfo& info)
+    {
         auto& window = *static_cast<Window*>(info.Data());
+        return window.AddTimer(info, true);
+    }
 
-        window.RecursiveWaitOrCall(std::make_shared<Napi::FunctionReference>(std::move(function)), std::chrono::system_clock::now() + milliseconds);
+    void Window::ClearTimer(const Napi::CallbackInfo& info)
+    {
+        auto& window = *static_cast<Window*>(info.Data());
+        if (info[0].IsNumber())
+        {
+            window.m_timers.erase(info[0].As<Napi::Number>().Uint32Value());
+        }
+    }
+
+    Napi::Value Window::RequestIdleCallback(const Napi::CallbackInfo& info)
+    {
+        auto& window = *static_cast<Window*>(info.Data());
+
+        IdleCallback callback{};
+        callback.Function = Napi::Persistent(info[0].As<Napi::Function>());
+        if (info[1].IsObject())
+        {
+            const auto timeout = info[1].As<Napi::Object>().Get(JS_TIMEOUT_NAME);
+            if (timeout.IsNumber() && timeout.As<Napi::Number>().Int32Value() > 0)
+            {
+                callback.Timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds{timeout.As<Napi::Number>().Int32Value()};
+            }
+        }
+
+        const uint32_t id = window.m_nextIdleCallbackId++;
+        const auto timeout = callback.Timeout;
+        window.m_idleCallbacks.emplace(id, std::move(callback));
+        window.ScheduleIdleCallback(id);
+
+        // Whichever of the idle period and the timeout comes first runs the callback.
+        if (timeout.has_value())
+        {
+            window.m_runtime.DispatchAt(*timeout, [&window, id](Napi::Env) {
+                window.RunIdleCallback(id, true);
+            });
+        }
+
+        return Napi::Value::From(info.Env(), id);
+    }
+
+    void Window::CancelIdleCallback(const Napi::CallbackInfo& info)
+    {
+        auto& window = *static_cast<Window*>(info.Data());
+        if (info[0].IsNumber())
+        {
+            window.m_idleCallbacks.erase(info[0].As<Napi::Number>().Uint32Value());
+        }
     }
 
     Napi::Value Window::DecodeBase64(const Napi::CallbackInfo& info)
@@ -94,21 +184,115 @@ namespace Babylon::Polyfills::Internal
         // TODO: handle events
     }
 
-    void Window::RecursiveWaitOrCall(
-        std::shared_ptr<Napi::FunctionReference> function,
-        std::chrono::system_clock::time_point whenToRun)
+    Napi::Value Window::AddTimer(const Napi::CallbackInfo& info, bool repeat)
     {
-        m_runtime.Dispatch([this, function = std::move(function), whenToRun](Napi::Env) {
-            if (std::chrono::system_clock::now() >= whenToRun)
+        Timer timer{};
+        timer.Function = Napi::Persistent(info[0].As<Napi::Function>());
+        if (info.Length() > 2)
+        {
+            auto arguments = Napi::Array::New(info.Env(), info.Length() - 2);
+            for (size_t index = 2; index < info.Length(); ++index)
             {
-                function->Call({});
+                arguments.Set(static_cast<uint32_t>(index - 2), info[index]);
             }
-            else
+            timer.Arguments = Napi::Persistent(arguments);
+        }
+
+        const auto delay = std::chrono::milliseconds{info[1].IsUndefined() ? 0 : std::max(info[1].ToNumber().Int32Value(), 0)};
+        timer.Interval = repeat ? std::max(delay, MIN_INTERVAL) : std::chrono::milliseconds{0};
+        timer.Deadline = std::chrono::steady_clock::now() + delay;
+
+        const uint32_t id = m_nextTimerId++;
+        const auto deadline = timer.Deadline;
+        m_timers.emplace(id, std::move(timer));
+        ScheduleTimer(id, deadline);
+
+        return Napi::Value::From(info.Env(), id);
+    }
+
+    void Window::ScheduleTimer(uint32_t id, std::chrono::steady_clock::time_point deadline)
+    {
+        m_runtime.DispatchAt(deadline, [this, id](Napi::Env) {
+            RunTimer(id);
+        });
+    }
+
+    void Window::RunTimer(uint32_t id)
+    {
+        auto it = m_timers.find(id);
+        if (it == m_timers.end())
+        {
+            return;
+        }
+
+        auto& timer = it->second;
+        Napi::Function function = timer.Function.Value();
+        std::vector<napi_value> arguments{};
+        if (!timer.Arguments.IsEmpty())
+        {
+            const auto jsArguments = timer.Arguments.Value();
+            arguments.reserve(jsArguments.Length());
+            for (uint32_t index = 0; index < jsArguments.Length(); ++index)
             {
-                RecursiveWaitOrCall(std::move(function), whenToRun);
+                arguments.push_back(jsArguments.Get(index));
             }
+        }
+
+        // The timer is rescheduled or removed before its function runs, which may clear it or add others.
+        if (timer.Interval.count() > 0)
+        {
+            // Deadlines advance by whole intervals so that intervals do not drift, but skip the ticks missed
+            // while the thread was busy rather than running them back to back.
+            const auto now = std::chrono::steady_clock::now();
+            timer.Deadline = std::max(timer.Deadline + timer.Interval, now);
+            ScheduleTimer(id, timer.Deadline);
+        }
+        else
+        {
+            m_timers.erase(it);
+        }
+
+        function.Call(arguments);
+    }
+
+    void Window::ScheduleIdleCallback(uint32_t id)
+    {
+        m_runtime.Dispatch(JsRuntime::DispatchPriority::Idle, [this, id](Napi::Env) {
+            RunIdleCallback(id, false);
         });
     }
+
+    void Window::RunIdleCallback(uint32_t id, bool didTimeout)
+    {
+        auto it = m_idleCallbacks.find(id);
+        if (it == m_idleCallbacks.end())
+        {
+            return;
+        }
+
+        // Callbacks requested by earlier ones in the same idle period may find no time left, in which
+        // case they wait for the next one.
+        const auto now = std::chrono::steady_clock::now();
+        const auto deadline = didTimeout ? now : m_runtime.GetIdleDeadline();
+        if (!didTimeout && deadline <= now)
+        {
+            ScheduleIdleCallback(id);
+            return;
+        }
+
+        Napi::Function function = it->second.Function.Value();
+        m_idleCallbacks.erase(it);
+
+        const auto env = function.Env();
+        auto idleDeadline = Napi::Object::New(env);
+        idleDeadline.Set(JS_DID_TIMEOUT_NAME, Napi::Boolean::New(env, didTimeout));
+        idleDeadline.Set(JS_TIME_REMAINING_NAME, Napi::Function::New(env, [deadline](const Napi::CallbackInfo& info) {
+            const auto remaining = std::max(deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+            return Napi::Value::From(info.Env(), std::chrono::duration<double, std::milli>{remaining}.count());
+        }, JS_TIME_REMAINING_NAME));
+
+        function.Call({idleDeadline});
+    }
 }
 
 namespace Babylon::Polyfills::Window
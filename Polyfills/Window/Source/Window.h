@@ -2,6 +2,10 @@
 
 #include <Babylon/JsRuntime.h>
 
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+
 namespace Babylon::Polyfills::Internal
 {
     class Window : public Napi::ObjectWrap<Window>
@@ -15,13 +19,47 @@ namespace Babylon::Polyfills::Internal
         Window(const Napi::CallbackInfo& info);
 
     private:
+        struct Timer
+        {
+            Napi::FunctionReference Function{};
+            // The arguments passed on to the function, held in a single array since primitives cannot be
+            // referenced on every engine. Empty when there are none.
+            Napi::Reference<Napi::Array> Arguments{};
+            std::chrono::steady_clock::time_point Deadline{};
+            // Zero for a timeout, which runs once.
+            std::chrono::milliseconds Interval{};
+        };
+
+        struct IdleCallback
+        {
+            Napi::FunctionReference Function{};
+            // Set when the callback was given a timeout, after which it runs even without idle time.
+            std::optional<std::chrono::steady_clock::time_point> Timeout{};
+        };
+
         JsRuntime& m_runtime;
 
-        static void SetTimeout(const Napi::CallbackInfo& info);
+        // Timers that have not run or been cleared yet. Clearing a timer releases its function right away,
+        // while the runtime keeps only the timer id until the deadline.
+        std::unordered_map<uint32_t, Timer> m_timers{};
+        uint32_t m_nextTimerId{1};
+
+        std::unordered_map<uint32_t, IdleCallback> m_idleCallbacks{};
+        uint32_t m_nextIdleCallbackId{1};
+
+        static Napi::Value SetTimeout(const Napi::CallbackInfo& info);
+        static Napi::Value SetInterval(const Napi::CallbackInfo& info);
+        static void ClearTimer(const Napi::CallbackInfo& info);
+        static Napi::Value RequestIdleCallback(const Napi::CallbackInfo& info);
+        static void CancelIdleCallback(const Napi::CallbackInfo& info);
         static Napi::Value DecodeBase64(const Napi::CallbackInfo& info);
         static void AddEventListener(const Napi::CallbackInfo& info);
         static void RemoveEventListener(const Napi::CallbackInfo& info);
 
-        void RecursiveWaitOrCall(std::shared_ptr<Napi::FunctionReference> function, std::chrono::system_clock::time_point whenToRun);
+        Napi::Value AddTimer(const Napi::CallbackInfo& info, bool repeat);
+        void ScheduleTimer(uint32_t id, std::chrono::steady_clock::time_point deadline);
+        void RunTimer(uint32_t id);
+        void ScheduleIdleCallback(uint32_t id);
+        void RunIdleCallback(uint32_t id, bool didTimeout);
     };
 }
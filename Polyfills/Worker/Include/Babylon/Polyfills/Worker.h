@@ -0,0 +1,16 @@
+#pragma once
+
+#include <napi/env.h>
+
+#include <functional>
+
+namespace Babylon::Polyfills::Worker
+{
+    /**
+     * Sets up the JavaScript environment of a worker before its script runs, for instance by initializing
+     * the polyfills it needs. Called on the worker's own thread, so it must be thread safe.
+     */
+    using InitializeFunctionT = std::function<void(Napi::Env)>;
+
+    void Initialize(Napi::Env env, InitializeFunctionT initializeWorker = {});
+}
@@ -0,0 +1,370 @@
+#include "StructuredClone.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Babylon::Polyfills::Internal
+{
+    namespace
+    {
+        constexpr auto DATA_CLONE_ERROR = "DataCloneError: ";
+
+        // The tags that Object.prototype.toString reports for the built-in objects that browsers can clone but
+        // this implementation cannot. Cloning them as plain objects would silently lose their contents.
+        constexpr const char* UNSUPPORTED_OBJECT_TAGS[]{
+            "[object Boolean]",
+            "[object DataView]",
+            "[object Date]",
+            "[object Error]",
+            "[object Map]",
+            "[object Number]",
+            "[object Promise]",
+            "[object RegExp]",
+            "[object Set]",
+            "[object String]",
+            "[object WeakMap]",
+            "[object WeakSet]",
+        };
+
+        // The native memory behind the array buffers created by deserializing, by address, so that they can
+        // be transferred again without a copy. Shared by every environment.
+        std::mutex s_externalBuffersMutex{};
+        std::unordered_map<const void*, std::weak_ptr<std::vector<uint8_t>>> s_externalBuffers{};
+
+        // Returns false if the JavaScript engine cannot detach the array buffer.
+        bool Detach(Napi::ArrayBuffer arrayBuffer)
+        {
+#ifdef NAPI_DETACH_ARRAYBUFFER
+            return napi_detach_arraybuffer(arrayBuffer.Env(), arrayBuffer) == napi_ok;
+#else
+            (void)arrayBuffer;
+            return false;
+#endif
+        }
+    }
+
+    class StructuredClone::Serializer final
+    {
+    public:
+        Serializer(StructuredClone& clone, Napi::Value transferList)
+            : m_clone{clone}
+            , m_toString{transferList.Env().Global().Get("Object").As<Napi::Object>().Get("prototype").As<Napi::Object>().Get("toString").As<Napi::Function>()}
+        {
+            if (transferList.IsUndefined() || transferList.IsNull())
+            {
+                return;
+            }
+
+            if (!transferList.IsArray())
+            {
+                throw Napi::TypeError::New(transferList.Env(), "The transfer list must be an array.");
+            }
+
+            const auto transferArray = transferList.As<Napi::Array>();
+            for (uint32_t index = 0; index < transferArray.Length(); ++index)
+            {
+                const Napi::Value transferable = transferArray[index];
+                if (!transferable.IsArrayBuffer())
+                {
+                    throw Napi::Error::New(transferList.Env(), std::string{DATA_CLONE_ERROR} + "Only array buffers can be transferred.");
+                }
+
+                const auto arrayBuffer = transferable.As<Napi::ArrayBuffer>();
+                if (m_transferred.insert(arrayBuffer.Data()).second)
+                {
+                    m_transferList.push_back(arrayBuffer);
+                }
+            }
+        }
+
+        // Detaches the transferred array buffers once the whole value has been serialized, since several typed
+        // arrays may view the same one. Memory shared with an array buffer that cannot be detached is copied
+        // after all.
+        void DetachTransferred()
+        {
+            for (const auto& arrayBuffer : m_transferList)
+            {
+                const void* data = arrayBuffer.Data();
+                if (Detach(arrayBuffer))
+                {
+                    continue;
+                }
+
+                const auto it = m_sharedBufferIndices.find(data);
+                if (it != m_sharedBufferIndices.end())
+                {
+                    auto& buffer = m_clone.m_buffers[it->second];
+                    buffer = std::make_shared<Buffer>(*buffer);
+                }
+            }
+        }
+
+        Node Serialize(Napi::Value value)
+        {
+            Node node{};
+            if (value.IsUndefined())
+            {
+                node.NodeType = Type::Undefined;
+            }
+            else if (value.IsNull())
+            {
+                node.NodeType = Type::Null;
+            }
+            else if (value.IsBoolean())
+            {
+                node.NodeType = Type::Boolean;
+                node.Boolean = value.As<Napi::Boolean>().Value();
+            }
+            else if (value.IsNumber())
+            {
+                node.NodeType = Type::Number;
+                node.Number = value.As<Napi::Number>().DoubleValue();
+            }
+            else if (value.IsString())
+            {
+                node.NodeType = Type::String;
+                node.String = value.As<Napi::String>().Utf8Value();
+            }
+            else if (value.IsArrayBuffer())
+            {
+                node.NodeType = Type::ArrayBuffer;
+                node.BufferIndex = AddBuffer(value.As<Napi::ArrayBuffer>());
+            }
+            else if (value.IsTypedArray())
+            {
+                const auto typedArray = value.As<Napi::TypedArray>();
+                node.NodeType = Type::TypedArray;
+                node.BufferIndex = AddBuffer(typedArray.ArrayBuffer());
+                node.ArrayType = typedArray.TypedArrayType();
+                node.ByteOffset = typedArray.ByteOffset();
+                node.ElementLength = typedArray.ElementLength();
+            }
+            else if (value.IsFunction() || !value.IsObject())
+            {
+                throw Napi::Error::New(value.Env(), std::string{DATA_CLONE_ERROR} + "Functions, symbols and big integers cannot be cloned.");
+            }
+            else
+            {
+                const auto object = value.As<Napi::Object>();
+                for (const auto& ancestor : m_ancestors)
+                {
+                    if (ancestor.StrictEquals(object))
+                    {
+                        throw Napi::Error::New(value.Env(), std::string{DATA_CLONE_ERROR} + "Cyclic objects cannot be cloned.");
+                    }
+                }
+
+                if (!value.IsArray())
+                {
+                    ThrowIfUnsupported(object);
+                }
+
+                m_ancestors.push_back(object);
+                if (value.IsArray())
+                {
+                    const auto array = value.As<Napi::Array>();
+                    node.NodeType = Type::Array;
+                    node.Children.reserve(array.Length());
+                    for (uint32_t index = 0; index < array.Length(); ++index)
+                    {
+                        node.Children.push_back(Serialize(array[index]));
+                    }
+                }
+                else
+                {
+                    const auto names = object.GetPropertyNames();
+                    node.NodeType = Type::Object;
+                    node.Children.reserve(names.Length());
+                    node.Keys.reserve(names.Length());
+                    for (uint32_t index = 0; index < names.Length(); ++index)
+                    {
+                        const Napi::Value name = names[index];
+                        node.Keys.push_back(name.ToString().Utf8Value());
+                        node.Children.push_back(Serialize(object.Get(name)));
+                    }
+                }
+                m_ancestors.pop_back();
+            }
+
+            return node;
+        }
+
+    private:
+        // Instances of classes are cloned as plain objects, as in browsers, but built-in objects whose
+        // contents are not properties are rejected.
+        void ThrowIfUnsupported(Napi::Object object) const
+        {
+            const auto tag = m_toString.Call(object, {}).As<Napi::String>().Utf8Value();
+            for (const auto* unsupportedTag : UNSUPPORTED_OBJECT_TAGS)
+            {
+                if (tag == unsupportedTag)
+                {
+                    // The tag is "[object <Type>]".
+                    const auto typeName = tag.substr(8, tag.size() - 9);
+                    throw Napi::Error::New(object.Env(), std::string{DATA_CLONE_ERROR} + typeName + " objects cannot be cloned.");
+                }
+            }
+        }
+
+        size_t AddBuffer(Napi::ArrayBuffer arrayBuffer)
+        {
+            const void* data = arrayBuffer.Data();
+            const auto it = m_bufferIndices.find(data);
+            if (it != m_bufferIndices.end())
+            {
+                return it->second;
+            }
+
+            std::shared_ptr<Buffer> buffer{};
+            if (m_transferred.count(data) != 0)
+            {
+                std::scoped_lock lock{s_externalBuffersMutex};
+                const auto external = s_externalBuffers.find(data);
+                if (external != s_externalBuffers.end())
+                {
+                    buffer = external->second.lock();
+                }
+            }
+
+            const size_t index = m_clone.m_buffers.size();
+            if (buffer == nullptr || buffer->size() != arrayBuffer.ByteLength())
+            {
+                const auto* bytes = static_cast<const uint8_t*>(data);
+                buffer = std::make_shared<Buffer>(bytes, bytes + arrayBuffer.ByteLength());
+            }
+            else
+            {
+                m_sharedBufferIndices.emplace(data, index);
+            }
+
+            m_clone.m_buffers.push_back(std::move(buffer));
+            m_bufferIndices.emplace(data, index);
+            return index;
+        }
+
+        StructuredClone& m_clone;
+        Napi::Function m_toString;
+        std::unordered_set<const void*> m_transferred{};
+        std::vector<Napi::ArrayBuffer> m_transferList{};
+        std::unordered_map<const void*, size_t> m_bufferIndices{};
+        // The buffers of the clone that share the memory of a transferred array buffer.
+        std::unordered_map<const void*, size_t> m_sharedBufferIndices{};
+        std::vector<Napi::Object> m_ancestors{};
+    };
+
+    StructuredClone StructuredClone::Serialize(Napi::Value value, Napi::Value transferList)
+    {
+        StructuredClone clone{};
+        Serializer serializer{clone, transferList};
+        clone.m_root = serializer.Serialize(value);
+        serializer.DetachTransferred();
+        return clone;
+    }
+
+    Napi::Value StructuredClone::Deserialize(Napi::Env env) const
+    {
+        std::vector<Napi::ArrayBuffer> buffers{};
+        buffers.reserve(m_buffers.size());
+        for (const auto& buffer : m_buffers)
+        {
+            buffers.push_back(CreateArrayBuffer(env, buffer));
+        }
+
+        return Deserialize(env, m_root, buffers);
+    }
+
+    Napi::ArrayBuffer StructuredClone::CreateArrayBuffer(Napi::Env env, const std::shared_ptr<Buffer>& buffer)
+    {
+        if (buffer->empty())
+        {
+            return Napi::ArrayBuffer::New(env, 0);
+        }
+
+        {
+            std::scoped_lock lock{s_externalBuffersMutex};
+            s_externalBuffers[buffer->data()] = buffer;
+        }
+
+        // The array buffer uses the memory of the clone in place and keeps it alive.
+        return Napi::ArrayBuffer::New(env, buffer->data(), buffer->size(), [](Napi::Env, void* data, std::shared_ptr<Buffer>* owner) {
+            delete owner;
+
+            std::scoped_lock lock{s_externalBuffersMutex};
+            const auto it = s_externalBuffers.find(data);
+            if (it != s_externalBuffers.end() && it->second.expired())
+            {
+                s_externalBuffers.erase(it);
+            }
+        },
+            new std::shared_ptr<Buffer>{buffer});
+    }
+
+    Napi::TypedArray StructuredClone::CreateTypedArray(Napi::Env env, napi_typedarray_type type, size_t length, Napi::ArrayBuffer buffer, size_t byteOffset)
+    {
+        switch (type)
+        {
+            case napi_int8_array:
+                return Napi::TypedArrayOf<int8_t>::New(env, length, buffer, byteOffset, type);
+            case napi_uint8_array:
+            case napi_uint8_clamped_array:
+                return Napi::TypedArrayOf<uint8_t>::New(env, length, buffer, byteOffset, type);
+            case napi_int16_array:
+                return Napi::TypedArrayOf<int16_t>::New(env, length, buffer, byteOffset, type);
+            case napi_uint16_array:
+                return Napi::TypedArrayOf<uint16_t>::New(env, length, buffer, byteOffset, type);
+            case napi_int32_array:
+                return Napi::TypedArrayOf<int32_t>::New(env, length, buffer, byteOffset, type);
+            case napi_uint32_array:
+                return Napi::TypedArrayOf<uint32_t>::New(env, length, buffer, byteOffset, type);
+            case napi_float32_array:
+                return Napi::TypedArrayOf<float>::New(env, length, buffer, byteOffset, type);
+            case napi_float64_array:
+                return Napi::TypedArrayOf<double>::New(env, length, buffer, byteOffset, type);
+            default:
+                throw Napi::Error::New(env, std::string{DATA_CLONE_ERROR} + "Unsupported typed array type.");
+        }
+    }
+
+    Napi::Value StructuredClone::Deserialize(Napi::Env env, const Node& node, std::vector<Napi::ArrayBuffer>& buffers) const
+    {
+        switch (node.NodeType)
+        {
+            case Type::Undefined:
+                return env.Undefined();
+            case Type::Null:
+                return env.Null();
+            case Type::Boolean:
+                return Napi::Boolean::New(env, node.Boolean);
+            case Type::Number:
+                return Napi::Number::New(env, node.Number);
+            case Type::String:
+                return Napi::String::New(env, node.String);
+            case Type::ArrayBuffer:
+                return buffers[node.BufferIndex];
+            case Type::TypedArray:
+                return CreateTypedArray(env, node.ArrayType, node.ElementLength, buffers[node.BufferIndex], node.ByteOffset);
+            case Type::Array:
+            {
+                auto array = Napi::Array::New(env, node.Children.size());
+                for (uint32_t index = 0; index < node.Children.size(); ++index)
+                {
+                    array.Set(index, Deserialize(env, node.Children[index], buffers));
+                }
+                return array;
+            }
+            case Type::Object:
+            {
+                auto object = Napi::Object::New(env);
+                for (size_t index = 0; index < node.Children.size(); ++index)
+                {
+                    object.Set(node.Keys[index], Deserialize(env, node.Children[index], buffers));
+                }
+                return object;
+            }
+        }
+
+        throw std::runtime_error{"Invalid structured clone node type."};
+    }
+}
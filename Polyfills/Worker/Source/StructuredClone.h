@@ -0,0 +1,76 @@
+#pragma once
+
+#include <napi/napi.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Babylon::Polyfills::Internal
+{
+    /// A JavaScript value copied out of one environment so that it can be recreated in another, possibly on
+    /// another thread. Only plain data can be cloned: primitives, arrays, objects with their enumerable
+    /// properties, array buffers and typed arrays. Other objects, such as instances of classes, are cloned as
+    /// plain objects with their enumerable properties, except for built-in objects like dates, maps and sets,
+    /// whose contents would be lost and which throw a DataCloneError instead. Objects referenced more than
+    /// once are cloned once per reference, except for array buffers, which keep their identity within a
+    /// clone.
+    ///
+    /// Array buffers in the transfer list are detached from the sender where the JavaScript engine allows it,
+    /// which with V8 is the case of every array buffer that was itself received in a message. Their memory
+    /// is then moved rather than copied. Other array buffers are copied once, into native memory that the
+    /// receiving environment then uses in place, and remain usable by the sender, so that two threads
+    /// never share the memory of an array buffer.
+    class StructuredClone final
+    {
+    public:
+        // Throws a JavaScript error for values that cannot be cloned.
+        static StructuredClone Serialize(Napi::Value value, Napi::Value transferList);
+
+        Napi::Value Deserialize(Napi::Env env) const;
+
+    private:
+        using Buffer = std::vector<uint8_t>;
+
+        enum class Type
+        {
+            Undefined,
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object,
+            ArrayBuffer,
+            TypedArray,
+        };
+
+        struct Node
+        {
+            Type NodeType{Type::Undefined};
+            bool Boolean{};
+            double Number{};
+            std::string String{};
+
+            // The elements of an array or the properties of an object, with the names of the latter.
+            std::vector<Node> Children{};
+            std::vector<std::string> Keys{};
+
+            // Array buffers and typed arrays refer to one of the buffers of the clone.
+            size_t BufferIndex{};
+            napi_typedarray_type ArrayType{};
+            size_t ByteOffset{};
+            size_t ElementLength{};
+        };
+
+        class Serializer;
+
+        static Napi::ArrayBuffer CreateArrayBuffer(Napi::Env env, const std::shared_ptr<Buffer>& buffer);
+        static Napi::TypedArray CreateTypedArray(Napi::Env env, napi_typedarray_type type, size_t length, Napi::ArrayBuffer buffer, size_t byteOffset);
+        Napi::Value Deserialize(Napi::Env env, const Node& node, std::vector<Napi::ArrayBuffer>& buffers) const;
+
+        Node m_root{};
+        std::vector<std::shared_ptr<Buffer>> m_buffers{};
+    };
+}
@@ -0,0 +1,334 @@
+#include "Worker.h"
+
+#include <Babylon/JsRuntime.h>
+#include <UrlLib/UrlLib.h>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+namespace Babylon::Polyfills::Internal
+{
+    namespace
+    {
+        constexpr auto JS_INITIALIZE_WORKER_NAME = "initializeWorker";
+        constexpr auto JS_POST_MESSAGE_NAME = "postMessage";
+        constexpr auto JS_TERMINATE_NAME = "terminate";
+        constexpr auto JS_SELF_NAME = "self";
+        constexpr auto JS_ON_MESSAGE_NAME = "onmessage";
+        constexpr auto JS_ON_ERROR_NAME = "onerror";
+        constexpr auto JS_DATA_NAME = "data";
+        constexpr auto JS_MESSAGE_NAME = "message";
+
+        // Destroys the runtimes of terminated workers, which waits for the script they are running to
+        // finish, on threads of their own rather than on the JavaScript thread that terminated them. The
+        // threads still running when the process exits are waited for then.
+        class RuntimeReaper final
+        {
+        public:
+            static void Destroy(std::unique_ptr<AppRuntime> runtime)
+            {
+                static RuntimeReaper reaper{};
+                reaper.Add(std::move(runtime));
+            }
+
+            ~RuntimeReaper()
+            {
+                for (auto& reaping : m_reapings)
+                {
+                    reaping.Thread.join();
+                }
+            }
+
+        private:
+            struct Reaping
+            {
+                std::thread Thread{};
+                std::shared_ptr<std::atomic<bool>> Done{};
+            };
+
+            void Add(std::unique_ptr<AppRuntime> runtime)
+            {
+                std::scoped_lock lock{m_mutex};
+
+                // The threads that are done only need to be joined, which does not block.
+                for (auto it = m_reapings.begin(); it != m_reapings.end();)
+                {
+                    if (*it->Done)
+                    {
+                        it->Thread.join();
+                        it = m_reapings.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+
+                auto done = std::make_shared<std::atomic<bool>>(false);
+                std::thread thread{[runtime = std::move(runtime), done]() mutable {
+                    runtime.reset();
+                    *done = true;
+                }};
+                m_reapings.push_back({std::move(thread), std::move(done)});
+            }
+
+            std::mutex m_mutex{};
+            std::vector<Reaping> m_reapings{};
+        };
+    }
+
+    void Worker::Channel::DispatchToParent(std::function<void(Napi::Env)> function)
+    {
+        std::scoped_lock lock{ParentRuntimeMutex};
+        if (ParentRuntime != nullptr)
+        {
+            ParentRuntime->Dispatch(std::move(function));
+        }
+    }
+
+    void Worker::Channel::DispatchToWorker(std::function<void(Napi::Env)> function)
+    {
+        std::scoped_lock lock{WorkerRuntimeMutex};
+        if (WorkerRuntime != nullptr)
+        {
+            WorkerRuntime->Dispatch(std::move(function));
+        }
+    }
+
+    void Worker::Initialize(Napi::Env env, Babylon::Polyfills::Worker::InitializeFunctionT initializeWorker)
+    {
+        Napi::HandleScope scope{env};
+
+        // Workers created in this environment find the host's initialization function here.
+        auto* initialize = new Babylon::Polyfills::Worker::InitializeFunctionT{std::move(initializeWorker)};
+        JsRuntime::NativeObject::GetFromJavaScript(env).Set(JS_INITIALIZE_WORKER_NAME,
+            Napi::External<Babylon::Polyfills::Worker::InitializeFunctionT>::New(env, initialize, [](Napi::Env, Babylon::Polyfills::Worker::InitializeFunctionT* function) {
+                delete function;
+            }));
+
+        Napi::Function constructor = DefineClass(
+            env,
+            JS_CONSTRUCTOR_NAME,
+            {
+                InstanceMethod(JS_POST_MESSAGE_NAME, &Worker::PostMessage),
+                InstanceMethod(JS_TERMINATE_NAME, &Worker::Terminate),
+            });
+
+        if (env.Global().Get(JS_CONSTRUCTOR_NAME).IsUndefined())
+        {
+            env.Global().Set(JS_CONSTRUCTOR_NAME, constructor);
+        }
+    }
+
+    Worker::Worker(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<Worker>{info}
+        , m_channel{std::make_shared<Channel>(JsRuntime::GetFromJavaScript(info.Env()))}
+    {
+        const auto url = info[0].As<Napi::String>().Utf8Value();
+        auto initializeWorker = *JsRuntime::NativeObject::GetFromJavaScript(info.Env())
+                                     .Get(JS_INITIALIZE_WORKER_NAME)
+                                     .As<Napi::External<Babylon::Polyfills::Worker::InitializeFunctionT>>()
+                                     .Data();
+
+        m_channel->Parent = this;
+
+        // Errors that the worker does not handle are reported to the worker object.
+        m_workerRuntime = std::make_unique<AppRuntime>([channel = m_channel](std::exception_ptr exception) {
+            ReportError(channel, GetErrorMessage(exception));
+        });
+        m_channel->WorkerRuntime = m_workerRuntime.get();
+
+        m_channel->DispatchToWorker([channel = m_channel, initializeWorker = std::move(initializeWorker)](Napi::Env env) {
+            if (initializeWorker)
+            {
+                initializeWorker(env);
+            }
+
+            InitializeScope(env, channel);
+        });
+
+        // The worker script runs on the worker's thread once it has been fetched. The messages that arrive
+        // while it loads are delivered once it has run, and a script that cannot be fetched is reported to
+        // the worker object.
+        UrlLib::UrlRequest request{};
+        request.Open(UrlLib::UrlMethod::Get, url);
+        request.ResponseType(UrlLib::UrlResponseType::String);
+        request.SendAsync().then(arcana::inline_scheduler, arcana::cancellation::none(), [channel = m_channel, request, url](arcana::expected<void, std::exception_ptr> result) {
+            if (result.has_error() || request.StatusCode() != UrlLib::UrlStatusCode::Ok)
+            {
+                ReportError(channel, "Failed to load worker script " + url);
+                return;
+            }
+
+            channel->DispatchToWorker([channel, request, url](Napi::Env env) {
+                try
+                {
+                    Napi::Eval(env, request.ResponseString().data(), url.data());
+                }
+                catch (...)
+                {
+                    StartScope(env, *channel);
+                    throw;
+                }
+
+                StartScope(env, *channel);
+            });
+        });
+    }
+
+    Worker::~Worker()
+    {
+        Stop();
+    }
+
+    void Worker::PostMessage(const Napi::CallbackInfo& info)
+    {
+        auto message = StructuredClone::Serialize(info[0], info[1]);
+        m_channel->DispatchToWorker([channel = m_channel, message = std::move(message)](Napi::Env env) {
+            ReceiveMessage(env, *channel, message);
+        });
+    }
+
+    void Worker::Terminate(const Napi::CallbackInfo& /*info*/)
+    {
+        Stop();
+    }
+
+    void Worker::Stop()
+    {
+        if (m_workerRuntime == nullptr)
+        {
+            return;
+        }
+
+        // Messages and errors the worker sent before it stopped are no longer delivered.
+        m_channel->Parent = nullptr;
+        {
+            std::scoped_lock lock{m_channel->ParentRuntimeMutex};
+            m_channel->ParentRuntime = nullptr;
+        }
+        {
+            std::scoped_lock lock{m_channel->WorkerRuntimeMutex};
+            m_channel->WorkerRuntime = nullptr;
+        }
+
+        // The work the worker is running finishes on its own thread and work still queued is dropped, without
+        // blocking this thread.
+        RuntimeReaper::Destroy(std::move(m_workerRuntime));
+    }
+
+    void Worker::DispatchEvent(const char* handlerName, Napi::Object event)
+    {
+        const auto handler = Value().Get(handlerName);
+        if (handler.IsFunction())
+        {
+            handler.As<Napi::Function>().Call(Value(), {event});
+        }
+    }
+
+    void Worker::ReportError(const std::shared_ptr<Channel>& channel, std::string message)
+    {
+        channel->DispatchToParent([channel, message = std::move(message)](Napi::Env env) {
+            if (channel->Parent != nullptr)
+            {
+                auto event = Napi::Object::New(env);
+                event.Set(JS_MESSAGE_NAME, message);
+                channel->Parent->DispatchEvent(JS_ON_ERROR_NAME, event);
+            }
+        });
+    }
+
+    void Worker::InitializeScope(Napi::Env env, std::shared_ptr<Channel> channel)
+    {
+        auto global = env.Global();
+        global.Set(JS_SELF_NAME, global);
+        global.Set(JS_POST_MESSAGE_NAME, Napi::Function::New(env, [channel](const Napi::CallbackInfo& info) {
+            auto message = StructuredClone::Serialize(info[0], info[1]);
+            channel->DispatchToParent([channel, message = std::move(message)](Napi::Env env) {
+                if (channel->Parent != nullptr)
+                {
+                    channel->Parent->DispatchEvent(JS_ON_MESSAGE_NAME, CreateMessageEvent(env, message));
+                }
+            });
+        }, JS_POST_MESSAGE_NAME));
+    }
+
+    void Worker::StartScope(Napi::Env env, Channel& channel)
+    {
+        channel.Started = true;
+
+        // Every pending message is delivered even if a handler throws, the first error is then reported.
+        std::exception_ptr exception{};
+        for (const auto& message : std::exchange(channel.PendingMessages, {}))
+        {
+            try
+            {
+                ReceiveMessage(env, channel, message);
+            }
+            catch (...)
+            {
+                if (exception == nullptr)
+                {
+                    exception = std::current_exception();
+                }
+            }
+        }
+
+        if (exception != nullptr)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void Worker::ReceiveMessage(Napi::Env env, Channel& channel, const StructuredClone& message)
+    {
+        if (!channel.Started)
+        {
+            channel.PendingMessages.push_back(message);
+            return;
+        }
+
+        auto global = env.Global();
+        const auto handler = global.Get(JS_ON_MESSAGE_NAME);
+        if (handler.IsFunction())
+        {
+            handler.As<Napi::Function>().Call(global, {CreateMessageEvent(env, message)});
+        }
+    }
+
+    Napi::Object Worker::CreateMessageEvent(Napi::Env env, const StructuredClone& message)
+    {
+        auto event = Napi::Object::New(env);
+        event.Set(JS_DATA_NAME, message.Deserialize(env));
+        return event;
+    }
+
+    std::string Worker::GetErrorMessage(std::exception_ptr exception)
+    {
+        try
+        {
+            std::rethrow_exception(exception);
+        }
+        catch (const Napi::Error& error)
+        {
+            return error.Message();
+        }
+        catch (const std::exception& error)
+        {
+            return error.what();
+        }
+        catch (...)
+        {
+            return "Unknown error";
+        }
+    }
+}
+
+namespace Babylon::Polyfills::Worker
+{
+    void Initialize(Napi::Env env, InitializeFunctionT initializeWorker)
+    {
+        Internal::Worker::Initialize(env, std::move(initializeWorker));
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "StructuredClone.h"
+
+#include <Babylon/AppRuntime.h>
+#include <Babylon/Polyfills/Worker.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Babylon::Polyfills::Internal
+{
+    /// A Web Worker: a script running in a JavaScript environment of its own, on a thread of its own, that
+    /// exchanges messages with the environment that created it. The worker is terminated when terminate is
+    /// called or once the worker object is garbage collected, so keep a reference to it for as long as it
+    /// should run.
+    class Worker final : public Napi::ObjectWrap<Worker>
+    {
+        static constexpr auto JS_CONSTRUCTOR_NAME = "Worker";
+
+    public:
+        static void Initialize(Napi::Env env, Babylon::Polyfills::Worker::InitializeFunctionT initializeWorker);
+
+        explicit Worker(const Napi::CallbackInfo& info);
+        ~Worker();
+
+    private:
+        // Shared by the worker object, on the thread that created it, and the worker's own thread.
+        struct Channel
+        {
+            explicit Channel(JsRuntime& parentRuntime)
+                : ParentRuntime{&parentRuntime}
+            {
+            }
+
+            void DispatchToParent(std::function<void(Napi::Env)> function);
+            void DispatchToWorker(std::function<void(Napi::Env)> function);
+
+            // Reset when the worker is terminated. The worker may still be running then, and the environment
+            // that created it may be gone before the worker has stopped.
+            std::mutex ParentRuntimeMutex{};
+            JsRuntime* ParentRuntime{};
+
+            // Only accessed from the thread that created the worker, reset once the worker object is gone.
+            Worker* Parent{};
+
+            // Reset when the worker is terminated, after which work for it is dropped.
+            std::mutex WorkerRuntimeMutex{};
+            AppRuntime* WorkerRuntime{};
+
+            // Only accessed from the worker's thread. Messages that arrive before the worker script has run
+            // wait until it has, so that it can install its message handler first.
+            bool Started{};
+            std::vector<StructuredClone> PendingMessages{};
+        };
+
+        void PostMessage(const Napi::CallbackInfo& info);
+        void Terminate(const Napi::CallbackInfo& info);
+        void Stop();
+        void DispatchEvent(const char* handlerName, Napi::Object event);
+
+        // Dispatches an error event to the worker object, unless it is gone. Thread safe.
+        static void ReportError(const std::shared_ptr<Channel>& channel, std::string message);
+        static void InitializeScope(Napi::Env env, std::shared_ptr<Channel> channel);
+        static void StartScope(Napi::Env env, Channel& channel);
+        static void ReceiveMessage(Napi::Env env, Channel& channel, const StructuredClone& message);
+        static Napi::Object CreateMessageEvent(Napi::Env env, const StructuredClone& message);
+        static std::string GetErrorMessage(std::exception_ptr exception);
+
+        std::shared_ptr<Channel> m_channel{};
+        std::unique_ptr<AppRuntime> m_workerRuntime{};
+    };
+}